@@ -39,8 +39,12 @@ bool App::Init()
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
         glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
-        // Create GLFW window
+        // Create GLFW window, with a 4.5 context where 4.6 is not available (e.g. Mesa llvmpipe), the shaders need 4.5
         window = glfwCreateWindow(window_width, window_height, "PG2", nullptr, nullptr);
+        if (!window) {
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+            window = glfwCreateWindow(window_width, window_height, "PG2", nullptr, nullptr);
+        }
         if (!window) {
             std::cerr << "Failed to create GLFW window\n";
             glfwTerminate();
@@ -100,9 +104,9 @@ bool App::Init()
         glEnable(GL_CULL_FACE);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        // Initialize scene
-        InitScene();
+        // Show the window right away, the scene is loaded in the background
         glfwShowWindow(window);
+        InitScene();
 
         std::cout << "Initialized\n";
         return true;
@@ -140,6 +144,7 @@ int App::Run(void) {
 
         // Initialize camera position and movement
         camera.position = { 1.0f, 1.0f, 1.0f };
+        player.Teleport(camera.position - glm::vec3(0.0f, PLAYER_HEIGHT, 0.0f));
         glm::vec3 camera_movement{};
 
 
@@ -149,10 +154,6 @@ int App::Run(void) {
         const double walkingDelay = 0.4;
         const double sprintingDelay = 0.2;
 
-        float fallingSpeed = 0;
-        float jumpingSpeed = 0;
-        bool isGrounded = true;
-
 
         // Main loop
         while (!glfwWindowShouldClose(window)) {
@@ -160,6 +161,9 @@ int App::Run(void) {
             currentFrameTime = glfwGetTime();
             auto fps_frame_start_timestamp = std::chrono::steady_clock::now();
 
+            // Upload assets that finished loading, objects appear as they become ready
+            assets.ProcessUploads(ASSET_UPLOAD_BUDGET);
+
             // Clear buffers
             glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -168,27 +172,7 @@ int App::Run(void) {
             float delta_time = static_cast<float>(currentFrameTime - lastFrameTime);
             lastFrameTime = currentFrameTime;
 
-            // Process camera input
-            camera_movement = camera.ProcessInput(window, delta_time);
-            camera.position += glm::vec3(camera_movement.x, 0.0f, camera_movement.z);
-
-            bool is_space_pressed = (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS);
-            auto heightmap_y = GetHeightmapY(camera.position.x, camera.position.z);
-            float min_height = heightmap_y + PLAYER_HEIGHT;
-
-            // Handle walking and sprinting
-            if ((camera_movement.x != 0 || camera_movement.z != 0) && isGrounded) {
-                if ((!camera.sprint && currentFrameTime > lastWalkTime + walkingDelay) ||
-                    (camera.sprint && currentFrameTime > lastWalkTime + sprintingDelay)) {
-                    audio.PlayWalk();
-                    lastWalkTime = currentFrameTime;
-                }
-            }
-            else {
-                lastWalkTime = currentFrameTime;
-            }
-
-            // Handle mouselook
+            // Handle mouselook, every frame so that looking around stays as smooth as the frame rate
             if (mouselook_enabled) {
                 glfwGetCursorPos(window, &cursor_x, &cursor_y);
                 camera.ProcessMouseMovement(static_cast<GLfloat>(window_width / 2.0 - cursor_x),
@@ -196,82 +180,85 @@ int App::Run(void) {
                 glfwSetCursorPos(window, window_width / 2.0, window_height / 2.0);
             }
 
-            // Handle jumping and falling
-            if (is_space_pressed && isGrounded) {
-                jumpingSpeed = 5.0f;
-                audio.PlayJump();
-            }
-
-            if (jumpingSpeed > 0.0f) {
-                fallingSpeed = 0;
-                jumpingSpeed -= delta_time * 9.81f;
-                camera.position.y += delta_time * jumpingSpeed;
-                if (camera.position.y < min_height) {
-                    camera.position.y = min_height;
-                }
-                isGrounded = false;
-            }
-            else {
-                fallingSpeed += delta_time * 9.81f;
-                camera.position.y -= delta_time * fallingSpeed;
-                if (camera.position.y < min_height) {
-                    camera.position.y = min_height;
-                    fallingSpeed = 0;
-                    if (!isGrounded) {
-                        audio.PlayLand();
+            // Simulate in fixed steps, as many as the frame took; after a long stall the rest is dropped
+            simulation_lag += delta_time;
+            int simulation_steps = 0;
+            while (simulation_lag >= SIMULATION_STEP && simulation_steps < SIMULATION_MAX_STEPS) {
+                SaveSimulationState();
+
+                // Process camera input, the player walks where the camera would move
+                camera_movement = camera.ProcessInput(window, SIMULATION_STEP);
+                bool is_space_pressed = (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS);
+
+                // Handle walking and sprinting
+                if ((camera_movement.x != 0 || camera_movement.z != 0) && player.IsGrounded()) {
+                    if ((!camera.sprint && currentFrameTime > lastWalkTime + walkingDelay) ||
+                        (camera.sprint && currentFrameTime > lastWalkTime + sprintingDelay)) {
+                        audio.PlayWalk();
+                        lastWalkTime = currentFrameTime;
                     }
-                    isGrounded = true;
                 }
-                else if (isGrounded && camera.position.y - min_height > 1.0f) {
-                    isGrounded = false;
+                else {
+                    lastWalkTime = currentFrameTime;
                 }
-            }
 
-            // Update view matrix
-            glm::mat4 mx_view = camera.GetViewMatrix();
-            UpdateModel(delta_time);
-            UpdateProjectiles(delta_time);
+                // Handle jumping and falling, the camera is at the top of the player's capsule
+                const bool was_grounded = player.IsGrounded();
+                if (is_space_pressed && was_grounded) {
+                    audio.PlayJump();
+                }
+                player.Move(glm::vec3(camera_movement.x, 0.0f, camera_movement.z), is_space_pressed ? PLAYER_JUMP_SPEED : 0.0f, SIMULATION_STEP);
+                if (player.IsGrounded() && !was_grounded) {
+                    audio.PlayLand();
+                }
+                camera.position = player.Feet() + glm::vec3(0.0f, PLAYER_HEIGHT, 0.0f);
 
-            // Activate shader program and set uniforms
-            my_shader.Activate();
+                UpdateModel(SIMULATION_STEP);
+                UpdatePendingCollisionBounds();
+                UpdateProjectiles(SIMULATION_STEP);
+                UpdatePhysics(SIMULATION_STEP);
 
+                simulation_lag -= SIMULATION_STEP;
+                simulation_steps++;
+            }
+            if (simulation_steps == SIMULATION_MAX_STEPS)
+                simulation_lag = std::min(simulation_lag, SIMULATION_STEP);
 
-            my_shader.SetUniform("u_mx_view", mx_view);
-            my_shader.SetUniform("u_mx_projection", mx_projection);
+            // Draw between the last two simulated states, the frame lies this far past the older one
+            const float simulation_alpha = simulation_lag / SIMULATION_STEP;
+            view_position = glm::mix(previous_camera_position, camera.position, simulation_alpha);
+            Camera view_camera = camera;
+            view_camera.position = view_position;
 
-            // Activate shader program and set uniforms
-            my_shader.Activate();
-            my_shader.SetUniform("u_mx_view", mx_view);
-            my_shader.SetUniform("u_mx_projection", mx_projection);
-            // Ambient light
-            my_shader.SetUniform("u_ambient_alpha", 0.0f);
-            my_shader.SetUniform("u_diffuse_alpha", 0.7f);
-            my_shader.SetUniform("u_camera_position", camera.position);
-            // Material
-            my_shader.SetUniform("u_material.shininess", 50.0f);
-            my_shader.SetUniform("u_material.specular", glm::vec3(0.5f));
-            my_shader.SetUniform("u_material.ambient", glm::vec3(0.4f));
-            // Directional light
-            my_shader.SetUniform("u_directional_light.specular", glm::vec3(0.2f));
-            my_shader.SetUniform("u_directional_light.diffuse", glm::vec3(0.7f));
-            my_shader.SetUniform("u_directional_light.direction", glm::vec3(0.0f, -0.9f, -0.5f));
-            // Reflector
-            my_shader.SetUniform("u_spotlight.diffuse", glm::vec3(light_intensity));
-            my_shader.SetUniform("u_spotlight.specular", glm::vec3(0.8f));
-            my_shader.SetUniform("u_spotlight.position", camera.position);
-            my_shader.SetUniform("u_spotlight.direction", camera.front);
-            my_shader.SetUniform("u_spotlight.constant", 1.5f);
-            my_shader.SetUniform("u_spotlight.linear", 0.1f);
-            my_shader.SetUniform("u_spotlight.exponent", 0.05f);
-            my_shader.SetUniform("u_spotlight.cos_inner_cone", glm::cos(glm::radians(20.0f)));
-            my_shader.SetUniform("u_spotlight.cos_outer_cone", glm::cos(glm::radians(27.0f)));
-            my_shader.SetUniform("u_spotlight.on", true);
+            // Update view matrix
+            glm::mat4 mx_view = view_camera.GetViewMatrix();
+            UpdateSceneTree(mx_projection * mx_view);
 
+            // Level of detail by projected size, pixels per unit at distance 1
+            const float lod_projection_scale = window_height / (2.0f * glm::tan(glm::radians(FOV) / 2.0f));
 
+            // Terrain first, it covers most of the screen
+            terrain.Stream(view_position);
+            if (terrain_renderer == TerrainRenderer::Tessellation) {
+                SetSceneUniforms(terrain_tessellation_shader, mx_view);
+                terrain.DrawTessellated(terrain_tessellation_shader, lod_projection_scale);
+            }
+            else {
+                SetSceneUniforms(terrain_shader, mx_view);
+                terrain.Update(view_position, mx_projection * mx_view);
+                terrain.Draw(terrain_shader);
+            }
+
+            // Activate shader program and set uniforms
+            SetSceneUniforms(my_shader, mx_view);
+            my_shader.SetUniform("u_terrain", 0);
 
             // Draw opaque objects
             for (auto& [key, value] : opaque_scene) {
-                value->Draw(my_shader);
+                if (!value->in_view)
+                    continue;
+                value->UpdateLod(view_position, lod_projection_scale);
+                value->Draw(my_shader, simulation_alpha);
             }
 
             // Handle transparent objects
@@ -281,7 +268,7 @@ int App::Run(void) {
 
             // Sort transparent objects
             for (auto& transparent_pair : transparent_scene_pairs) {
-                transparent_pair->second->distance_from_camera = glm::length(camera.position - transparent_pair->second->position);
+                transparent_pair->second->distance_from_camera = glm::length(view_position - transparent_pair->second->position);
             }
 
             std::sort(transparent_scene_pairs.begin(), transparent_scene_pairs.end(),
@@ -291,7 +278,10 @@ int App::Run(void) {
 
             // Draw transparent objects
             for (auto& transparent_pair : transparent_scene_pairs) {
-                transparent_pair->second->Draw(my_shader);
+                if (!transparent_pair->second->in_view)
+                    continue;
+                transparent_pair->second->UpdateLod(view_position, lod_projection_scale);
+                transparent_pair->second->Draw(my_shader, simulation_alpha);
             }
 
             // Reset OpenGL state
@@ -314,11 +304,22 @@ int App::Run(void) {
                 FPS = fpsCounterFrames;
                 fpsCounterSeconds = 0;
                 fpsCounterFrames = 0;
+
+                // Broadphase efficiency, too many candidates call for smaller cells, too many visited cells for larger ones
+                const auto& grid_stats = collision_grid.Stats();
+                collision_candidates_per_query = grid_stats.queries ? static_cast<float>(grid_stats.candidates) / grid_stats.queries : 0.0f;
+                collision_grid.ResetStats();
             }
 
             // Set window title with FPS
             std::stringstream ss;
-            ss << FPS << " FPS";
+            ss << FPS << " FPS, " << TerrainRendererName(terrain_renderer) << " terrain, "
+                << terrain.ResidentTiles() << "/" << terrain.TileSlots() << " tiles, "
+                << collision_candidates_per_query << " collision candidates per query, "
+                << objects_in_view << "/" << scene_tree.ProxyCount() << " objects in view, "
+                << physics.AwakeCount() << "/" << physics.BodyCount() << " bodies awake";
+            if (terrain_renderer == TerrainRenderer::Cdlod)
+                ss << " " << terrain.DrawnNodes() << " nodes, " << terrain.DrawnTriangles() << " triangles";
             glfwSetWindowTitle(window, ss.str().c_str());
         }
     }
@@ -355,6 +356,10 @@ int App::Run(void) {
 App::~App()
 {
     my_shader.Clear();
+    terrain_shader.Clear();
+    if (terrain_tessellation_supported)
+        terrain_tessellation_shader.Clear();
+    terrain.Clear();
 
     if (window) {
         glfwDestroyWindow(window);
@@ -365,6 +370,37 @@ App::~App()
     std::cout << "Bye...\n";
 }
 
+// Activate a scene shader and set the per-frame camera and light uniforms
+void App::SetSceneUniforms(ShaderProgram& shader, const glm::mat4& mx_view)
+{
+    shader.Activate();
+    shader.SetUniform("u_mx_view", mx_view);
+    shader.SetUniform("u_mx_projection", mx_projection);
+    // Ambient light
+    shader.SetUniform("u_ambient_alpha", 0.0f);
+    shader.SetUniform("u_diffuse_alpha", 0.7f);
+    shader.SetUniform("u_camera_position", view_position);
+    // Material
+    shader.SetUniform("u_material.shininess", 50.0f);
+    shader.SetUniform("u_material.specular", glm::vec3(0.5f));
+    shader.SetUniform("u_material.ambient", glm::vec3(0.4f));
+    // Directional light
+    shader.SetUniform("u_directional_light.specular", glm::vec3(0.2f));
+    shader.SetUniform("u_directional_light.diffuse", glm::vec3(0.7f));
+    shader.SetUniform("u_directional_light.direction", glm::vec3(0.0f, -0.9f, -0.5f));
+    // Reflector
+    shader.SetUniform("u_spotlight.diffuse", glm::vec3(light_intensity));
+    shader.SetUniform("u_spotlight.specular", glm::vec3(0.8f));
+    shader.SetUniform("u_spotlight.position", view_position);
+    shader.SetUniform("u_spotlight.direction", camera.front);
+    shader.SetUniform("u_spotlight.constant", 1.5f);
+    shader.SetUniform("u_spotlight.linear", 0.1f);
+    shader.SetUniform("u_spotlight.exponent", 0.05f);
+    shader.SetUniform("u_spotlight.cos_inner_cone", glm::cos(glm::radians(20.0f)));
+    shader.SetUniform("u_spotlight.cos_outer_cone", glm::cos(glm::radians(27.0f)));
+    shader.SetUniform("u_spotlight.on", true);
+}
+
 // Update the projection matrix based on window dimensions
 void App::UpdateProjection() {
     const float minWindowHeight = 1.0f;
@@ -7,17 +7,34 @@
 #include <utility>
 
 // Project-specific includes
+#include "AssetManager.hpp"
+#include "CharacterController.hpp"
+#include "CollisionShapes.hpp"
+#include "DynamicAabbTree.hpp"
 #include "Obj.hpp"
+#include "PhysicsWorld.hpp"
 #include "ShaderProgram.hpp"
+#include "SpatialHashGrid.hpp"
+#include "Terrain.hpp"
 #include "Camera.hpp"
 #include "Audio.hpp"
 
 // Constants used in the application
 constexpr float PLAYER_HEIGHT = 1.0f; // Height of the player in the game world
+constexpr float PLAYER_RADIUS = 0.25f; // Radius of the player's collision capsule
+constexpr float PLAYER_JUMP_SPEED = 5.0f; // Upwards speed at the start of a jump
 constexpr float HEIGHTMAP_SHIFT = 50.0f; // Offset for the heightmap
+constexpr float HEIGHTMAP_SCALE = 0.1f; // World units per heightmap sample and per sample value
 constexpr int PROJECTILES_COUNT = 10; // Maximum number of projectiles
 constexpr bool USE_HIDE_CUBES = true; // Flag to determine if hide cubes are used
 constexpr float SPHERE_HIDE_DISTANCE = 30.0f; // Distance at which spheres become hidden
+constexpr float COLLISION_GRID_CELL_SIZE = 2.0f; // Edge of a collision broadphase cell, see the candidates per query in the title
+constexpr float PICK_DISTANCE = 500.0f; // Reach of the right click pick
+constexpr float SIMULATION_STEP = 1.0f / 60.0f; // Fixed step of the game simulation, independent of the frame rate
+constexpr int SIMULATION_MAX_STEPS = 8; // Steps per frame at most, after a longer stall the game slows down instead of catching up
+constexpr float BOX_MASS = 1.0f; // Mass of each pyramid box
+constexpr float PROJECTILE_MASS = 0.5f; // Mass whose momentum a projectile hands to the rigid body it hits
+constexpr double ASSET_UPLOAD_BUDGET = 0.004; // Seconds per frame spent uploading loaded assets to the GPU
 
 // Main application class
 class App {
@@ -31,7 +48,8 @@ public:
 
     // Creates a new model in the scene
     Obj* CreateModel(const std::string& name, const std::string& obj, const std::string& tex, bool is_opaque,
-        const glm::vec3& position, float scale, const glm::vec4& rotation, bool collision, bool use_aabb);
+        const glm::vec3& position, float scale, const glm::vec4& rotation, bool collision, bool use_aabb,
+        BoundingSphereMethod sphere_method = BoundingSphereMethod::Auto);
     void UpdateModel(float delta_time); // Updates the model with the given delta time
 
 private:
@@ -39,6 +57,10 @@ private:
     std::map<std::string, Obj*> opaque_scene; // Opaque objects in the scene
     std::map<std::string, Obj*> transparent_scene; // Transparent objects in the scene
     std::vector<std::pair<const std::string, Obj*>*> transparent_scene_pairs; // Pairs of transparent objects
+    DynamicAabbTree scene_tree; // World boxes of all scene objects, shared by culling and picking
+    int objects_in_view = 0; // Objects that passed the last frustum query
+    void UpdateSceneTree(const glm::mat4& mx_view_projection); // Refits the moved objects and marks the ones in the view frustum
+    Obj* PickObject(const glm::vec3& origin, const glm::vec3& direction, float max_distance, float& distance) const; // Closest object box along a ray, nullptr if none
 
     // Application settings
     bool vsync_enabled = false; // VSync setting
@@ -59,17 +81,43 @@ private:
     int FPS = 0; // Frames per second
     glm::mat4 mx_projection = glm::identity<glm::mat4>(); // Projection matrix
     Camera camera = Camera(glm::vec3(0, 0, 0)); // Camera object
+    glm::vec3 previous_camera_position{}; // Camera position before the last simulation step
+    glm::vec3 view_position{}; // Camera position drawn this frame, between the last two simulated ones
+    float simulation_lag = 0.0f; // Time not simulated yet, less than one step after each frame
+    float model_angle = 0.0f; // Rotation of the spheres in degrees, advanced by UpdateModel each simulation step
+    void SaveSimulationState(); // Start of a simulation step, frames are drawn between this state and the next
+    CharacterController player{ PLAYER_HEIGHT, PLAYER_RADIUS }; // Capsule from the player's feet to the camera, collides with the terrain and the collisions
 
     GLFWwindow* window = nullptr; // Pointer to the GLFW window
     glm::vec4 clear_color = glm::vec4(243.0f / 255.0f, 196.0f / 255.0f, 128.0f / 255.0f, 0.0f); // Clear color
 
     ShaderProgram my_shader; // Shader program object
+    ShaderProgram terrain_shader; // Terrain shader program, terrain.vert with the shared fragment shader
+    ShaderProgram terrain_tessellation_shader; // Tessellated terrain program, only valid when terrain_tessellation_supported
+    bool terrain_tessellation_supported = false; // Tessellation shaders compiled and linked
+    TerrainRenderer terrain_renderer = TerrainRenderer::Cdlod; // Terrain renderer, toggled with T
     Audio audio; // Audio object
+    AssetManager assets; // Meshes and textures shared between the scene objects
 
-    std::map<std::pair<float, float>, float>* _heights = nullptr; // Pointer to the heightmap
+    Terrain terrain; // Heightmap terrain, its heights are valid once it is ready
     float GetHeightmapY(float position_x, float position_z) const; // Gets the height at a specific position
+    void GetHeightmapY(const float* positions_x, const float* positions_z, float* heights, size_t count) const; // Same for many positions at once
 
     std::vector<Obj*> collisions; // List of objects involved in collisions
+    SpatialHashGrid collision_grid{ COLLISION_GRID_CELL_SIZE }; // Broadphase over collisions, entry ids are their indices
+    CollisionShapes collision_shapes; // Bounding box or sphere of each collision, drops the grid's candidates that miss a sweep's box
+    std::vector<Shape> collision_exact_shapes; // Fitted world shape of each collision, swept against by the remaining candidates
+    std::vector<int> collisions_without_bounds; // Registered by position only, their meshes are still loading
+    std::vector<int> collision_candidates; // Scratch for the grid queries
+    float collision_candidates_per_query = 0.0f; // Over the last second
+    void UpdateCollisionBounds(int id); // Re-registers collisions[id] in the grid, collision_shapes and collision_exact_shapes after it moved or finished loading
+    void UpdatePendingCollisionBounds(); // Registers the objects whose meshes have finished loading
+
+    PhysicsWorld physics; // Rigid bodies of the box pyramid, standing on the terrain
+    std::vector<int> collision_bodies; // Rigid body of each collision object, -1 for none
+    std::vector<int> body_collisions; // Collision object of each rigid body
+    std::vector<int> bodies_pending; // Collision objects that become rigid bodies once they and the terrain have loaded
+    void UpdatePhysics(float delta_time); // Creates the pending bodies, steps the simulation and moves the objects of the moved bodies
 
     const float projectile_speed = 10.0f; // Speed of projectiles
     Obj* projectiles[PROJECTILES_COUNT]{}; // Array of projectile objects
@@ -79,9 +127,10 @@ private:
 
     void Shoot(); // Shoots a projectile
     void UpdateProjectiles(float delta_time); // Updates the projectiles
-    bool CheckCollision(const glm::vec3& position); // Checks for collisions at a specific position
+    bool CheckCollision(const glm::vec3& from, const glm::vec3& to, float radius, SweepHit& hit); // Checks for collisions of a sphere moving from "from" to "to", hit is the first contact
 
     void UpdateProjection(); // Updates the projection matrix
+    void SetSceneUniforms(ShaderProgram& shader, const glm::mat4& mx_view); // Activates the shader, sets camera and lights
     static void error_callback(int error, const char* description); // GLFW error callback
     static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods); // GLFW key callback
     static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods); // GLFW mouse button callback
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "AssetManager.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "ObjParser.hpp"
+#include "Texture.hpp"
+#include "ThreadPool.hpp"
+
+MeshAsset::~MeshAsset()
+{
+    mesh.Clear();
+}
+
+void MeshAsset::Upload(MeshData& data, const PackedMeshData& packed)
+{
+    if (!packed.vertices.empty())
+        mesh = Mesh(GL_TRIANGLES, packed);
+    else
+        mesh = Mesh(GL_TRIANGLES, data.vertices, data.indices, data.lods);
+    bounds = data.bounds;
+    hull = data.hull;
+    ready = true;
+}
+
+TextureAsset::~TextureAsset()
+{
+    if (id != 0) {
+        glDeleteTextures(1, &id);
+    }
+}
+
+AssetManager::AssetManager() :
+    upload_queue(std::make_shared<UploadQueue>())
+{
+}
+
+std::string AssetManager::AssetKey(const std::filesystem::path& path)
+{
+    return path.lexically_normal().generic_string();
+}
+
+void AssetManager::StartLoad()
+{
+    if (pending_loads++ == 0) {
+        load_start_time = std::chrono::steady_clock::now();
+    }
+}
+
+std::shared_ptr<MeshAsset> AssetManager::GetMesh(const std::filesystem::path& path, BoundingSphereMethod sphere_method)
+{
+    // Objects asking for another sphere method get bounds of their own, and so a mesh of their own
+    auto& entry = meshes[AssetKey(path) + "#" + BoundingSphereMethodName(sphere_method)];
+    if (auto mesh = entry.lock()) {
+        return mesh;
+    }
+
+    auto mesh = LoadMesh([path, sphere_method](MeshData& data) { return LoadObjMeshData(path, sphere_method, data); });
+    entry = mesh;
+    return mesh;
+}
+
+void AssetManager::Load(std::function<std::function<void()>()> load)
+{
+    StartLoad();
+    ThreadPool::Shared().Submit([queue = upload_queue, load = std::move(load)]() {
+        // A failed load still queues an (empty) upload, so that the load is accounted for
+        std::function<void()> upload;
+        try {
+            upload = load();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "AssetManager: Load failed: " << e.what() << "\n";
+        }
+        if (!upload)
+            upload = []() {};
+
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->uploads.push_back(std::move(upload));
+    });
+}
+
+std::shared_ptr<MeshAsset> AssetManager::LoadMesh(std::function<bool(MeshData&)> build)
+{
+    auto mesh = std::make_shared<MeshAsset>();
+    std::weak_ptr<MeshAsset> weak_mesh = mesh;
+
+    Load([weak_mesh, build = std::move(build)]() -> std::function<void()> {
+        // A failed build still uploads an empty mesh, so that the asset becomes ready
+        auto data = std::make_shared<MeshData>();
+        auto packed = std::make_shared<PackedMeshData>();
+        try {
+            if (!build(*data))
+                *data = MeshData();
+            // Quantize here rather than in the upload, which runs on the GL thread
+            if (MESH_VERTEX_FORMAT == MeshVertexFormat::Packed)
+                PackMesh(*data, *packed);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "AssetManager: Mesh load failed: " << e.what() << "\n";
+            *data = MeshData();
+            *packed = PackedMeshData();
+        }
+
+        return [weak_mesh, data, packed]() {
+            if (auto mesh = weak_mesh.lock()) {
+                mesh->Upload(*data, *packed);
+            }
+        };
+    });
+    return mesh;
+}
+
+std::shared_ptr<TextureAsset> AssetManager::GetTexture(const std::filesystem::path& path)
+{
+    auto& entry = textures[AssetKey(path)];
+    if (auto texture = entry.lock()) {
+        return texture;
+    }
+
+    auto texture = std::make_shared<TextureAsset>();
+    std::weak_ptr<TextureAsset> weak_texture = texture;
+    entry = texture;
+
+    // Decode on a worker, upload (and compress) on the GL thread
+    Load([weak_texture, path]() -> std::function<void()> {
+        auto image = std::make_shared<cv::Mat>(cv::imread(path.string(), cv::IMREAD_UNCHANGED));
+
+        return [weak_texture, image, path]() {
+            auto texture = weak_texture.lock();
+            if (!texture)
+                return;
+            // A missing image leaves the texture unbound instead of stopping the game mid-frame
+            texture->ready = true;
+            if (image->empty()) {
+                std::cerr << "no texture: " << path << std::endl;
+                return;
+            }
+            texture->id = tex_gen(*image);
+        };
+    });
+    return texture;
+}
+
+void AssetManager::ProcessUploads(double budget_seconds)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        std::function<void()> upload;
+        {
+            std::lock_guard<std::mutex> lock(upload_queue->mutex);
+            if (upload_queue->uploads.empty())
+                break;
+            upload = std::move(upload_queue->uploads.front());
+            upload_queue->uploads.pop_front();
+        }
+
+        try {
+            upload();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "AssetManager: Upload failed: " << e.what() << "\n";
+        }
+
+        if (--pending_loads == 0) {
+            std::chrono::duration<double> load_seconds = std::chrono::steady_clock::now() - load_start_time;
+            std::cout << "AssetManager: All assets ready after " << load_seconds.count() * 1000.0 << " ms\n";
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budget_seconds)
+            break;
+    }
+}
+
+void AssetManager::PrintStatistics() const
+{
+    size_t mesh_count = 0, mesh_users = 0, texture_count = 0, texture_users = 0;
+    for (const auto& [key, mesh] : meshes) {
+        if (auto users = mesh.use_count()) {
+            std::cout << "AssetManager: Mesh " << key << " used by " << users << "\n";
+            mesh_count++;
+            mesh_users += users;
+        }
+    }
+    for (const auto& [key, texture] : textures) {
+        if (auto users = texture.use_count()) {
+            std::cout << "AssetManager: Texture " << key << " used by " << users << "\n";
+            texture_count++;
+            texture_users += users;
+        }
+    }
+    std::cout << "AssetManager: " << mesh_count << " meshes for " << mesh_users << " users, "
+        << texture_count << " textures for " << texture_users << " users\n";
+}
+
+namespace {
+
+void PrintVertexCacheStats(const std::filesystem::path& file_name, const MeshData& mesh_data)
+{
+    std::cout << "MeshOptimizer: " << file_name << " ACMR " << mesh_data.cache_before.acmr << " -> " << mesh_data.cache_after.acmr
+        << ", ATVR " << mesh_data.cache_before.atvr << " -> " << mesh_data.cache_after.atvr << "\n";
+    std::cout << "MeshSimplifier: " << file_name << " LOD triangles:";
+    for (const auto& lod : mesh_data.lods)
+        std::cout << " " << lod.index_count / 3 << " (error " << lod.error << ")";
+    std::cout << "\n";
+}
+
+// Convex hull of the given points, null for flat meshes
+std::shared_ptr<const ConvexHull> ComputeMeshHull(const glm::vec3* points, size_t count)
+{
+    auto hull = std::make_shared<ConvexHull>();
+    if (!ComputeConvexHull(points, count, *hull))
+        return nullptr;
+    return hull;
+}
+
+// Computes the bounding sphere, the axis-aligned box, the oriented box fitted to the hull and the
+// capsule of the given points and picks the collision shape of least volume; the hull where even that is much larger than the hull
+MeshBounds ComputeMeshBounds(const glm::vec3* points, size_t count, BoundingSphereMethod sphere_method, std::shared_ptr<const ConvexHull>& hull)
+{
+    MeshBounds bounds;
+    bounds.sphere_method = ResolveBoundingSphereMethod(sphere_method, count);
+    BoundingSphere sphere = ComputeBoundingSphere(points, count, bounds.sphere_method);
+    bounds.sphere_center = sphere.center;
+    bounds.sphere_radius = sphere.radius;
+    ComputeAabb(points, count, bounds.aabb_min, bounds.aabb_max);
+    hull = ComputeMeshHull(points, count);
+    bounds.box = ComputeBoundingBox(points, count, hull.get());
+    bounds.capsule = ComputeBoundingCapsule(points, count, bounds.box);
+
+    constexpr float pi = 3.14159265f;
+    const glm::vec3 extent = bounds.box.half_extents * 2.0f;
+    const float ball = 4.0f / 3.0f * pi * bounds.capsule.radius * bounds.capsule.radius * bounds.capsule.radius;
+    const float volumes[] = {
+        4.0f / 3.0f * pi * sphere.radius * sphere.radius * sphere.radius,
+        extent.x * extent.y * extent.z,
+        ball + pi * bounds.capsule.radius * bounds.capsule.radius * glm::distance(bounds.capsule.a, bounds.capsule.b),
+    };
+    const auto tightest = std::min_element(std::begin(volumes), std::end(volumes));
+    bounds.shape = static_cast<BoundingShape>(tightest - std::begin(volumes));
+
+    if (hull && *tightest > BOUNDING_SHAPE_HULL_RATIO * hull->volume)
+        bounds.shape = BoundingShape::Hull;
+    else
+        hull.reset();
+    return bounds;
+}
+
+} // namespace
+
+bool AssetManager::LoadObjMeshData(const std::filesystem::path& file_name, BoundingSphereMethod sphere_method, MeshData& mesh_data)
+{
+    auto load_start = std::chrono::steady_clock::now();
+
+    if (LoadMeshCache(file_name, sphere_method, mesh_data)) {
+        // The hull is not cached, it is built again from the vertices
+        if (mesh_data.bounds.shape == BoundingShape::Hull) {
+            std::vector<glm::vec3> positions(mesh_data.vertices.size());
+            for (size_t i = 0; i < positions.size(); i++)
+                positions[i] = mesh_data.vertices[i].position;
+            mesh_data.hull = ComputeMeshHull(positions.data(), positions.size());
+            if (!mesh_data.hull)
+                mesh_data.bounds.shape = BoundingShape::Box;
+        }
+        std::chrono::duration<double> load_seconds = std::chrono::steady_clock::now() - load_start;
+        std::cout << "LoadObj: Loaded cache: " << MeshCachePath(file_name, sphere_method) << " (" << load_seconds.count() * 1000.0 << " ms, "
+            << mesh_data.vertices.size() << " vertices, " << mesh_data.lods.size() << " LODs, "
+            << BoundingSphereMethodName(mesh_data.bounds.sphere_method) << " bounding sphere, "
+            << BoundingShapeName(mesh_data.bounds.shape) << " collision shape)\n";
+        PrintVertexCacheStats(file_name, mesh_data);
+        return true;
+    }
+
+    // Parse the file and measure parser throughput
+    ObjData obj_data;
+    if (!ParseObj(file_name, obj_data, OBJ_PARSER_MODE) || obj_data.positions.empty()) {
+        std::cerr << "LoadObj: No vertices in file: " << file_name << "\n";
+        return false;
+    }
+    std::chrono::duration<double> parse_seconds = std::chrono::steady_clock::now() - load_start;
+
+    // Build indexed vertex data, shared corners become one vertex
+    BuildIndexedMesh(obj_data, mesh_data.vertices, mesh_data.indices);
+    mesh_data.bounds = ComputeMeshBounds(obj_data.positions.data(), obj_data.positions.size(), sphere_method, mesh_data.hull);
+    // Reorder for the vertex cache, overdraw and fetch locality, the cache stores the optimized order
+    OptimizeMesh(mesh_data);
+    GenerateMeshLods(mesh_data);
+    SaveMeshCache(file_name, sphere_method, mesh_data);
+
+    // Print loaded file name and parser throughput
+    double file_megabytes = std::filesystem::file_size(file_name) / (1024.0 * 1024.0);
+    std::cout << "LoadObj: Loaded file: " << file_name << " (" << ObjParserModeName(OBJ_PARSER_MODE) << " parser, "
+        << file_megabytes << " MB in " << parse_seconds.count() * 1000.0 << " ms, "
+        << file_megabytes / std::max(parse_seconds.count(), 1e-9) << " MB/s, "
+        << obj_data.position_indices.size() << " corners -> " << mesh_data.vertices.size() << " unique vertices, "
+        << BoundingSphereMethodName(mesh_data.bounds.sphere_method) << " bounding sphere, "
+        << BoundingShapeName(mesh_data.bounds.shape) << " collision shape)\n";
+    PrintVertexCacheStats(file_name, mesh_data);
+    return true;
+}
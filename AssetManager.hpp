@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "PackedVertex.hpp"
+
+// Uploaded mesh shared by all objects using the same model file
+struct MeshAsset {
+    Mesh mesh;
+    MeshBounds bounds; // Model space bounds, objects scale them per instance
+    std::shared_ptr<const ConvexHull> hull; // Model space hull when bounds.shape is Hull
+    bool ready = false; // Set on the GL thread once the mesh is uploaded; mesh and bounds are invalid before
+
+    MeshAsset() = default;
+    ~MeshAsset(); // Releases the GL buffers
+
+    MeshAsset(const MeshAsset&) = delete;
+    MeshAsset& operator=(const MeshAsset&) = delete;
+
+    void Upload(MeshData& data, const PackedMeshData& packed); // GL thread only, packed is used when it has vertices
+};
+
+// GL texture shared by all objects using the same image file
+struct TextureAsset {
+    GLuint id{ 0 }; // 0 until uploaded, and for images that failed to load
+    bool ready = false; // Set on the GL thread once the texture is uploaded (or failed)
+
+    TextureAsset() = default;
+    ~TextureAsset(); // Deletes the texture
+
+    TextureAsset(const TextureAsset&) = delete;
+    TextureAsset& operator=(const TextureAsset&) = delete;
+};
+
+// Loads every model and texture file once and hands out shared, reference-counted handles
+// An asset is released when the last object holding it goes away; a later request loads it again
+//
+// Loading is asynchronous: files are parsed and images decoded on the shared thread pool, the
+// finished CPU side data is queued and uploaded by ProcessUploads() on the GL thread. Handles
+// are returned immediately and become ready once their upload has run.
+class AssetManager
+{
+public:
+    AssetManager();
+
+    // OBJ model, through the .pg2mesh cache
+    // Requests for the same file and sphere method share one mesh
+    std::shared_ptr<MeshAsset> GetMesh(const std::filesystem::path& path, BoundingSphereMethod sphere_method = BoundingSphereMethod::Auto);
+    std::shared_ptr<TextureAsset> GetTexture(const std::filesystem::path& path); // Image file
+    std::shared_ptr<MeshAsset> LoadMesh(std::function<bool(MeshData&)> build); // Unshared mesh built by a worker
+    // Runs load on a worker and the upload it returns (if any) on the GL thread, counted like the assets above
+    void Load(std::function<std::function<void()>()> load);
+
+    // Runs queued GL uploads until budget_seconds have passed (at least one), GL thread only
+    void ProcessUploads(double budget_seconds);
+    bool IsLoading() const { return pending_loads.load() > 0; }
+
+    void PrintStatistics() const; // Prints resident assets and how many users each has
+
+private:
+    // Shared with the worker tasks, which may finish after the manager is gone
+    struct UploadQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> uploads;
+    };
+    std::shared_ptr<UploadQueue> upload_queue;
+    std::atomic<int> pending_loads{ 0 }; // Loads queued on workers or waiting for upload
+    std::chrono::steady_clock::time_point load_start_time; // Start of the first load of the current batch
+
+    std::map<std::string, std::weak_ptr<MeshAsset>> meshes; // Key is the normalized path and the sphere method
+    std::map<std::string, std::weak_ptr<TextureAsset>> textures; // Key is the normalized path
+
+    void StartLoad();
+    static std::string AssetKey(const std::filesystem::path& path);
+    static bool LoadObjMeshData(const std::filesystem::path& path, BoundingSphereMethod sphere_method, MeshData& data); // Cache lookup, or parse + build + cache
+};
@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOUNDING_VOLUME_SSE2 1
+#include <emmintrin.h>
+#else
+#define BOUNDING_VOLUME_SSE2 0
+#endif
+
+#include "BoundingVolume.hpp"
+#include "ConvexHull.hpp"
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Points are read as packed float triples");
+
+namespace {
+
+// Sphere in double precision while it is being built
+struct Sphere {
+    glm::dvec3 center{};
+    double radius2 = -1.0; // Negative = empty
+
+    bool Contains(const glm::dvec3& p) const
+    {
+        glm::dvec3 d = p - center;
+        // Relative tolerance, points on the boundary must not trigger a rebuild through rounding
+        return glm::dot(d, d) <= radius2 * (1.0 + 1e-10) + 1e-12;
+    }
+};
+
+Sphere SphereFrom(const glm::dvec3& a)
+{
+    return { a, 0.0 };
+}
+
+Sphere SphereFrom(const glm::dvec3& a, const glm::dvec3& b)
+{
+    glm::dvec3 center = (a + b) * 0.5;
+    glm::dvec3 d = a - center;
+    return { center, glm::dot(d, d) };
+}
+
+// Circumscribed sphere of a triangle, centered in its plane
+Sphere SphereFrom(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c)
+{
+    glm::dvec3 ab = b - a, ac = c - a;
+    glm::dvec3 normal = glm::cross(ab, ac);
+    double denominator = 2.0 * glm::dot(normal, normal);
+    if (denominator < 1e-30) {
+        // Collinear: the two farthest apart points span the sphere
+        Sphere s = SphereFrom(a, b);
+        Sphere t = SphereFrom(a, c);
+        Sphere u = SphereFrom(b, c);
+        if (t.radius2 > s.radius2)
+            s = t;
+        if (u.radius2 > s.radius2)
+            s = u;
+        return s;
+    }
+    glm::dvec3 offset = (glm::cross(normal, ab) * glm::dot(ac, ac) + glm::cross(ac, normal) * glm::dot(ab, ab)) / denominator;
+    return { a + offset, glm::dot(offset, offset) };
+}
+
+// Circumscribed sphere of a tetrahedron
+Sphere SphereFrom(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c, const glm::dvec3& d)
+{
+    glm::dvec3 ab = b - a, ac = c - a, ad = d - a;
+    double determinant = glm::dot(ab, glm::cross(ac, ad));
+    if (std::abs(determinant) < 1e-30) {
+        // Coplanar: the largest triangle circle containing the fourth point
+        Sphere best;
+        const glm::dvec3* p[4] = { &a, &b, &c, &d };
+        for (int skip = 0; skip < 4; skip++) {
+            const glm::dvec3* q[3];
+            for (int i = 0, n = 0; i < 4; i++) {
+                if (i != skip)
+                    q[n++] = p[i];
+            }
+            Sphere s = SphereFrom(*q[0], *q[1], *q[2]);
+            if (s.Contains(*p[skip]) && (best.radius2 < 0.0 || s.radius2 < best.radius2))
+                best = s;
+        }
+        return best.radius2 >= 0.0 ? best : SphereFrom(a, b, c);
+    }
+    glm::dvec3 offset = (glm::cross(ac, ad) * glm::dot(ab, ab) + glm::cross(ad, ab) * glm::dot(ac, ac) + glm::cross(ab, ac) * glm::dot(ad, ad)) / (2.0 * determinant);
+    return { a + offset, glm::dot(offset, offset) };
+}
+
+BoundingSphere ToBoundingSphere(const Sphere& sphere)
+{
+    // Round the radius up so that float points stay inside
+    BoundingSphere result;
+    result.center = glm::vec3(sphere.center);
+    result.radius = static_cast<float>(std::sqrt(std::max(sphere.radius2, 0.0))) * (1.0f + 1e-6f);
+    return result;
+}
+
+// Grows the sphere just enough to include p
+void GrowSphere(glm::vec3& center, float& radius, const glm::vec3& p)
+{
+    glm::vec3 d = p - center;
+    float distance2 = glm::dot(d, d);
+    if (distance2 <= radius * radius)
+        return;
+    float distance = std::sqrt(distance2);
+    float new_radius = (radius + distance) * 0.5f;
+    center += d * ((new_radius - radius) / distance);
+    radius = new_radius;
+}
+
+// EPOS-14 directions: the axes and the cube diagonals
+constexpr int EXTREMAL_DIRECTION_COUNT = 7;
+const glm::vec3 EXTREMAL_DIRECTIONS[EXTREMAL_DIRECTION_COUNT] = {
+    { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+    { 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 }
+};
+
+// Index of the point with the smallest and largest projection on each direction
+void FindExtremalPoints(const glm::vec3* points, size_t count, size_t min_index[], size_t max_index[])
+{
+    float min_value[EXTREMAL_DIRECTION_COUNT], max_value[EXTREMAL_DIRECTION_COUNT];
+    for (int k = 0; k < EXTREMAL_DIRECTION_COUNT; k++) {
+        min_value[k] = max_value[k] = glm::dot(points[0], EXTREMAL_DIRECTIONS[k]);
+        min_index[k] = max_index[k] = 0;
+    }
+
+    size_t i = 0;
+#if BOUNDING_VOLUME_SSE2
+    // Four points per step: 12 floats are loaded and transposed to x, y, z vectors
+    if (count >= 4) {
+        __m128 lane_min[EXTREMAL_DIRECTION_COUNT], lane_max[EXTREMAL_DIRECTION_COUNT];
+        __m128i lane_min_index[EXTREMAL_DIRECTION_COUNT], lane_max_index[EXTREMAL_DIRECTION_COUNT];
+        for (int k = 0; k < EXTREMAL_DIRECTION_COUNT; k++) {
+            lane_min[k] = _mm_set1_ps(min_value[k]);
+            lane_max[k] = _mm_set1_ps(max_value[k]);
+            lane_min_index[k] = lane_max_index[k] = _mm_setzero_si128();
+        }
+        __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i four = _mm_set1_epi32(4);
+
+        const float* data = &points[0].x;
+        for (; i + 4 <= count; i += 4, index = _mm_add_epi32(index, four)) {
+            __m128 a = _mm_loadu_ps(data + i * 3); // x0 y0 z0 x1
+            __m128 b = _mm_loadu_ps(data + i * 3 + 4); // y1 z1 x2 y2
+            __m128 c = _mm_loadu_ps(data + i * 3 + 8); // z2 x3 y3 z3
+            __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+            __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+            __m128 xy = _mm_add_ps(x, y), x_y = _mm_sub_ps(x, y);
+            const __m128 projection[EXTREMAL_DIRECTION_COUNT] = {
+                x, y, z,
+                _mm_add_ps(xy, z), _mm_sub_ps(xy, z), _mm_add_ps(x_y, z), _mm_sub_ps(x_y, z)
+            };
+            for (int k = 0; k < EXTREMAL_DIRECTION_COUNT; k++) {
+                __m128i less = _mm_castps_si128(_mm_cmplt_ps(projection[k], lane_min[k]));
+                __m128i greater = _mm_castps_si128(_mm_cmpgt_ps(projection[k], lane_max[k]));
+                lane_min[k] = _mm_min_ps(lane_min[k], projection[k]);
+                lane_max[k] = _mm_max_ps(lane_max[k], projection[k]);
+                lane_min_index[k] = _mm_or_si128(_mm_and_si128(less, index), _mm_andnot_si128(less, lane_min_index[k]));
+                lane_max_index[k] = _mm_or_si128(_mm_and_si128(greater, index), _mm_andnot_si128(greater, lane_max_index[k]));
+            }
+        }
+
+        // Reduce the four lanes
+        for (int k = 0; k < EXTREMAL_DIRECTION_COUNT; k++) {
+            alignas(16) float lane_min_value[4], lane_max_value[4];
+            alignas(16) int32_t lane_min_position[4], lane_max_position[4];
+            _mm_store_ps(lane_min_value, lane_min[k]);
+            _mm_store_ps(lane_max_value, lane_max[k]);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lane_min_position), lane_min_index[k]);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lane_max_position), lane_max_index[k]);
+            for (int lane = 0; lane < 4; lane++) {
+                if (lane_min_value[lane] < min_value[k]) {
+                    min_value[k] = lane_min_value[lane];
+                    min_index[k] = static_cast<size_t>(lane_min_position[lane]);
+                }
+                if (lane_max_value[lane] > max_value[k]) {
+                    max_value[k] = lane_max_value[lane];
+                    max_index[k] = static_cast<size_t>(lane_max_position[lane]);
+                }
+            }
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        for (int k = 0; k < EXTREMAL_DIRECTION_COUNT; k++) {
+            float projection = glm::dot(points[i], EXTREMAL_DIRECTIONS[k]);
+            if (projection < min_value[k]) {
+                min_value[k] = projection;
+                min_index[k] = i;
+            }
+            if (projection > max_value[k]) {
+                max_value[k] = projection;
+                max_index[k] = i;
+            }
+        }
+    }
+}
+
+// Eigenvectors of a symmetric matrix as columns, by cyclic Jacobi rotations
+glm::dmat3 SymmetricEigenvectors(glm::dmat3 matrix)
+{
+    glm::dmat3 vectors(1.0);
+    for (int sweep = 0; sweep < 32; sweep++) {
+        const double off = matrix[1][0] * matrix[1][0] + matrix[2][0] * matrix[2][0] + matrix[2][1] * matrix[2][1];
+        const double diagonal = matrix[0][0] * matrix[0][0] + matrix[1][1] * matrix[1][1] + matrix[2][2] * matrix[2][2];
+        if (off <= 1e-24 * diagonal)
+            break;
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (matrix[q][p] == 0.0)
+                    continue;
+                // Rotation in the p-q plane that zeroes element p, q
+                const double theta = (matrix[q][q] - matrix[p][p]) / (2.0 * matrix[q][p]);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+                glm::dmat3 rotation(1.0);
+                rotation[p][p] = c;
+                rotation[q][q] = c;
+                rotation[q][p] = s;
+                rotation[p][q] = -s;
+                matrix = glm::transpose(rotation) * matrix * rotation;
+                vectors = vectors * rotation;
+            }
+        }
+    }
+    return vectors;
+}
+
+// Right-handed orthonormal axes closest to the columns given
+glm::dmat3 Orthonormalize(const glm::dmat3& axes)
+{
+    const glm::dvec3 first = glm::normalize(axes[0]);
+    const glm::dvec3 second = glm::normalize(axes[1] - first * glm::dot(axes[1], first));
+    return glm::dmat3(first, second, glm::cross(first, second));
+}
+
+// Box around the points along the given axes, returns its volume
+double FitBox(const glm::vec3* points, size_t count, const glm::dmat3& axes, BoundingBox& box)
+{
+    glm::dvec3 low(std::numeric_limits<double>::max()), high(-std::numeric_limits<double>::max());
+    for (size_t i = 0; i < count; i++) {
+        const glm::dvec3 point(points[i]);
+        for (int axis = 0; axis < 3; axis++) {
+            const double along = glm::dot(axes[axis], point);
+            low[axis] = std::min(low[axis], along);
+            high[axis] = std::max(high[axis], along);
+        }
+    }
+    box.axes = glm::mat3(axes);
+    box.center = glm::vec3(axes * ((low + high) * 0.5));
+    box.half_extents = glm::vec3((high - low) * 0.5);
+    const glm::dvec3 extent = high - low;
+    return extent.x * extent.y * extent.z;
+}
+
+} // namespace
+
+BoundingSphereMethod ResolveBoundingSphereMethod(BoundingSphereMethod method, size_t count)
+{
+    if (method != BoundingSphereMethod::Auto)
+        return method;
+    return count <= BOUNDING_SPHERE_EXACT_MAX_POINTS ? BoundingSphereMethod::Exact : BoundingSphereMethod::Approximate;
+}
+
+BoundingSphere ComputeBoundingSphere(const glm::vec3* points, size_t count, BoundingSphereMethod method)
+{
+    if (ResolveBoundingSphereMethod(method, count) == BoundingSphereMethod::Exact)
+        return ComputeExactBoundingSphere(points, count);
+    return ComputeApproximateBoundingSphere(points, count);
+}
+
+BoundingSphere ComputeExactBoundingSphere(const glm::vec3* points, size_t count)
+{
+    if (count == 0)
+        return {};
+
+    // Random order makes the expected running time linear; fixed seed for reproducible results
+    std::vector<glm::dvec3> p(points, points + count);
+    std::shuffle(p.begin(), p.end(), std::mt19937(0x5eed));
+
+    // Welzl without recursion: each level fixes one more boundary point and rescans the points before it
+    Sphere sphere = SphereFrom(p[0]);
+    for (size_t i = 1; i < count; i++) {
+        if (sphere.Contains(p[i]))
+            continue;
+        sphere = SphereFrom(p[i]);
+        for (size_t j = 0; j < i; j++) {
+            if (sphere.Contains(p[j]))
+                continue;
+            sphere = SphereFrom(p[i], p[j]);
+            for (size_t k = 0; k < j; k++) {
+                if (sphere.Contains(p[k]))
+                    continue;
+                sphere = SphereFrom(p[i], p[j], p[k]);
+                for (size_t l = 0; l < k; l++) {
+                    if (!sphere.Contains(p[l]))
+                        sphere = SphereFrom(p[i], p[j], p[k], p[l]);
+                }
+            }
+        }
+    }
+    return ToBoundingSphere(sphere);
+}
+
+BoundingSphere ComputeApproximateBoundingSphere(const glm::vec3* points, size_t count)
+{
+    if (count == 0)
+        return {};
+
+    // Initial sphere spans the farthest apart pair of extremal points
+    size_t min_index[EXTREMAL_DIRECTION_COUNT], max_index[EXTREMAL_DIRECTION_COUNT];
+    FindExtremalPoints(points, count, min_index, max_index);
+    int widest = 0;
+    float widest_distance2 = -1.0f;
+    for (int k = 0; k < EXTREMAL_DIRECTION_COUNT; k++) {
+        glm::vec3 d = points[max_index[k]] - points[min_index[k]];
+        if (glm::dot(d, d) > widest_distance2) {
+            widest_distance2 = glm::dot(d, d);
+            widest = k;
+        }
+    }
+    glm::vec3 center = (points[min_index[widest]] + points[max_index[widest]]) * 0.5f;
+    float radius = std::sqrt(widest_distance2) * 0.5f;
+
+    // Include the other extremal points first, then grow over all points (Ritter)
+    for (int k = 0; k < EXTREMAL_DIRECTION_COUNT; k++) {
+        GrowSphere(center, radius, points[min_index[k]]);
+        GrowSphere(center, radius, points[max_index[k]]);
+    }
+
+    size_t i = 0;
+#if BOUNDING_VOLUME_SSE2
+    // Test four points at a time, only points outside the sphere need the scalar update
+    const float* data = &points[0].x;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(data + i * 3);
+        __m128 b = _mm_loadu_ps(data + i * 3 + 4);
+        __m128 c = _mm_loadu_ps(data + i * 3 + 8);
+        __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+        __m128 dx = _mm_sub_ps(x, _mm_set1_ps(center.x));
+        __m128 dy = _mm_sub_ps(y, _mm_set1_ps(center.y));
+        __m128 dz = _mm_sub_ps(z, _mm_set1_ps(center.z));
+        __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        int outside = _mm_movemask_ps(_mm_cmpgt_ps(distance2, _mm_set1_ps(radius * radius)));
+        if (outside == 0)
+            continue;
+        for (int lane = 0; lane < 4; lane++) {
+            if (outside & (1 << lane))
+                GrowSphere(center, radius, points[i + lane]);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        GrowSphere(center, radius, points[i]);
+    }
+
+    // Round the radius up so that points grown onto the boundary stay inside
+    return { center, radius * (1.0f + 1e-5f) };
+}
+
+void ComputeAabb(const glm::vec3* points, size_t count, glm::vec3& aabb_min, glm::vec3& aabb_max)
+{
+    if (count == 0)
+        return;
+    aabb_min = points[0];
+    aabb_max = points[0];
+    for (size_t i = 1; i < count; i++) {
+        aabb_min = glm::min(aabb_min, points[i]);
+        aabb_max = glm::max(aabb_max, points[i]);
+    }
+}
+
+BoundingBox ComputeBoundingBox(const glm::vec3* points, size_t count, const ConvexHull* hull)
+{
+    BoundingBox box;
+    if (count == 0)
+        return box;
+    // The hull vertices bound the same box as all points
+    const glm::vec3* outline = hull ? hull->vertices.data() : points;
+    const size_t outline_count = hull ? hull->vertices.size() : count;
+
+    double best_volume = FitBox(outline, outline_count, glm::dmat3(1.0), box);
+    auto consider = [&](const glm::dmat3& axes) {
+        BoundingBox candidate;
+        const double volume = FitBox(outline, outline_count, axes, candidate);
+        if (volume < best_volume) {
+            best_volume = volume;
+            box = candidate;
+        }
+    };
+
+    // Principal axes of all points
+    glm::dvec3 mean(0.0);
+    for (size_t i = 0; i < count; i++)
+        mean += glm::dvec3(points[i]);
+    mean /= static_cast<double>(count);
+    glm::dmat3 covariance(0.0);
+    for (size_t i = 0; i < count; i++) {
+        const glm::dvec3 offset = glm::dvec3(points[i]) - mean;
+        covariance += glm::outerProduct(offset, offset);
+    }
+    consider(Orthonormalize(SymmetricEigenvectors(covariance)));
+    if (!hull)
+        return box;
+
+    // Each face normal, with the axes of the hull vertices' spread across it
+    glm::dvec3 outline_mean(0.0);
+    for (size_t i = 0; i < outline_count; i++)
+        outline_mean += glm::dvec3(outline[i]);
+    outline_mean /= static_cast<double>(outline_count);
+    for (const glm::vec4& plane : hull->planes) {
+        const glm::dvec3 normal = glm::normalize(glm::dvec3(plane));
+        const glm::dvec3 first = glm::normalize(glm::cross(normal, std::fabs(normal.x) < 0.9 ? glm::dvec3(1.0, 0.0, 0.0) : glm::dvec3(0.0, 1.0, 0.0)));
+        const glm::dvec3 second = glm::cross(normal, first);
+        double xx = 0.0, xy = 0.0, yy = 0.0;
+        for (size_t i = 0; i < outline_count; i++) {
+            const glm::dvec3 offset = glm::dvec3(outline[i]) - outline_mean;
+            const double x = glm::dot(offset, first), y = glm::dot(offset, second);
+            xx += x * x;
+            xy += x * y;
+            yy += y * y;
+        }
+        const double angle = 0.5 * std::atan2(2.0 * xy, xx - yy);
+        const glm::dvec3 across = first * std::cos(angle) + second * std::sin(angle);
+        consider(glm::dmat3(normal, across, glm::cross(normal, across)));
+    }
+    return box;
+}
+
+BoundingCapsule ComputeBoundingCapsule(const glm::vec3* points, size_t count, const BoundingBox& box)
+{
+    BoundingCapsule capsule;
+    if (count == 0)
+        return capsule;
+    const glm::vec3 center = box.center, extent = box.half_extents;
+    const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+    const glm::vec3 direction = box.axes[axis];
+
+    float radius2 = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3 offset = points[i] - center;
+        const float along = glm::dot(offset, direction);
+        radius2 = std::max(radius2, glm::dot(offset, offset) - along * along);
+    }
+
+    // A point at distance d from the line is covered by the end cap up to sqrt(r^2 - d^2) past the segment end
+    float low = std::numeric_limits<float>::max(), high = -std::numeric_limits<float>::max();
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3 offset = points[i] - center;
+        const float along = glm::dot(offset, direction);
+        const float cap = std::sqrt(std::max(radius2 - (glm::dot(offset, offset) - along * along), 0.0f));
+        low = std::min(low, along + cap);
+        high = std::max(high, along - cap);
+    }
+    if (low > high)
+        low = high = (low + high) * 0.5f;
+
+    capsule.a = center + direction * low;
+    capsule.b = center + direction * high;
+    capsule.radius = std::sqrt(radius2);
+    return capsule;
+}
+
+const char* BoundingSphereMethodName(BoundingSphereMethod method)
+{
+    switch (method) {
+    case BoundingSphereMethod::Auto:
+        return "auto";
+    case BoundingSphereMethod::Exact:
+        return "exact";
+    case BoundingSphereMethod::Approximate:
+        return "approximate";
+    }
+    return "unknown";
+}
+
+const char* BoundingShapeName(BoundingShape shape)
+{
+    switch (shape) {
+    case BoundingShape::Sphere:
+        return "sphere";
+    case BoundingShape::Box:
+        return "box";
+    case BoundingShape::Capsule:
+        return "capsule";
+    case BoundingShape::Hull:
+        return "hull";
+    }
+    return "unknown";
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Bounding spheres and boxes of contiguous point arrays, no per-point allocations
+
+struct ConvexHull;
+
+// Selects how bounding spheres are computed
+enum class BoundingSphereMethod : uint32_t {
+    Auto, // Exact up to BOUNDING_SPHERE_EXACT_MAX_POINTS, Approximate above
+    Exact, // Smallest enclosing sphere, Welzl's algorithm in randomized iterative form
+    Approximate // EPOS extremal points + Ritter growth, SSE2, a few percent larger than exact
+};
+
+// Collision shape fitted to a mesh, see ComputeMeshBounds
+enum class BoundingShape : uint32_t {
+    Sphere,
+    Box, // The fitted oriented box
+    Capsule,
+    Hull, // Convex hull, used only where the others are much larger
+};
+
+constexpr size_t BOUNDING_SPHERE_EXACT_MAX_POINTS = 200000; // Auto switches to Approximate above this
+constexpr float BOUNDING_SHAPE_HULL_RATIO = 1.5f; // The hull is fitted only when the tightest cheap shape is this many times its volume
+
+struct BoundingSphere {
+    glm::vec3 center{};
+    float radius{};
+};
+
+// Box of the given half extents along unit axes, turned with the object
+struct BoundingBox {
+    glm::vec3 center{};
+    glm::mat3 axes{ 1.0f }; // Columns, right-handed
+    glm::vec3 half_extents{};
+};
+
+// Capsule around segment [a, b]
+struct BoundingCapsule {
+    glm::vec3 a{};
+    glm::vec3 b{};
+    float radius{};
+};
+
+// Resolves Auto for the given point count
+BoundingSphereMethod ResolveBoundingSphereMethod(BoundingSphereMethod method, size_t count);
+
+BoundingSphere ComputeBoundingSphere(const glm::vec3* points, size_t count, BoundingSphereMethod method);
+BoundingSphere ComputeExactBoundingSphere(const glm::vec3* points, size_t count);
+BoundingSphere ComputeApproximateBoundingSphere(const glm::vec3* points, size_t count);
+
+// Axis-aligned box, min and max are left unchanged for count = 0
+void ComputeAabb(const glm::vec3* points, size_t count, glm::vec3& aabb_min, glm::vec3& aabb_max);
+
+// Oriented box of least volume among a few candidate orientations: the coordinate axes, the
+// principal axes of the points (eigenvectors of their covariance) and, when the hull of the points
+// is given, each hull face normal with the principal axes of the hull vertices across it. Only the
+// hull vertices are projected then. Boxes flush with a face are tight for most convex shapes.
+BoundingBox ComputeBoundingBox(const glm::vec3* points, size_t count, const ConvexHull* hull);
+
+// Capsule along the longest axis of the points' box, through its center; the radius reaches the
+// farthest point from that line, the segment is the shortest that still covers every point
+BoundingCapsule ComputeBoundingCapsule(const glm::vec3* points, size_t count, const BoundingBox& box);
+
+const char* BoundingSphereMethodName(BoundingSphereMethod method);
+const char* BoundingShapeName(BoundingShape shape);
@@ -40,6 +40,14 @@ void App::key_callback(GLFWwindow* window, int key, int scancode, int action, in
             glfwSwapInterval(app->vsync_enabled);
             std::cout << "VSync: " << app->vsync_enabled << "\n";
             break;
+
+        case GLFW_KEY_T:
+            // Switch between the terrain renderers, when tessellation is available
+            if (app->terrain_tessellation_supported) {
+                app->terrain_renderer = app->terrain_renderer == TerrainRenderer::Cdlod ? TerrainRenderer::Tessellation : TerrainRenderer::Cdlod;
+                std::cout << "Terrain renderer: " << TerrainRendererName(app->terrain_renderer) << "\n";
+            }
+            break;
         }
     }
 
@@ -72,6 +80,20 @@ void App::mouse_button_callback(GLFWwindow* window, int button, int action, int
                 glfwSetInputMode(window, GLFW_CURSOR, cursor_disabled_mode);
             }
         }
+        else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
+            // Pick the object or ground point in the view direction, whichever is closer
+            TerrainHit hit;
+            const bool ground = this_inst->terrain.Raycast(this_inst->camera.position, this_inst->camera.front, PICK_DISTANCE, hit);
+            float object_distance = 0.0f;
+            const Obj* object = this_inst->PickObject(this_inst->camera.position, this_inst->camera.front, ground ? hit.distance : PICK_DISTANCE, object_distance);
+            if (object) {
+                std::cout << "Scene: Picked " << object->name << ", distance " << object_distance << "\n";
+            }
+            else if (ground) {
+                std::cout << "Terrain: Picked (" << hit.position.x << ", " << hit.position.y << ", " << hit.position.z << "), normal ("
+                    << hit.normal.x << ", " << hit.normal.y << ", " << hit.normal.z << "), distance " << hit.distance << "\n";
+            }
+        }
     }
 }
 
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cmath>
+
+#include "CharacterController.hpp"
+
+CharacterController::CharacterController(float height, float radius)
+    : height(height), radius(radius)
+{
+}
+
+void CharacterController::Teleport(const glm::vec3& feet)
+{
+    this->feet = feet;
+    vertical_speed = 0.0f;
+    grounded = false;
+}
+
+bool CharacterController::Cast(const glm::vec3& motion, SweepHit& hit)
+{
+    const float length = glm::length(motion);
+    if (length == 0.0f)
+        return false;
+    // The segment between the hemisphere centers, the capsule reaches radius beyond it
+    if (!sweep || !sweep(Base(), std::max(height - 2.0f * radius, 0.0f), radius, motion, hit)) {
+        feet += motion;
+        return false;
+    }
+    // Stopped a skin short of the contact, the rest of the motion starts there
+    hit.time = std::max(hit.time * length - CHARACTER_SKIN, 0.0f) / length;
+    feet += motion * hit.time;
+    return true;
+}
+
+glm::vec3 CharacterController::SupportNormal(const SweepHit& hit) const
+{
+    glm::vec3 inward(-hit.normal.x, 0.0f, -hit.normal.z);
+    const float length = glm::length(inward);
+    if (IsWalkable(hit.normal) || length == 0.0f || !sweep)
+        return hit.normal;
+    // A small sphere dropped onto the surface a skin inside the contact and a skin above it
+    SweepHit surface;
+    const glm::vec3 above = hit.position + inward * (CHARACTER_SKIN / length) + glm::vec3(0.0f, CHARACTER_SKIN, 0.0f);
+    if (sweep(above, 0.0f, 0.5f * CHARACTER_SKIN, glm::vec3(0.0f, -2.0f * CHARACTER_SKIN, 0.0f), surface) && IsWalkable(surface.normal))
+        return surface.normal;
+    return hit.normal;
+}
+
+bool CharacterController::SlideMove(glm::vec3 motion, bool walking)
+{
+    bool walkable = false;
+    for (int i = 0; i < CHARACTER_SLIDE_ITERATIONS; i++) {
+        SweepHit hit;
+        if (!Cast(motion, hit))
+            break;
+        glm::vec3 normal = walking ? hit.normal : SupportNormal(hit);
+        if (IsWalkable(normal)) {
+            walkable = true;
+        }
+        else if (walking) {
+            // Walking into a wall neither lifts nor presses the capsule, it only pushes sideways
+            normal.y = 0.0f;
+            const float length = glm::length(normal);
+            if (length == 0.0f)
+                break;
+            normal /= length;
+        }
+        // The rest of the motion without its part into the surface
+        motion *= 1.0f - hit.time;
+        motion -= normal * std::min(glm::dot(motion, normal), 0.0f);
+    }
+    return walkable;
+}
+
+void CharacterController::Move(const glm::vec3& walk, float jump_speed, float delta_time)
+{
+    if (grounded && jump_speed > 0.0f) {
+        vertical_speed = jump_speed;
+        grounded = false;
+    }
+    vertical_speed -= CHARACTER_GRAVITY * delta_time;
+
+    // Ground too steep to walk keeps only the part of the walk across or down the slope
+    glm::vec3 horizontal(walk.x, 0.0f, walk.z);
+    glm::vec3 normal(0.0f, 1.0f, 0.0f);
+    if (ground && feet.y - ground(feet.x, feet.z, normal) < CHARACTER_STEP_HEIGHT && !IsWalkable(normal)) {
+        const glm::vec3 downhill = glm::normalize(glm::vec3(normal.x, 0.0f, normal.z));
+        horizontal += downhill * std::max(-glm::dot(horizontal, downhill), 0.0f);
+    }
+
+    // Walk lifted by the step height, then down as far again: onto a ledge that was climbed, or back
+    // to the height walked at. A steep landing is no step, the walk is repeated without the lift then.
+    if (glm::dot(horizontal, horizontal) > 0.0f) {
+        const glm::vec3 start = feet;
+        SweepHit hit;
+        float lift = 0.0f;
+        if (grounded) {
+            Cast(glm::vec3(0.0f, CHARACTER_STEP_HEIGHT, 0.0f), hit);
+            lift = feet.y - start.y;
+        }
+        SlideMove(horizontal, true);
+        if (lift > 0.0f && Cast(glm::vec3(0.0f, -lift, 0.0f), hit) && !IsWalkable(SupportNormal(hit))) {
+            feet = start;
+            SlideMove(horizontal, true);
+        }
+    }
+
+    // Fall, or on the ground probe down by the step height so that walking down slopes and steps does not fall
+    const bool was_grounded = grounded;
+    const float fall = vertical_speed * delta_time;
+    grounded = false;
+    if (was_grounded && vertical_speed <= 0.0f) {
+        const glm::vec3 start = feet;
+        SweepHit hit;
+        if (Cast(glm::vec3(0.0f, std::min(fall, -CHARACTER_STEP_HEIGHT), 0.0f), hit) && IsWalkable(SupportNormal(hit)))
+            grounded = true;
+        else
+            feet = start;
+    }
+    if (!grounded) {
+        const float start_y = feet.y;
+        if (SlideMove(glm::vec3(0.0f, fall, 0.0f), false) && vertical_speed <= 0.0f)
+            grounded = true;
+        else if (vertical_speed > 0.0f && feet.y - start_y < fall - CHARACTER_SKIN)
+            vertical_speed = 0.0f; // Head against a ceiling
+    }
+    if (grounded)
+        vertical_speed = 0.0f;
+
+    // The feet never go below the ground; while grounded they follow it down by up to the step height
+    if (ground) {
+        const float ground_y = ground(feet.x, feet.z, normal);
+        const float snap = was_grounded && vertical_speed <= 0.0f ? CHARACTER_STEP_HEIGHT : 0.0f;
+        if (feet.y < ground_y || (!grounded && feet.y - snap <= ground_y)) {
+            feet.y = ground_y;
+            grounded = IsWalkable(normal) && vertical_speed <= 0.0f;
+            vertical_speed = std::max(vertical_speed, 0.0f);
+        }
+    }
+}
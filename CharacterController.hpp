@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "SweptCollision.hpp"
+
+constexpr float CHARACTER_GRAVITY = 9.81f; // Downwards acceleration, world units per second squared
+constexpr float CHARACTER_STEP_HEIGHT = 0.3f; // Ledges up to this height are walked onto, and walked down from without falling
+constexpr float CHARACTER_MAX_SLOPE_COS = 0.7071f; // Cosine of the steepest walkable slope, 45 degrees
+constexpr float CHARACTER_SKIN = 0.01f; // Gap kept to the obstacles, so the next sweep does not start touching them
+constexpr int CHARACTER_SLIDE_ITERATIONS = 4; // Obstacles slid along per move, corners take two
+
+// Kinematic upright capsule walking on a height field ground among swept obstacles
+//
+// The controller is moved, not simulated: every Move() sweeps the capsule through the scene and
+// slides the rest of the motion along what it touched. While grounded it first lifts by the step
+// height, so low ledges are climbed, and afterwards probes down as far, so it stays on slopes and
+// steps. Surfaces steeper than the slope limit are treated as walls, on the ground the uphill part
+// of the walk is removed there. Obstacles are found by the Sweep callback, the ground below them
+// comes from the Ground callback; the feet never go below it.
+class CharacterController
+{
+public:
+    // Height of the ground at (x, z) and its normal, the ground is below the returned height
+    using Ground = std::function<float(float x, float z, glm::vec3& normal)>;
+    // First contact of the capsule around segment [base, base + (0, height, 0)] moving by motion
+    using Sweep = std::function<bool(const glm::vec3& base, float height, float radius, const glm::vec3& motion, SweepHit& hit)>;
+
+    CharacterController(float height, float radius); // Capsule from the feet up to height
+    void SetGround(Ground ground) { this->ground = std::move(ground); }
+    void SetSweep(Sweep sweep) { this->sweep = std::move(sweep); }
+
+    void Teleport(const glm::vec3& feet); // Places the feet without sweeping, stops any fall
+    // walk is the horizontal motion of this step, a jump starts only when grounded
+    void Move(const glm::vec3& walk, float jump_speed, float delta_time);
+
+    const glm::vec3& Feet() const { return feet; }
+    bool IsGrounded() const { return grounded; }
+
+private:
+    float height;
+    float radius;
+    glm::vec3 feet{ 0.0f };
+    float vertical_speed = 0.0f;
+    bool grounded = false;
+    Ground ground;
+    Sweep sweep;
+
+    glm::vec3 Base() const { return feet + glm::vec3(0.0f, radius, 0.0f); } // Center of the bottom hemisphere
+    static bool IsWalkable(const glm::vec3& normal) { return normal.y >= CHARACTER_MAX_SLOPE_COS; }
+    bool Cast(const glm::vec3& motion, SweepHit& hit); // Moves the feet up to the first contact, hit.time the part moved; false if nothing was touched
+    // Normal of the surface below a contact; the capsule's round bottom on a ledge edge gets a steep
+    // hit normal, the top of the ledge just inside the contact is probed then
+    glm::vec3 SupportNormal(const SweepHit& hit) const;
+    // Moves and slides along the contacts, true if one can be stood on; walking treats steep contacts
+    // as vertical walls, otherwise contacts that can be stood on stop the motion
+    bool SlideMove(glm::vec3 motion, bool walking);
+};
@@ -0,0 +1,143 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "CollisionShapes.hpp"
+#include "MeshData.hpp"
+
+// Microbenchmark of the candidate filter, run with --bench-collision
+//
+// The baseline is a per object loop in the style the scene used before: bounds scaled on every
+// call, a branch on use_aabb, one object at a time. Every kernel filters the whole object list
+// against the same random boxes, the size of a projectile's step; most of the objects miss.
+
+namespace {
+
+constexpr int BENCHMARK_QUERIES = 4096; // Boxes tested per repetition
+constexpr double BENCHMARK_SECONDS = 0.2; // Minimum measured time per case
+
+// A per-object overlap test, reading the fields laid out as in Obj
+struct BaselineObject {
+    glm::vec3 position;
+    float scale;
+    MeshBounds mesh_bounds;
+    bool use_aabb;
+
+    bool Overlaps(const glm::vec3& aabb_min, const glm::vec3& aabb_max) const
+    {
+        MeshBounds bounds;
+        bounds.sphere_center = mesh_bounds.sphere_center * scale;
+        bounds.sphere_radius = mesh_bounds.sphere_radius * scale;
+        bounds.aabb_min = mesh_bounds.aabb_min * scale;
+        bounds.aabb_max = mesh_bounds.aabb_max * scale;
+        if (!use_aabb) {
+            const glm::vec3 center = position + bounds.sphere_center;
+            return glm::distance(glm::clamp(center, aabb_min, aabb_max), center) < bounds.sphere_radius;
+        }
+        return
+            aabb_min.x <= position.x + bounds.aabb_max.x &&
+            aabb_max.x >= position.x + bounds.aabb_min.x &&
+            aabb_min.y <= position.y + bounds.aabb_max.y &&
+            aabb_max.y >= position.y + bounds.aabb_min.y &&
+            aabb_min.z <= position.z + bounds.aabb_max.z &&
+            aabb_max.z >= position.z + bounds.aabb_min.z;
+    }
+};
+
+// Repeats run until BENCHMARK_SECONDS have passed, returns objects tested per nanosecond
+template <typename Run>
+double Measure(size_t tests_per_run, Run run)
+{
+    using clock = std::chrono::steady_clock;
+    size_t runs = 0;
+    const auto start = clock::now();
+    std::chrono::duration<double> elapsed{};
+    do {
+        run();
+        runs++;
+        elapsed = clock::now() - start;
+    } while (elapsed.count() < BENCHMARK_SECONDS);
+    return static_cast<double>(tests_per_run) * runs / (elapsed.count() * 1e9);
+}
+
+} // namespace
+
+int RunCollisionBenchmark()
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> extent(0.2f, 1.0f);
+
+    std::vector<glm::vec3> query_mins(BENCHMARK_QUERIES), query_maxs(BENCHMARK_QUERIES);
+    for (int q = 0; q < BENCHMARK_QUERIES; q++) {
+        query_mins[q] = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+        query_maxs[q] = query_mins[q] + glm::vec3(extent(random), extent(random), extent(random));
+    }
+    std::vector<int> ids, hits;
+    volatile size_t sink = 0; // Keeps the results alive
+    bool mismatch = false;
+
+    std::cout << "Collision benchmark, " << BENCHMARK_QUERIES << " boxes, best level " << SimdLevelName(DetectSimdLevel()) << "\n";
+    for (int object_count : { 16, 64, 256, 1024 }) {
+        // Half spheres, half boxes, as in the scene
+        std::vector<BaselineObject> objects(object_count);
+        CollisionShapes shapes;
+        for (int i = 0; i < object_count; i++) {
+            BaselineObject& object = objects[i];
+            object.position = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+            object.scale = extent(random);
+            object.mesh_bounds.sphere_radius = 1.0f;
+            object.mesh_bounds.aabb_min = glm::vec3(-1.0f);
+            object.mesh_bounds.aabb_max = glm::vec3(1.0f);
+            object.use_aabb = i % 2 == 1;
+
+            const int id = shapes.Add();
+            if (object.use_aabb)
+                shapes.SetAabb(id, object.position - object.scale, object.position + object.scale);
+            else
+                shapes.SetSphere(id, object.position, object.scale);
+        }
+
+        // Every query filters the full list, the survivors of all queries are kept in order
+        std::vector<int> all_ids(object_count);
+        for (int i = 0; i < object_count; i++)
+            all_ids[i] = i;
+        const size_t tests = static_cast<size_t>(BENCHMARK_QUERIES) * objects.size();
+        const double baseline = Measure(tests, [&]() {
+            hits.clear();
+            for (int q = 0; q < BENCHMARK_QUERIES; q++) {
+                for (int i = 0; i < object_count; i++) {
+                    if (objects[i].Overlaps(query_mins[q], query_maxs[q]))
+                        hits.push_back(i);
+                }
+            }
+            sink = hits.size();
+        });
+        const std::vector<int> expected = hits;
+        std::cout << "  " << object_count << " objects: loop " << baseline << " objects/ns";
+
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 }) {
+            if (level > DetectSimdLevel())
+                continue;
+            shapes.SetLevel(level);
+            const double rate = Measure(tests, [&]() {
+                hits.clear();
+                for (int q = 0; q < BENCHMARK_QUERIES; q++) {
+                    ids = all_ids;
+                    ids.resize(shapes.Overlapping(query_mins[q], query_maxs[q], ids.data(), ids.size()));
+                    hits.insert(hits.end(), ids.begin(), ids.end());
+                }
+                sink = hits.size();
+            });
+            std::cout << ", " << SimdLevelName(level) << " " << rate;
+            if (hits != expected) {
+                std::cout << " (results differ)";
+                mismatch = true;
+            }
+        }
+        std::cout << "\n";
+    }
+    return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
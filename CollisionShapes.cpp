@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "CollisionShapes.hpp"
+
+// MSVC compiles AVX2 intrinsics anywhere, GCC and Clang only in functions built for AVX2
+#ifdef _MSC_VER
+#define COLLISION_AVX2
+#else
+#define COLLISION_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+constexpr float INFINITE = std::numeric_limits<float>::infinity();
+
+struct ShapeArrays {
+    const float* center_x;
+    const float* center_y;
+    const float* center_z;
+    const float* radius_squared;
+    const float* min_x;
+    const float* min_y;
+    const float* min_z;
+    const float* max_x;
+    const float* max_y;
+    const float* max_z;
+};
+
+bool Overlaps(const ShapeArrays& shapes, const glm::vec3& aabb_min, const glm::vec3& aabb_max, int i)
+{
+    // Distance from the sphere center to the box, zero inside it
+    const glm::vec3 center(shapes.center_x[i], shapes.center_y[i], shapes.center_z[i]);
+    const glm::vec3 outside = glm::max(glm::max(aabb_min - center, center - aabb_max), glm::vec3(0.0f));
+    return glm::dot(outside, outside) < shapes.radius_squared[i] &&
+        shapes.min_x[i] <= aabb_max.x && aabb_min.x <= shapes.max_x[i] &&
+        shapes.min_y[i] <= aabb_max.y && aabb_min.y <= shapes.max_y[i] &&
+        shapes.min_z[i] <= aabb_max.z && aabb_min.z <= shapes.max_z[i];
+}
+
+size_t ScalarOverlapping(const ShapeArrays& shapes, const glm::vec3& aabb_min, const glm::vec3& aabb_max,
+    const int* ids, size_t count, int* kept_ids)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (Overlaps(shapes, aabb_min, aabb_max, ids[i]))
+            kept_ids[kept++] = ids[i];
+    }
+    return kept;
+}
+
+// Lane mask of the four shapes whose values are in the given registers, box holds the query's min and max x, y, z
+__m128 Sse2Overlaps(const __m128 box[6], __m128 center_x, __m128 center_y, __m128 center_z, __m128 radius_squared,
+    __m128 min_x, __m128 min_y, __m128 min_z, __m128 max_x, __m128 max_y, __m128 max_z)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(box[0], center_x), _mm_sub_ps(center_x, box[3])), zero);
+    const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(box[1], center_y), _mm_sub_ps(center_y, box[4])), zero);
+    const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(box[2], center_z), _mm_sub_ps(center_z, box[5])), zero);
+    const __m128 distance_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    __m128 overlap = _mm_cmplt_ps(distance_squared, radius_squared);
+    overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(min_x, box[3]), _mm_cmple_ps(box[0], max_x)));
+    overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(min_y, box[4]), _mm_cmple_ps(box[1], max_y)));
+    overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(min_z, box[5]), _mm_cmple_ps(box[2], max_z)));
+    return overlap;
+}
+
+size_t Sse2Overlapping(const ShapeArrays& shapes, const glm::vec3& aabb_min, const glm::vec3& aabb_max,
+    const int* ids, size_t count, int* kept_ids)
+{
+    // SSE2 has no gather, the four shapes are loaded lane by lane
+    const __m128 box[6] = { _mm_set1_ps(aabb_min.x), _mm_set1_ps(aabb_min.y), _mm_set1_ps(aabb_min.z),
+        _mm_set1_ps(aabb_max.x), _mm_set1_ps(aabb_max.y), _mm_set1_ps(aabb_max.z) };
+    size_t i = 0, kept = 0;
+    for (; i + 4 <= count; i += 4) {
+        const int a = ids[i], b = ids[i + 1], c = ids[i + 2], d = ids[i + 3];
+        auto gather = [&](const float* values) { return _mm_setr_ps(values[a], values[b], values[c], values[d]); };
+        const __m128 overlap = Sse2Overlaps(box,
+            gather(shapes.center_x), gather(shapes.center_y), gather(shapes.center_z), gather(shapes.radius_squared),
+            gather(shapes.min_x), gather(shapes.min_y), gather(shapes.min_z),
+            gather(shapes.max_x), gather(shapes.max_y), gather(shapes.max_z));
+        const int mask = _mm_movemask_ps(overlap);
+        const int lane_ids[4] = { a, b, c, d };
+        for (int lane = 0; lane < 4; lane++) {
+            if (mask & (1 << lane))
+                kept_ids[kept++] = lane_ids[lane];
+        }
+    }
+    return kept + ScalarOverlapping(shapes, aabb_min, aabb_max, ids + i, count - i, kept_ids + kept);
+}
+
+COLLISION_AVX2 __m256 Avx2Overlaps(const __m256 box[6], __m256 center_x, __m256 center_y, __m256 center_z, __m256 radius_squared,
+    __m256 min_x, __m256 min_y, __m256 min_z, __m256 max_x, __m256 max_y, __m256 max_z)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(box[0], center_x), _mm256_sub_ps(center_x, box[3])), zero);
+    const __m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(box[1], center_y), _mm256_sub_ps(center_y, box[4])), zero);
+    const __m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(box[2], center_z), _mm256_sub_ps(center_z, box[5])), zero);
+    const __m256 distance_squared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+    __m256 overlap = _mm256_cmp_ps(distance_squared, radius_squared, _CMP_LT_OQ);
+    overlap = _mm256_and_ps(overlap, _mm256_and_ps(_mm256_cmp_ps(min_x, box[3], _CMP_LE_OQ), _mm256_cmp_ps(box[0], max_x, _CMP_LE_OQ)));
+    overlap = _mm256_and_ps(overlap, _mm256_and_ps(_mm256_cmp_ps(min_y, box[4], _CMP_LE_OQ), _mm256_cmp_ps(box[1], max_y, _CMP_LE_OQ)));
+    overlap = _mm256_and_ps(overlap, _mm256_and_ps(_mm256_cmp_ps(min_z, box[5], _CMP_LE_OQ), _mm256_cmp_ps(box[2], max_z, _CMP_LE_OQ)));
+    return overlap;
+}
+
+// Not a lambda, those do not inherit the AVX2 target
+COLLISION_AVX2 __m256 Avx2Gather(const float* values, __m256i index)
+{
+    return _mm256_i32gather_ps(values, index, 4);
+}
+
+COLLISION_AVX2 size_t Avx2Overlapping(const ShapeArrays& shapes, const glm::vec3& aabb_min, const glm::vec3& aabb_max,
+    const int* ids, size_t count, int* kept_ids)
+{
+    const __m256 box[6] = { _mm256_set1_ps(aabb_min.x), _mm256_set1_ps(aabb_min.y), _mm256_set1_ps(aabb_min.z),
+        _mm256_set1_ps(aabb_max.x), _mm256_set1_ps(aabb_max.y), _mm256_set1_ps(aabb_max.z) };
+    size_t i = 0, kept = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + i));
+        const __m256 overlap = Avx2Overlaps(box,
+            Avx2Gather(shapes.center_x, index), Avx2Gather(shapes.center_y, index), Avx2Gather(shapes.center_z, index), Avx2Gather(shapes.radius_squared, index),
+            Avx2Gather(shapes.min_x, index), Avx2Gather(shapes.min_y, index), Avx2Gather(shapes.min_z, index),
+            Avx2Gather(shapes.max_x, index), Avx2Gather(shapes.max_y, index), Avx2Gather(shapes.max_z, index));
+        alignas(32) int lane_ids[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lane_ids), index);
+        const int mask = _mm256_movemask_ps(overlap);
+        for (int lane = 0; lane < 8; lane++) {
+            if (mask & (1 << lane))
+                kept_ids[kept++] = lane_ids[lane];
+        }
+    }
+    // The callers are SSE code, which would pay for the dirty upper halves of the YMM registers
+    _mm256_zeroupper();
+    return kept + Sse2Overlapping(shapes, aabb_min, aabb_max, ids + i, count - i, kept_ids + kept);
+}
+
+// kept_ids may be ids itself, a kept id is written no further than where it was read
+using Kernel = size_t (*)(const ShapeArrays& shapes, const glm::vec3& aabb_min, const glm::vec3& aabb_max,
+    const int* ids, size_t count, int* kept_ids);
+
+Kernel KernelFor(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Avx2:
+        return Avx2Overlapping;
+    case SimdLevel::Sse2:
+        return Sse2Overlapping;
+    default:
+        return ScalarOverlapping;
+    }
+}
+
+SimdLevel SupportedSimdLevel()
+{
+    static const SimdLevel supported = DetectSimdLevel();
+    return supported;
+}
+
+} // namespace
+
+SimdLevel DetectSimdLevel()
+{
+    // x86-64 always has SSE2; AVX2 needs the CPU flag and an operating system that saves the YMM registers
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+    __cpuid(info, 1);
+    const bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (max_leaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return os_saves_ymm && avx2 ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#endif
+}
+
+const char* SimdLevelName(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Avx2:
+        return "AVX2";
+    case SimdLevel::Sse2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+CollisionShapes::CollisionShapes() :
+    level(SupportedSimdLevel())
+{
+}
+
+int CollisionShapes::Add()
+{
+    const int id = static_cast<int>(count++);
+    for (auto* values : { &center_x, &center_y, &center_z, &radius_squared, &min_x, &min_y, &min_z, &max_x, &max_y, &max_z })
+        values->push_back(0.0f);
+    SetEmpty(id);
+    return id;
+}
+
+void CollisionShapes::SetSphere(int id, const glm::vec3& center, float radius)
+{
+    center_x[id] = center.x;
+    center_y[id] = center.y;
+    center_z[id] = center.z;
+    radius_squared[id] = radius * radius;
+    min_x[id] = min_y[id] = min_z[id] = -INFINITE;
+    max_x[id] = max_y[id] = max_z[id] = INFINITE;
+}
+
+void CollisionShapes::SetAabb(int id, const glm::vec3& aabb_min, const glm::vec3& aabb_max)
+{
+    center_x[id] = center_y[id] = center_z[id] = 0.0f;
+    radius_squared[id] = INFINITE;
+    min_x[id] = aabb_min.x;
+    min_y[id] = aabb_min.y;
+    min_z[id] = aabb_min.z;
+    max_x[id] = aabb_max.x;
+    max_y[id] = aabb_max.y;
+    max_z[id] = aabb_max.z;
+}
+
+void CollisionShapes::SetEmpty(int id)
+{
+    center_x[id] = center_y[id] = center_z[id] = 0.0f;
+    radius_squared[id] = -1.0f;
+    min_x[id] = min_y[id] = min_z[id] = INFINITE;
+    max_x[id] = max_y[id] = max_z[id] = -INFINITE;
+}
+
+void CollisionShapes::Clear()
+{
+    count = 0;
+    for (auto* values : { &center_x, &center_y, &center_z, &radius_squared, &min_x, &min_y, &min_z, &max_x, &max_y, &max_z })
+        values->clear();
+}
+
+void CollisionShapes::SetLevel(SimdLevel requested)
+{
+    level = std::min(requested, SupportedSimdLevel());
+}
+
+size_t CollisionShapes::Overlapping(const glm::vec3& aabb_min, const glm::vec3& aabb_max, int* ids, size_t id_count) const
+{
+    const ShapeArrays shapes{ center_x.data(), center_y.data(), center_z.data(), radius_squared.data(),
+        min_x.data(), min_y.data(), min_z.data(), max_x.data(), max_y.data(), max_z.data() };
+    return KernelFor(level)(shapes, aabb_min, aabb_max, ids, id_count, ids);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Instruction sets the collision kernels can run on, each includes the ones before it
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+SimdLevel DetectSimdLevel(); // Best level of this CPU and operating system
+const char* SimdLevelName(SimdLevel level);
+
+// Box overlap tests against many collision shapes, stored as structure of arrays
+//
+// Every shape is a sphere and a box at once, a box overlaps it when it comes strictly closer to
+// the center than the radius and touches the box. Sphere objects get an unbounded box, box
+// objects an infinite sphere, empty shapes a negative radius; so one branch-free kernel tests
+// both kinds. Shapes are tested four (SSE2) or eight (AVX2) at a time, the level is picked at
+// runtime. Shape ids are indices in creation order. The game drops the broadphase candidates
+// whose bounds miss the box around a sweep before it runs the exact sweeps of Narrowphase.hpp.
+class CollisionShapes
+{
+public:
+    CollisionShapes();
+
+    int Add(); // New empty shape, returns its id
+    void SetSphere(int id, const glm::vec3& center, float radius);
+    void SetAabb(int id, const glm::vec3& aabb_min, const glm::vec3& aabb_max);
+    void SetEmpty(int id); // Overlaps nothing
+    void Clear();
+
+    // Keeps the shapes of ids[0, id_count) that overlap the box at the front of ids, in order; returns how many
+    size_t Overlapping(const glm::vec3& aabb_min, const glm::vec3& aabb_max, int* ids, size_t id_count) const;
+
+    size_t Count() const { return count; }
+    SimdLevel Level() const { return level; }
+    void SetLevel(SimdLevel requested); // Clamped to DetectSimdLevel(), for comparisons
+
+private:
+    size_t count = 0;
+    SimdLevel level;
+
+    // Sphere center and squared radius, box corners; one entry per shape
+    std::vector<float> center_x, center_y, center_z, radius_squared;
+    std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+};
+
+// Objects tested per nanosecond by the SIMD kernels against a per-object overlap test loop, see --bench-collision
+int RunCollisionBenchmark();
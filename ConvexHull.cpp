@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+#include "ConvexHull.hpp"
+
+namespace {
+
+// Hull triangle while the hull is being built, in double precision
+struct Face {
+    int corners[3]; // Counterclockwise seen from outside
+    glm::dvec3 normal; // Unit, outward
+    double offset;
+    bool alive;
+    int stamp; // Last point whose visible faces were searched through this one
+    std::vector<int> outside; // Points above the face, not yet on the hull
+};
+
+Face MakeFace(const std::vector<glm::dvec3>& points, int a, int b, int c)
+{
+    Face face{ { a, b, c }, glm::cross(points[b] - points[a], points[c] - points[a]), 0.0, true, -1, {} };
+    const double length = glm::length(face.normal);
+    face.normal = length > 0.0 ? face.normal / length : glm::dvec3(0.0);
+    face.offset = glm::dot(face.normal, points[a]);
+    return face;
+}
+
+uint64_t EdgeKey(int from, int to)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(from)) << 32) | static_cast<uint32_t>(to);
+}
+
+} // namespace
+
+bool ComputeConvexHull(const glm::vec3* input, size_t count, ConvexHull& hull)
+{
+    hull = ConvexHull();
+    if (count < 4)
+        return false;
+    std::vector<glm::dvec3> points(input, input + count);
+
+    // Two points farthest apart among the extremes on the axes
+    int extremes[6] = {};
+    for (int i = 1; i < static_cast<int>(count); i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (points[i][axis] < points[extremes[2 * axis]][axis])
+                extremes[2 * axis] = i;
+            if (points[i][axis] > points[extremes[2 * axis + 1]][axis])
+                extremes[2 * axis + 1] = i;
+        }
+    }
+    int first = 0, second = 0;
+    double best = 0.0;
+    for (int axis = 0; axis < 3; axis++) {
+        const glm::dvec3 span = points[extremes[2 * axis + 1]] - points[extremes[2 * axis]];
+        if (glm::dot(span, span) > best) {
+            best = glm::dot(span, span);
+            first = extremes[2 * axis];
+            second = extremes[2 * axis + 1];
+        }
+    }
+    // Points closer than this to a plane count as on it
+    const double epsilon = 1e-6 * std::sqrt(best);
+    if (best == 0.0)
+        return false;
+
+    // Then the farthest from their line and the farthest from the plane of the three
+    const glm::dvec3 line = glm::normalize(points[second] - points[first]);
+    int third = first;
+    best = 0.0;
+    for (int i = 0; i < static_cast<int>(count); i++) {
+        const glm::dvec3 offset = points[i] - points[first];
+        const glm::dvec3 across = offset - line * glm::dot(offset, line);
+        if (glm::dot(across, across) > best) {
+            best = glm::dot(across, across);
+            third = i;
+        }
+    }
+    if (std::sqrt(best) <= epsilon)
+        return false;
+    const glm::dvec3 base_normal = glm::normalize(glm::cross(points[second] - points[first], points[third] - points[first]));
+    int fourth = first;
+    best = 0.0;
+    for (int i = 0; i < static_cast<int>(count); i++) {
+        const double distance = std::fabs(glm::dot(points[i] - points[first], base_normal));
+        if (distance > best) {
+            best = distance;
+            fourth = i;
+        }
+    }
+    if (best <= epsilon)
+        return false;
+
+    // Wound so that the normals point away from the tetrahedron's center
+    const glm::dvec3 inside = (points[first] + points[second] + points[third] + points[fourth]) * 0.25;
+    if (glm::dot(glm::cross(points[second] - points[first], points[third] - points[first]), inside - points[first]) > 0.0)
+        std::swap(second, third);
+    std::vector<Face> faces = {
+        MakeFace(points, first, second, third),
+        MakeFace(points, first, fourth, second),
+        MakeFace(points, second, fourth, third),
+        MakeFace(points, third, fourth, first),
+    };
+    std::unordered_map<uint64_t, int> edge_faces; // Directed edge to the live face it belongs to, the opposite edge leads to the neighbor
+    auto link = [&faces, &edge_faces](int face) {
+        for (int corner = 0; corner < 3; corner++)
+            edge_faces[EdgeKey(faces[face].corners[corner], faces[face].corners[(corner + 1) % 3])] = face;
+    };
+    for (int face = 0; face < 4; face++)
+        link(face);
+
+    // Every point goes to the first face it is above; points below all faces are inside
+    auto assign = [&faces, &points, epsilon](int point, size_t first_face) {
+        for (size_t f = first_face; f < faces.size(); f++) {
+            if (faces[f].alive && glm::dot(faces[f].normal, points[point]) - faces[f].offset > epsilon) {
+                faces[f].outside.push_back(point);
+                return;
+            }
+        }
+    };
+    for (int i = 0; i < static_cast<int>(count); i++)
+        assign(i, 0);
+
+    std::vector<int> stack, visible, orphans;
+    std::vector<std::pair<int, int>> horizon;
+    for (size_t f = 0; f < faces.size(); f++) {
+        if (!faces[f].alive || faces[f].outside.empty())
+            continue;
+        int apex = faces[f].outside[0];
+        for (int point : faces[f].outside) {
+            if (glm::dot(faces[f].normal, points[point]) > glm::dot(faces[f].normal, points[apex]))
+                apex = point;
+        }
+
+        // Faces that see the apex form a connected region, its boundary edges are the horizon
+        visible.clear();
+        horizon.clear();
+        stack.assign(1, static_cast<int>(f));
+        faces[f].stamp = apex;
+        while (!stack.empty()) {
+            const int face = stack.back();
+            stack.pop_back();
+            visible.push_back(face);
+            for (int corner = 0; corner < 3; corner++) {
+                const int from = faces[face].corners[corner], to = faces[face].corners[(corner + 1) % 3];
+                const int neighbor = edge_faces[EdgeKey(to, from)];
+                if (faces[neighbor].stamp == apex)
+                    continue;
+                if (glm::dot(faces[neighbor].normal, points[apex]) - faces[neighbor].offset > epsilon) {
+                    faces[neighbor].stamp = apex;
+                    stack.push_back(neighbor);
+                }
+                else {
+                    horizon.emplace_back(from, to);
+                }
+            }
+        }
+
+        // The visible faces give way to a cone from the horizon to the apex, their points are redistributed
+        orphans.clear();
+        for (int face : visible) {
+            faces[face].alive = false;
+            orphans.insert(orphans.end(), faces[face].outside.begin(), faces[face].outside.end());
+            std::vector<int>().swap(faces[face].outside);
+        }
+        const size_t first_new = faces.size();
+        for (const auto& [from, to] : horizon) {
+            faces.push_back(MakeFace(points, from, to, apex));
+            link(static_cast<int>(faces.size()) - 1);
+        }
+        for (int point : orphans) {
+            if (point != apex)
+                assign(point, first_new);
+        }
+    }
+    // Corners, volume from tetrahedra to the inside point, and the planes: a face coplanar with a
+    // neighbor already visited shares its plane. Points within epsilon of a face do not replace it,
+    // which can leave edges slightly concave; each plane is pushed out over the neighbors' corners.
+    std::vector<bool> used(count, false);
+    std::vector<int> face_planes(faces.size(), -1);
+    double volume = 0.0;
+    for (size_t f = 0; f < faces.size(); f++) {
+        const Face& face = faces[f];
+        if (!face.alive)
+            continue;
+        for (int corner : face.corners)
+            used[corner] = true;
+        const glm::dvec3 a = points[face.corners[0]] - inside, b = points[face.corners[1]] - inside, c = points[face.corners[2]] - inside;
+        volume += glm::dot(a, glm::cross(b, c)) / 6.0;
+
+        int neighbors[3];
+        for (int corner = 0; corner < 3; corner++) {
+            neighbors[corner] = edge_faces[EdgeKey(face.corners[(corner + 1) % 3], face.corners[corner])];
+            const Face& neighbor = faces[neighbors[corner]];
+            if (face_planes[f] < 0 && face_planes[neighbors[corner]] >= 0 &&
+                glm::dot(neighbor.normal, face.normal) > 1.0 - 1e-6 && std::fabs(neighbor.offset - face.offset) <= epsilon)
+                face_planes[f] = face_planes[neighbors[corner]];
+        }
+        if (face_planes[f] < 0) {
+            face_planes[f] = static_cast<int>(hull.planes.size());
+            hull.planes.push_back(glm::vec4(glm::vec3(face.normal), static_cast<float>(face.offset)));
+        }
+        glm::vec4& plane = hull.planes[face_planes[f]];
+        for (int corner = 0; corner < 3; corner++) {
+            for (int point : faces[neighbors[corner]].corners)
+                plane.w = std::max(plane.w, glm::dot(glm::vec3(plane), input[point]));
+        }
+    }
+    hull.aabb_min = glm::vec3(std::numeric_limits<float>::max());
+    hull.aabb_max = glm::vec3(-std::numeric_limits<float>::max());
+    glm::dvec3 sum(0.0);
+    for (size_t i = 0; i < count; i++) {
+        if (!used[i])
+            continue;
+        hull.vertices.push_back(input[i]);
+        hull.aabb_min = glm::min(hull.aabb_min, input[i]);
+        hull.aabb_max = glm::max(hull.aabb_max, input[i]);
+        sum += points[i];
+    }
+    hull.centroid = glm::vec3(sum / static_cast<double>(hull.vertices.size()));
+    hull.volume = static_cast<float>(volume);
+    return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Convex hull of a point set, for collision tests against the mesh's outline
+struct ConvexHull {
+    std::vector<glm::vec3> vertices; // Corners of the hull, a subset of the points
+    std::vector<glm::vec4> planes; // Unit outward normal and offset, a point p is inside where dot(normal, p) <= offset for all
+    glm::vec3 centroid{}; // Mean of the vertices, inside the hull
+    glm::vec3 aabb_min{}; // Box around the vertices
+    glm::vec3 aabb_max{};
+    float volume{};
+};
+
+// Quickhull: starting from a tetrahedron of extreme points, every face keeps the points outside
+// it. The farthest of them is added by walking from the face to its neighbors that also see the
+// point and replacing them with a cone of faces from their horizon to the point; only the points
+// of the replaced faces are tested again, against the new faces. Coplanar faces share one plane.
+// Returns false and leaves hull empty for flat point sets.
+bool ComputeConvexHull(const glm::vec3* points, size_t count, ConvexHull& hull);
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cmath>
+
+#include "DynamicAabbTree.hpp"
+
+namespace {
+
+float SurfaceArea(const glm::vec3& aabb_min, const glm::vec3& aabb_max)
+{
+    const glm::vec3 size = aabb_max - aabb_min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool Contains(const glm::vec3& outer_min, const glm::vec3& outer_max, const glm::vec3& inner_min, const glm::vec3& inner_max)
+{
+    return glm::all(glm::lessThanEqual(outer_min, inner_min)) && glm::all(glm::lessThanEqual(inner_max, outer_max));
+}
+
+bool Overlaps(const glm::vec3& a_min, const glm::vec3& a_max, const glm::vec3& b_min, const glm::vec3& b_max)
+{
+    return glm::all(glm::lessThanEqual(a_min, b_max)) && glm::all(glm::lessThanEqual(b_min, a_max));
+}
+
+} // namespace
+
+int DynamicAabbTree::AllocateNode()
+{
+    if (free_list == NULL_NODE) {
+        nodes.emplace_back();
+        return static_cast<int>(nodes.size()) - 1;
+    }
+    const int node = free_list;
+    free_list = nodes[node].parent;
+    nodes[node] = Node();
+    return node;
+}
+
+void DynamicAabbTree::FreeNode(int node)
+{
+    nodes[node] = Node();
+    nodes[node].parent = free_list;
+    free_list = node;
+}
+
+int DynamicAabbTree::CreateProxy(const glm::vec3& aabb_min, const glm::vec3& aabb_max, void* user_data)
+{
+    const int proxy = AllocateNode();
+    Node& node = nodes[proxy];
+    node.aabb_min = aabb_min - glm::vec3(AABB_TREE_MARGIN);
+    node.aabb_max = aabb_max + glm::vec3(AABB_TREE_MARGIN);
+    node.user_data = user_data;
+    node.height = 0;
+    InsertLeaf(proxy);
+    proxy_count++;
+    return proxy;
+}
+
+void DynamicAabbTree::DestroyProxy(int proxy)
+{
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    proxy_count--;
+}
+
+bool DynamicAabbTree::MoveProxy(int proxy, const glm::vec3& aabb_min, const glm::vec3& aabb_max)
+{
+    if (Contains(nodes[proxy].aabb_min, nodes[proxy].aabb_max, aabb_min, aabb_max))
+        return false;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].aabb_min = aabb_min - glm::vec3(AABB_TREE_MARGIN);
+    nodes[proxy].aabb_max = aabb_max + glm::vec3(AABB_TREE_MARGIN);
+    InsertLeaf(proxy);
+    return true;
+}
+
+void DynamicAabbTree::Clear()
+{
+    nodes.clear();
+    root = NULL_NODE;
+    free_list = NULL_NODE;
+    proxy_count = 0;
+}
+
+void DynamicAabbTree::Refit(int node)
+{
+    Node& parent = nodes[node];
+    const Node& child1 = nodes[parent.child1];
+    const Node& child2 = nodes[parent.child2];
+    parent.aabb_min = glm::min(child1.aabb_min, child2.aabb_min);
+    parent.aabb_max = glm::max(child1.aabb_max, child2.aabb_max);
+    parent.height = 1 + std::max(child1.height, child2.height);
+}
+
+void DynamicAabbTree::InsertLeaf(int leaf)
+{
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend while pushing the leaf further down is cheaper than pairing it with the current node
+    const glm::vec3 leaf_min = nodes[leaf].aabb_min, leaf_max = nodes[leaf].aabb_max;
+    int index = root;
+    while (!nodes[index].IsLeaf()) {
+        const Node& node = nodes[index];
+        const float area = SurfaceArea(node.aabb_min, node.aabb_max);
+        const float combined_area = SurfaceArea(glm::min(node.aabb_min, leaf_min), glm::max(node.aabb_max, leaf_max));
+
+        // A new parent here costs its area, every ancestor grows by the leaf anyway
+        const float cost = 2.0f * combined_area;
+        const float inherited_cost = 2.0f * (combined_area - area);
+
+        auto child_cost = [&](int child_index) {
+            const Node& child = nodes[child_index];
+            const float grown_area = SurfaceArea(glm::min(child.aabb_min, leaf_min), glm::max(child.aabb_max, leaf_max));
+            if (child.IsLeaf())
+                return grown_area + inherited_cost;
+            return grown_area - SurfaceArea(child.aabb_min, child.aabb_max) + inherited_cost;
+        };
+        const float cost1 = child_cost(node.child1);
+        const float cost2 = child_cost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+    const int sibling = index;
+
+    // New parent of the sibling and the leaf, in the sibling's place
+    const int old_parent = nodes[sibling].parent;
+    const int new_parent = AllocateNode();
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].aabb_min = glm::min(nodes[sibling].aabb_min, leaf_min);
+    nodes[new_parent].aabb_max = glm::max(nodes[sibling].aabb_max, leaf_max);
+    nodes[new_parent].height = nodes[sibling].height + 1;
+    nodes[new_parent].child1 = sibling;
+    nodes[new_parent].child2 = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+    if (old_parent == NULL_NODE)
+        root = new_parent;
+    else if (nodes[old_parent].child1 == sibling)
+        nodes[old_parent].child1 = new_parent;
+    else
+        nodes[old_parent].child2 = new_parent;
+
+    // Refit and rebalance the ancestors
+    for (index = nodes[leaf].parent; index != NULL_NODE; index = nodes[index].parent) {
+        index = Balance(index);
+        Refit(index);
+    }
+}
+
+void DynamicAabbTree::RemoveLeaf(int leaf)
+{
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    // The sibling takes the parent's place
+    const int parent = nodes[leaf].parent;
+    const int grand_parent = nodes[parent].parent;
+    const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    FreeNode(parent);
+    nodes[sibling].parent = grand_parent;
+    if (grand_parent == NULL_NODE) {
+        root = sibling;
+        return;
+    }
+    if (nodes[grand_parent].child1 == parent)
+        nodes[grand_parent].child1 = sibling;
+    else
+        nodes[grand_parent].child2 = sibling;
+
+    for (int index = grand_parent; index != NULL_NODE; index = nodes[index].parent) {
+        index = Balance(index);
+        Refit(index);
+    }
+}
+
+int DynamicAabbTree::Balance(int a)
+{
+    if (nodes[a].IsLeaf() || nodes[a].height < 2)
+        return a;
+
+    const int b = nodes[a].child1, c = nodes[a].child2;
+    const int balance = nodes[c].height - nodes[b].height;
+    if (balance >= -1 && balance <= 1)
+        return a;
+
+    // Rotation: the taller child "up" takes a's place, a becomes its child and keeps its own
+    // shorter child plus up's shorter child, up keeps its taller child
+    const bool c_taller = balance > 1;
+    const int up = c_taller ? c : b;
+    const int f = nodes[up].child1, g = nodes[up].child2;
+    const int tall = nodes[f].height > nodes[g].height ? f : g;
+    const int other = tall == f ? g : f;
+
+    nodes[up].child1 = a;
+    nodes[up].child2 = tall;
+    nodes[up].parent = nodes[a].parent;
+    nodes[a].parent = up;
+    if (nodes[up].parent == NULL_NODE)
+        root = up;
+    else if (nodes[nodes[up].parent].child1 == a)
+        nodes[nodes[up].parent].child1 = up;
+    else
+        nodes[nodes[up].parent].child2 = up;
+
+    // a keeps the shorter child in the up child's former place
+    if (c_taller)
+        nodes[a].child2 = other;
+    else
+        nodes[a].child1 = other;
+    nodes[other].parent = a;
+
+    Refit(a);
+    Refit(up);
+    return up;
+}
+
+void DynamicAabbTree::QueryAabb(const glm::vec3& aabb_min, const glm::vec3& aabb_max, const Visitor& visit) const
+{
+    if (root == NULL_NODE)
+        return;
+    std::vector<int> stack{ root };
+    while (!stack.empty()) {
+        const int index = stack.back();
+        const Node& node = nodes[index];
+        stack.pop_back();
+        if (!Overlaps(node.aabb_min, node.aabb_max, aabb_min, aabb_max))
+            continue;
+        if (node.IsLeaf()) {
+            if (!visit(index))
+                return;
+            continue;
+        }
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+    }
+}
+
+void DynamicAabbTree::QuerySphere(const glm::vec3& center, float radius, const Visitor& visit) const
+{
+    if (root == NULL_NODE)
+        return;
+    std::vector<int> stack{ root };
+    while (!stack.empty()) {
+        const int index = stack.back();
+        const Node& node = nodes[index];
+        stack.pop_back();
+        const glm::vec3 offset = glm::clamp(center, node.aabb_min, node.aabb_max) - center;
+        if (glm::dot(offset, offset) > radius * radius)
+            continue;
+        if (node.IsLeaf()) {
+            if (!visit(index))
+                return;
+            continue;
+        }
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+    }
+}
+
+void DynamicAabbTree::QueryFrustum(const Frustum& frustum, const Visitor& visit) const
+{
+    if (root == NULL_NODE)
+        return;
+    std::vector<int> stack{ root };
+    while (!stack.empty()) {
+        const int index = stack.back();
+        const Node& node = nodes[index];
+        stack.pop_back();
+        if (!frustum.IntersectsAabb(node.aabb_min, node.aabb_max))
+            continue;
+        if (node.IsLeaf()) {
+            if (!visit(index))
+                return;
+            continue;
+        }
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+    }
+}
+
+void DynamicAabbTree::Raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, const RayVisitor& visit) const
+{
+    const float length = glm::length(direction);
+    if (root == NULL_NODE || length == 0.0f || !(max_distance > 0.0f))
+        return;
+
+    // Slab test against the fat boxes, axes the ray is parallel to are tested separately
+    const glm::vec3 unit = direction / length;
+    const glm::vec3 inverse = 1.0f / unit;
+    std::vector<int> stack{ root };
+    while (!stack.empty()) {
+        const int index = stack.back();
+        const Node& node = nodes[index];
+        stack.pop_back();
+
+        float t_near = 0.0f, t_far = max_distance;
+        bool missed = false;
+        for (int axis = 0; axis < 3 && !missed; axis++) {
+            if (unit[axis] == 0.0f) {
+                missed = origin[axis] < node.aabb_min[axis] || origin[axis] > node.aabb_max[axis];
+                continue;
+            }
+            float t0 = (node.aabb_min[axis] - origin[axis]) * inverse[axis];
+            float t1 = (node.aabb_max[axis] - origin[axis]) * inverse[axis];
+            t_near = std::max(t_near, std::min(t0, t1));
+            t_far = std::min(t_far, std::max(t0, t1));
+            missed = t_near > t_far;
+        }
+        if (missed)
+            continue;
+
+        if (node.IsLeaf()) {
+            const float clipped = visit(index, max_distance);
+            if (clipped == 0.0f)
+                return;
+            if (clipped > 0.0f)
+                max_distance = std::min(max_distance, clipped);
+            continue;
+        }
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+    }
+}
+
+void DynamicAabbTree::Segment(const glm::vec3& from, const glm::vec3& to, const RayVisitor& visit) const
+{
+    Raycast(from, to - from, glm::length(to - from), visit);
+}
+
+float DynamicAabbTree::AreaRatio() const
+{
+    if (root == NULL_NODE)
+        return 0.0f;
+    float total_area = 0.0f;
+    for (const Node& node : nodes) {
+        if (node.height >= 0)
+            total_area += SurfaceArea(node.aabb_min, node.aabb_max);
+    }
+    return total_area / SurfaceArea(nodes[root].aabb_min, nodes[root].aabb_max);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+
+constexpr float AABB_TREE_MARGIN = 0.2f; // World units added around every proxy box, moves within it do not touch the tree
+
+// Bounding volume hierarchy over moving boxes (dynamic AABB tree, as in Box2D)
+//
+// Leaves hold proxies: the box of an object grown by AABB_TREE_MARGIN ("fat" box). A new leaf
+// goes next to the sibling that grows the tree's surface area least (surface area heuristic,
+// branch and bound), then the ancestors are refitted and rotated where one side has grown two
+// levels taller than the other. MoveProxy() only reinserts when the tight box leaves its fat box.
+//
+// Queries visit the proxies whose fat boxes pass a test, the visitor runs the exact test and
+// returns whether to go on. Ray visitors instead return the distance the ray is clipped to:
+// the distance of an exact hit to keep only closer ones, max_distance to continue, 0 to stop.
+class DynamicAabbTree
+{
+public:
+    using Visitor = std::function<bool(int proxy)>;
+    using RayVisitor = std::function<float(int proxy, float max_distance)>;
+
+    int CreateProxy(const glm::vec3& aabb_min, const glm::vec3& aabb_max, void* user_data); // Returns the proxy id
+    void DestroyProxy(int proxy);
+    bool MoveProxy(int proxy, const glm::vec3& aabb_min, const glm::vec3& aabb_max); // true when the proxy was reinserted
+    void Clear();
+
+    void* UserData(int proxy) const { return nodes[proxy].user_data; }
+    const glm::vec3& FatMin(int proxy) const { return nodes[proxy].aabb_min; }
+    const glm::vec3& FatMax(int proxy) const { return nodes[proxy].aabb_max; }
+
+    void QueryAabb(const glm::vec3& aabb_min, const glm::vec3& aabb_max, const Visitor& visit) const;
+    void QuerySphere(const glm::vec3& center, float radius, const Visitor& visit) const;
+    void QueryFrustum(const Frustum& frustum, const Visitor& visit) const;
+    void Raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, const RayVisitor& visit) const; // direction need not be normalized
+    void Segment(const glm::vec3& from, const glm::vec3& to, const RayVisitor& visit) const; // Distances from "from"
+
+    int Height() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+    int ProxyCount() const { return proxy_count; }
+    float AreaRatio() const; // Summed area of all nodes over the root's, lower is a better tree
+
+private:
+    static constexpr int NULL_NODE = -1;
+
+    struct Node {
+        glm::vec3 aabb_min{ 0.0f }, aabb_max{ 0.0f };
+        void* user_data = nullptr;
+        int parent = NULL_NODE; // Next free node while on the free list
+        int child1 = NULL_NODE, child2 = NULL_NODE;
+        int height = -1; // Leaves are 0, free nodes -1
+
+        bool IsLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    std::vector<Node> nodes;
+    int root = NULL_NODE;
+    int free_list = NULL_NODE;
+    int proxy_count = 0;
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int node); // Rotates node's subtree if unbalanced, returns its new root
+    void Refit(int node); // Box and height from the children
+};
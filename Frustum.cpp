@@ -0,0 +1,41 @@
+#include "Frustum.hpp"
+
+Frustum::Frustum(const glm::mat4& view_projection)
+{
+    // glm is column-major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i) {
+        return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+    };
+    planes[0] = row(3) + row(0);
+    planes[1] = row(3) - row(0);
+    planes[2] = row(3) + row(1);
+    planes[3] = row(3) - row(1);
+    planes[4] = row(3) + row(2);
+    planes[5] = row(3) - row(2);
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool Frustum::IntersectsAabb(const glm::vec3& aabb_min, const glm::vec3& aabb_max) const
+{
+    for (const auto& plane : planes) {
+        // Corner furthest along the plane normal, the box is outside if even that one is behind the plane
+        glm::vec3 corner(
+            plane.x >= 0.0f ? aabb_max.x : aabb_min.x,
+            plane.y >= 0.0f ? aabb_max.y : aabb_min.y,
+            plane.z >= 0.0f ? aabb_max.z : aabb_min.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const auto& plane : planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
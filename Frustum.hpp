@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six planes, extracted from a projection * view matrix (Gribb & Hartmann)
+// Planes point inwards: dot(plane.xyz, point) + plane.w >= 0 inside
+class Frustum
+{
+public:
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& view_projection);
+
+    // Conservative: a box near a frustum corner may pass although it is outside
+    bool IntersectsAabb(const glm::vec3& aabb_min, const glm::vec3& aabb_max) const;
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+
+private:
+    glm::vec4 planes[6]{}; // Left, right, bottom, top, near, far; normalized
+};
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HEIGHT_FIELD_SSE2 1
+#include <emmintrin.h>
+#else
+#define HEIGHT_FIELD_SSE2 0
+#endif
+
+#include "HeightField.hpp"
+
+void HeightField::Attach(const HeightmapPager* pager)
+{
+    this->pager = pager && pager->IsOpen() ? pager : nullptr;
+    width = this->pager ? pager->Map().Width() : 0;
+    depth = this->pager ? pager->Map().Depth() : 0;
+}
+
+void HeightField::SetTransform(const glm::vec3& origin, float spacing, float height_scale)
+{
+    this->origin = origin;
+    this->spacing = spacing;
+    this->height_scale = height_scale;
+}
+
+void HeightField::QuadCorners(int column, int row, float corners[4]) const
+{
+    const TiledHeightmap& map = pager->Map();
+    const int tile_size = map.TileSize();
+    column = std::clamp(column, 0, std::max(width - 2, 0));
+    row = std::clamp(row, 0, std::max(depth - 2, 0));
+    const int tile_x = std::min(column / tile_size, map.TilesX() - 1), tile_z = std::min(row / tile_size, map.TilesZ() - 1);
+
+    const uint16_t* samples = pager->TileSamples(tile_x, tile_z) +
+        static_cast<size_t>(row - tile_z * tile_size) * (tile_size + 1) + (column - tile_x * tile_size);
+    corners[0] = samples[0] * TILED_HEIGHTMAP_UNIT;
+    corners[1] = samples[1] * TILED_HEIGHTMAP_UNIT;
+    corners[2] = samples[tile_size + 1] * TILED_HEIGHTMAP_UNIT;
+    corners[3] = samples[tile_size + 2] * TILED_HEIGHTMAP_UNIT;
+}
+
+float HeightField::Sample(float x, float z) const
+{
+    if (IsEmpty())
+        return origin.y;
+
+    // Position in quads, clamped to the map
+    const int quads_x = width - 1, quads_z = depth - 1;
+    float fx = std::clamp((x - origin.x) / spacing, 0.0f, static_cast<float>(quads_x));
+    float fz = std::clamp((z - origin.z) / spacing, 0.0f, static_cast<float>(quads_z));
+    int column = std::min(static_cast<int>(fx), quads_x - 1);
+    int row = std::min(static_cast<int>(fz), quads_z - 1);
+    float tx = fx - column;
+    float tz = fz - row;
+
+    float corners[4];
+    QuadCorners(column, row, corners);
+    const float h00 = corners[0], h10 = corners[1], h01 = corners[2], h11 = corners[3];
+
+    // Triangle (0,0)-(1,0)-(1,1) below the diagonal, (0,0)-(1,1)-(0,1) above it
+    float h = tx >= tz
+        ? h00 + tx * (h10 - h00) + tz * (h11 - h10)
+        : h00 + tz * (h01 - h00) + tx * (h11 - h01);
+    return origin.y + h * height_scale;
+}
+
+void HeightField::SampleBatch(const float* x, const float* z, float* y, size_t count) const
+{
+    size_t i = 0;
+#if HEIGHT_FIELD_SSE2
+    if (!IsEmpty()) {
+        const int quads_x = width - 1, quads_z = depth - 1;
+        const __m128 inverse_spacing = _mm_set1_ps(1.0f / spacing);
+        const __m128 origin_x = _mm_set1_ps(origin.x), origin_z = _mm_set1_ps(origin.z);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 max_x = _mm_set1_ps(static_cast<float>(quads_x)), max_z = _mm_set1_ps(static_cast<float>(quads_z));
+        const __m128i last_x = _mm_set1_epi32(quads_x - 1), last_z = _mm_set1_epi32(quads_z - 1);
+        const TiledHeightmap& map = pager->Map();
+        const int tile_size = map.TileSize(), row_samples = tile_size + 1;
+        int tile = -1; // Last tile looked up, nearby points mostly share it
+        const uint16_t* samples = nullptr;
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 fx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), origin_x), inverse_spacing);
+            __m128 fz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(z + i), origin_z), inverse_spacing);
+            fx = _mm_min_ps(_mm_max_ps(fx, zero), max_x);
+            fz = _mm_min_ps(_mm_max_ps(fz, zero), max_z);
+
+            // Non-negative, so truncation is floor; the far edge belongs to the last quad
+            __m128i cx = _mm_cvttps_epi32(fx), cz = _mm_cvttps_epi32(fz);
+            __m128i over_x = _mm_cmpgt_epi32(cx, last_x), over_z = _mm_cmpgt_epi32(cz, last_z);
+            cx = _mm_or_si128(_mm_and_si128(over_x, last_x), _mm_andnot_si128(over_x, cx));
+            cz = _mm_or_si128(_mm_and_si128(over_z, last_z), _mm_andnot_si128(over_z, cz));
+            __m128 tx = _mm_sub_ps(fx, _mm_cvtepi32_ps(cx));
+            __m128 tz = _mm_sub_ps(fz, _mm_cvtepi32_ps(cz));
+
+            // No gather in SSE2, the corners are loaded per lane from the one tile holding the lane's quad
+            alignas(16) int32_t lane_x[4], lane_z[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lane_x), cx);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lane_z), cz);
+            alignas(16) float c00[4], c10[4], c01[4], c11[4];
+            for (int lane = 0; lane < 4; lane++) {
+                const int tile_x = std::min(lane_x[lane] / tile_size, map.TilesX() - 1);
+                const int tile_z = std::min(lane_z[lane] / tile_size, map.TilesZ() - 1);
+                if (tile_z * map.TilesX() + tile_x != tile) {
+                    tile = tile_z * map.TilesX() + tile_x;
+                    samples = pager->TileSamples(tile_x, tile_z);
+                }
+                const uint16_t* corner = samples + static_cast<size_t>(lane_z[lane] - tile_z * tile_size) * row_samples + (lane_x[lane] - tile_x * tile_size);
+                c00[lane] = corner[0] * TILED_HEIGHTMAP_UNIT;
+                c10[lane] = corner[1] * TILED_HEIGHTMAP_UNIT;
+                c01[lane] = corner[row_samples] * TILED_HEIGHTMAP_UNIT;
+                c11[lane] = corner[row_samples + 1] * TILED_HEIGHTMAP_UNIT;
+            }
+            __m128 h00 = _mm_load_ps(c00), h10 = _mm_load_ps(c10), h01 = _mm_load_ps(c01), h11 = _mm_load_ps(c11);
+
+            __m128 lower = _mm_add_ps(h00, _mm_add_ps(_mm_mul_ps(tx, _mm_sub_ps(h10, h00)), _mm_mul_ps(tz, _mm_sub_ps(h11, h10))));
+            __m128 upper = _mm_add_ps(h00, _mm_add_ps(_mm_mul_ps(tz, _mm_sub_ps(h01, h00)), _mm_mul_ps(tx, _mm_sub_ps(h11, h01))));
+            __m128 below_diagonal = _mm_cmpge_ps(tx, tz);
+            __m128 h = _mm_or_ps(_mm_and_ps(below_diagonal, lower), _mm_andnot_ps(below_diagonal, upper));
+
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_set1_ps(origin.y), _mm_mul_ps(h, _mm_set1_ps(height_scale))));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        y[i] = Sample(x[i], z[i]);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "HeightmapPager.hpp"
+
+// Height samples of a terrain at full source resolution, read through a HeightmapPager
+//
+// Sampling matches the full detail terrain mesh exactly: each quad is split along the diagonal
+// from (x, z) to (x + 1, z + 1). Positions outside the map are clamped to its edge. Samples of
+// tiles that are not resident come from the mapped file, so any position can be sampled.
+class HeightField
+{
+public:
+    HeightField() = default;
+
+    // Samples pager's heightmap, the pager must outlive the field; nullptr empties the field
+    void Attach(const HeightmapPager* pager);
+
+    // Placement in the world: sample (column, row) is at origin + (column, height, row) * (spacing, height_scale, spacing)
+    void SetTransform(const glm::vec3& origin, float spacing, float height_scale);
+
+    bool IsEmpty() const { return pager == nullptr; }
+    int Width() const { return width; }
+    int Depth() const { return depth; }
+
+    float At(int column, int row) const { return pager->Height(column, row); } // Sample value, coordinates clamped to the map
+    // Sample values at the corners (column, row), (column + 1, row), (column, row + 1), (column + 1, row + 1) of a quad
+    // clamped to the map; neighboring tiles share their edges, so all four come from one tile lookup
+    void QuadCorners(int column, int row, float corners[4]) const;
+
+    // World height of the rendered surface at world (x, z)
+    float Sample(float x, float z) const;
+    // Same for count points at once, SSE2 four at a time; the tile is looked up again only where it changes
+    void SampleBatch(const float* x, const float* z, float* y, size_t count) const;
+
+    glm::vec3 Origin() const { return origin; }
+    float Spacing() const { return spacing; }
+    float HeightScale() const { return height_scale; }
+
+private:
+    const HeightmapPager* pager = nullptr;
+    int width = 0, depth = 0;
+
+    glm::vec3 origin{ 0.0f };
+    float spacing = 1.0f;
+    float height_scale = 1.0f;
+};
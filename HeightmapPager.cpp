@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstring>
+
+#include "HeightmapPager.hpp"
+#include "ThreadPool.hpp"
+
+void HeightmapPager::Open(std::shared_ptr<const TiledHeightmap> map, size_t budget_bytes)
+{
+    this->map = std::move(map);
+    const int tile_count = this->map->TilesX() * this->map->TilesZ();
+    const size_t slot_bytes = this->map->TileSamples() * sizeof(uint16_t) * 2;
+    const size_t slot_count = std::clamp<size_t>(budget_bytes / slot_bytes, 1, static_cast<size_t>(tile_count));
+
+    slots.assign(slot_count, Slot());
+    tile_slots.assign(tile_count, -1);
+    wanted_stamps.assign(tile_count, 0);
+    wanted.clear();
+    completions = std::make_shared<Completions>();
+    loads_in_flight = 0;
+    resident_count = 0;
+    center_x = center_z = -1;
+}
+
+void HeightmapPager::Want(int center_tile_x, int center_tile_z)
+{
+    center_x = center_tile_x;
+    center_z = center_tile_z;
+
+    // Smallest square around the center with a tile for every slot, clipped to the map
+    const int tiles_x = map->TilesX(), tiles_z = map->TilesZ();
+    int radius = 0;
+    while ((2 * radius + 1) * (2 * radius + 1) < SlotCount() && radius < std::max(tiles_x, tiles_z))
+        radius++;
+
+    wanted.clear();
+    for (int z = std::max(center_z - radius, 0); z <= std::min(center_z + radius, tiles_z - 1); z++)
+        for (int x = std::max(center_x - radius, 0); x <= std::min(center_x + radius, tiles_x - 1); x++)
+            wanted.push_back(z * tiles_x + x);
+
+    auto distance = [&](int tile) {
+        int dx = tile % tiles_x - center_x, dz = tile / tiles_x - center_z;
+        return dx * dx + dz * dz;
+    };
+    std::stable_sort(wanted.begin(), wanted.end(), [&](int a, int b) { return distance(a) < distance(b); });
+    if (wanted.size() > slots.size())
+        wanted.resize(slots.size());
+
+    wanted_stamp++;
+    for (int tile : wanted)
+        wanted_stamps[tile] = wanted_stamp;
+}
+
+int HeightmapPager::FindSlot(float column, float row, std::vector<Event>& events)
+{
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i].state == SlotState::Free)
+            return static_cast<int>(i);
+    }
+
+    const int tiles_x = map->TilesX(), tile_size = map->TileSize();
+    int farthest = -1;
+    float farthest_distance = -1.0f;
+    for (size_t i = 0; i < slots.size(); i++) {
+        const Slot& slot = slots[i];
+        if (slot.state != SlotState::Resident || wanted_stamps[slot.tile] == wanted_stamp)
+            continue;
+        float dx = (slot.tile % tiles_x + 0.5f) * tile_size - column;
+        float dz = (slot.tile / tiles_x + 0.5f) * tile_size - row;
+        float distance = dx * dx + dz * dz;
+        if (distance > farthest_distance) {
+            farthest_distance = distance;
+            farthest = static_cast<int>(i);
+        }
+    }
+    if (farthest < 0)
+        return -1;
+
+    Slot& slot = slots[farthest];
+    events.push_back({ slot.tile % tiles_x, slot.tile / tiles_x, farthest, nullptr });
+    tile_slots[slot.tile] = -1;
+    slot.tile = -1;
+    slot.state = SlotState::Free;
+    resident_count--;
+    return farthest;
+}
+
+void HeightmapPager::StartLoad(int slot_index, int tile)
+{
+    Slot& slot = slots[slot_index];
+    slot.state = SlotState::Loading;
+    slot.tile = tile;
+    tile_slots[tile] = slot_index;
+    if (!slot.samples)
+        slot.samples = std::make_shared<std::vector<uint16_t>>(map->TileSamples());
+    loads_in_flight++;
+
+    // Touching the mapped pages is what reads the tile from disk, so the copy runs on a worker
+    const int tile_x = tile % map->TilesX(), tile_z = tile / map->TilesX();
+    ThreadPool::Shared().Submit([map = map, samples = slot.samples, completions = completions, slot_index, tile_x, tile_z]() {
+        std::memcpy(samples->data(), map->Tile(tile_x, tile_z), samples->size() * sizeof(uint16_t));
+        std::lock_guard<std::mutex> lock(completions->mutex);
+        completions->slots.push_back(slot_index);
+    });
+}
+
+void HeightmapPager::Update(float column, float row, std::vector<Event>& events)
+{
+    if (!map)
+        return;
+
+    std::vector<int> completed;
+    {
+        std::lock_guard<std::mutex> lock(completions->mutex);
+        completed.swap(completions->slots);
+    }
+    for (int slot_index : completed) {
+        Slot& slot = slots[slot_index];
+        slot.state = SlotState::Resident;
+        loads_in_flight--;
+        resident_count++;
+        events.push_back({ slot.tile % map->TilesX(), slot.tile / map->TilesX(), slot_index, slot.samples->data() });
+    }
+
+    const int tile_size = map->TileSize();
+    const int tile_x = std::clamp(static_cast<int>(column) / tile_size, 0, map->TilesX() - 1);
+    const int tile_z = std::clamp(static_cast<int>(row) / tile_size, 0, map->TilesZ() - 1);
+    if (tile_x != center_x || tile_z != center_z)
+        Want(tile_x, tile_z);
+
+    // Nearest missing tiles first
+    for (int tile : wanted) {
+        if (loads_in_flight >= HEIGHTMAP_PAGER_MAX_LOADS)
+            break;
+        if (tile_slots[tile] >= 0)
+            continue;
+        int slot_index = FindSlot(column, row, events);
+        if (slot_index < 0)
+            break;
+        StartLoad(slot_index, tile);
+    }
+}
+
+float HeightmapPager::Height(int column, int row) const
+{
+    const int tile_size = map->TileSize();
+    column = std::clamp(column, 0, map->Width() - 1);
+    row = std::clamp(row, 0, map->Depth() - 1);
+    const int tile_x = std::min(column / tile_size, map->TilesX() - 1), tile_z = std::min(row / tile_size, map->TilesZ() - 1);
+
+    const size_t local = static_cast<size_t>(row - tile_z * tile_size) * (tile_size + 1) + (column - tile_x * tile_size);
+    return TileSamples(tile_x, tile_z)[local] * TILED_HEIGHTMAP_UNIT;
+}
+
+const uint16_t* HeightmapPager::TileSamples(int tile_x, int tile_z) const
+{
+    const int slot_index = tile_slots[static_cast<size_t>(tile_z) * map->TilesX() + tile_x];
+    if (slot_index < 0 || slots[slot_index].state != SlotState::Resident)
+        return map->Tile(tile_x, tile_z);
+    return slots[slot_index].samples->data();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TiledHeightmap.hpp"
+
+constexpr size_t HEIGHTMAP_PAGER_BUDGET = 64ull << 20; // Bytes for resident tiles, counting their CPU and GPU copies
+constexpr int HEIGHTMAP_PAGER_MAX_LOADS = 8; // Tile loads in flight at once
+
+// Keeps the tiles of a TiledHeightmap around a position resident within a fixed memory budget
+//
+// The budget is split into slots of one tile each. Update() wants the tiles nearest to the given
+// position, evicts the farthest resident tiles that are no longer wanted and copies the missing
+// ones out of the mapping on the shared thread pool. Arrivals and evictions are reported as events
+// so that the renderer can update its GPU copy incrementally. Height() reads a resident tile and
+// falls back to the mapping for the others, so every sample is available at any time.
+//
+// Update() and Height() belong to one thread, the loads only touch their slot's buffer.
+class HeightmapPager
+{
+public:
+    // A tile arrived in a slot (samples valid until the next Update()) or was evicted from it (samples nullptr)
+    struct Event {
+        int tile_x, tile_z;
+        int slot;
+        const uint16_t* samples;
+    };
+
+    HeightmapPager() = default;
+    HeightmapPager(const HeightmapPager&) = delete;
+    HeightmapPager& operator=(const HeightmapPager&) = delete;
+
+    // Sizes the slots to budget_bytes, at least one and at most one per tile
+    void Open(std::shared_ptr<const TiledHeightmap> map, size_t budget_bytes = HEIGHTMAP_PAGER_BUDGET);
+    bool IsOpen() const { return map != nullptr; }
+    const TiledHeightmap& Map() const { return *map; }
+
+    // Streams around sample position (column, row), appends what changed since the last call to events
+    void Update(float column, float row, std::vector<Event>& events);
+
+    float Height(int column, int row) const; // Sample value, coordinates clamped to the map
+    // Raw samples of a tile, (tile_size + 1) per row: the resident copy, or the mapping while it is not resident
+    const uint16_t* TileSamples(int tile_x, int tile_z) const;
+    int SlotCount() const { return static_cast<int>(slots.size()); }
+    int ResidentCount() const { return resident_count; }
+
+private:
+    enum class SlotState { Free, Loading, Resident };
+    struct Slot {
+        SlotState state = SlotState::Free;
+        int tile = -1; // tile_z * TilesX() + tile_x
+        std::shared_ptr<std::vector<uint16_t>> samples; // Allocated on first use, written by the load
+    };
+
+    // Slots whose load finished, shared with the loads so that they may outlive the pager
+    struct Completions {
+        std::mutex mutex;
+        std::vector<int> slots;
+    };
+
+    std::shared_ptr<const TiledHeightmap> map;
+    std::vector<Slot> slots;
+    std::vector<int> tile_slots; // Slot holding or loading each tile, -1 for none
+    std::shared_ptr<Completions> completions = std::make_shared<Completions>();
+    int loads_in_flight = 0;
+    int resident_count = 0;
+
+    std::vector<int> wanted; // Tiles nearest to the last position, nearest first
+    std::vector<uint32_t> wanted_stamps; // Per tile, equal to wanted_stamp while the tile is wanted
+    uint32_t wanted_stamp = 0;
+    int center_x = -1, center_z = -1; // Tile containing the last position
+
+    void Want(int center_tile_x, int center_tile_z); // Rebuilds wanted around the tile
+    int FindSlot(float column, float row, std::vector<Event>& events); // Free slot, or evicts the farthest unwanted resident tile; -1 when none
+    void StartLoad(int slot, int tile);
+};
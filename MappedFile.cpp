@@ -0,0 +1,172 @@
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.hpp"
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    Open(path);
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    MoveFrom(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        Close();
+        MoveFrom(other);
+    }
+    return *this;
+}
+
+void MappedFile::MoveFrom(MappedFile& other) noexcept
+{
+    is_open = other.is_open;
+    data = other.data;
+    size = other.size;
+#ifdef _WIN32
+    file_handle = other.file_handle;
+    mapping_handle = other.mapping_handle;
+    other.file_handle = nullptr;
+    other.mapping_handle = nullptr;
+#else
+    file_descriptor = other.file_descriptor;
+    other.file_descriptor = -1;
+#endif
+    other.is_open = false;
+    other.data = nullptr;
+    other.size = 0;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+    Close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "MappedFile: cannot open " << path << "\n";
+        return false;
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size)) {
+        std::cerr << "MappedFile: cannot get size of " << path << "\n";
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    size = static_cast<size_t>(file_size.QuadPart);
+    is_open = true;
+
+    // Zero-length files cannot be mapped, but they are still valid (empty) files
+    if (size == 0)
+        return true;
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        std::cerr << "MappedFile: cannot create mapping of " << path << "\n";
+        Close();
+        return false;
+    }
+    mapping_handle = mapping;
+
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+        std::cerr << "MappedFile: cannot map " << path << "\n";
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mapping_handle != nullptr)
+        CloseHandle(mapping_handle);
+    if (file_handle != nullptr)
+        CloseHandle(file_handle);
+
+    data = nullptr;
+    size = 0;
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+    is_open = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "MappedFile: cannot open " << path << "\n";
+        return false;
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0) {
+        std::cerr << "MappedFile: cannot get size of " << path << "\n";
+        close(fd);
+        return false;
+    }
+
+    file_descriptor = fd;
+    size = static_cast<size_t>(file_stat.st_size);
+    is_open = true;
+
+    // Zero-length files cannot be mapped, but they are still valid (empty) files
+    if (size == 0)
+        return true;
+
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "MappedFile: cannot map " << path << "\n";
+        Close();
+        return false;
+    }
+    madvise(view, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(view);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data != nullptr)
+        munmap(const_cast<char*>(data), size);
+    if (file_descriptor >= 0)
+        close(file_descriptor);
+
+    data = nullptr;
+    size = 0;
+    file_descriptor = -1;
+    is_open = false;
+}
+
+#endif
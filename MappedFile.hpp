@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path); // Maps the file, check IsOpen() for success
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const std::filesystem::path& path); // Maps the file, closes any previous mapping
+    void Close(); // Unmaps the file
+
+    bool IsOpen() const { return is_open; }
+    const char* Data() const { return data; } // nullptr for empty files
+    size_t Size() const { return size; }
+
+private:
+    bool is_open = false;
+    const char* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void* file_handle = nullptr; // HANDLE of the opened file
+    void* mapping_handle = nullptr; // HANDLE of the file mapping object
+#else
+    int file_descriptor = -1;
+#endif
+
+    void MoveFrom(MappedFile& other) noexcept;
+};
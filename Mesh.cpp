@@ -1,15 +1,21 @@
+#include <algorithm>
 #include <iostream>
 
 #include "ShaderProgram.hpp"
 #include "Mesh.hpp"
 
 // Constructor for Mesh class
-Mesh::Mesh(GLenum primitive_type, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, GLuint texture_id) :
-    primitive_type(primitive_type),
+Mesh::Mesh(GLenum primitive_type, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const std::vector<MeshLod>& lods) :
     vertices(vertices),
     indices(indices),
-    texture_id(texture_id)
+    lods(lods),
+    primitive_type(primitive_type),
+    index_count(static_cast<GLsizei>(indices.size()))
 {
+    // Without LODs all indices are drawn
+    if (this->lods.empty())
+        this->lods.push_back({ 0, static_cast<GLuint>(indices.size()), 0.0f });
+
     // Generate vertex array object (VAO), vertex buffer object (VBO), and element buffer object (EBO)
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
@@ -38,9 +44,55 @@ Mesh::Mesh(GLenum primitive_type, std::vector<Vertex>& vertices, std::vector<GLu
     glBindVertexArray(0);
 }
 
+// Constructor for the packed vertex layout
+Mesh::Mesh(GLenum primitive_type, const PackedMeshData& packed_data) :
+    lods(packed_data.lods),
+    primitive_type(primitive_type),
+    packed(true),
+    position_offset(packed_data.position_offset),
+    position_scale(packed_data.position_scale)
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, packed_data.vertices.size() * sizeof(PackedVertex), packed_data.vertices.data(), GL_STATIC_DRAW);
+
+    // 16 bit indices whenever the mesh is small enough
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    if (!packed_data.indices32.empty()) {
+        index_type = GL_UNSIGNED_INT;
+        index_count = static_cast<GLsizei>(packed_data.indices32.size());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, packed_data.indices32.size() * sizeof(GLuint), packed_data.indices32.data(), GL_STATIC_DRAW);
+    }
+    else {
+        index_type = GL_UNSIGNED_SHORT;
+        index_count = static_cast<GLsizei>(packed_data.indices16.size());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, packed_data.indices16.size() * sizeof(uint16_t), packed_data.indices16.data(), GL_STATIC_DRAW);
+    }
+    if (lods.empty())
+        lods.push_back({ 0, static_cast<GLuint>(index_count), 0.0f });
+
+    // Position: unorm16 inside the AABB, normal: octahedral snorm16 (z reads as 0), texture coordinates: half floats
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), reinterpret_cast<void*>(offsetof(PackedVertex, position)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), reinterpret_cast<void*>(offsetof(PackedVertex, normal)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), reinterpret_cast<void*>(offsetof(PackedVertex, tex_coords)));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+}
+
 // Draw method to render the mesh
-void Mesh::Draw(ShaderProgram& shader, glm::mat4 mx_model)
+void Mesh::Draw(ShaderProgram& shader, glm::mat4 mx_model, GLuint texture_id, size_t lod)
 {
+    if (lods.empty())
+        return;
+
     // Activate and bind texture if available
     if (texture_id > 0) {
         glActiveTexture(GL_TEXTURE0);
@@ -49,10 +101,17 @@ void Mesh::Draw(ShaderProgram& shader, glm::mat4 mx_model)
     }
     // Set model matrix uniform
     shader.SetUniform("u_mx_model", mx_model);
+    // Vertex decoding, identity for the float layout
+    shader.SetUniform("u_packed_vertex", packed ? 1 : 0);
+    shader.SetUniform("u_position_offset", position_offset);
+    shader.SetUniform("u_position_scale", position_scale);
 
     // Bind vertex array object and draw elements
     glBindVertexArray(VAO);
-    glDrawElements(primitive_type, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+    // Draw the index range of the requested level of detail
+    const MeshLod& range = lods[std::min(lod, lods.size() - 1)];
+    const size_t index_size = index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint);
+    glDrawElements(primitive_type, static_cast<GLsizei>(range.index_count), index_type, reinterpret_cast<void*>(range.index_offset * index_size));
     glBindVertexArray(0);
 }
 
@@ -62,21 +121,22 @@ void Mesh::Clear()
     // Clear vertex and index data
     vertices.clear();
     indices.clear();
+    lods.clear();
     // Reset primitive type to points
     primitive_type = GL_POINTS;
+    index_count = 0;
 
     // Delete vertex buffer and element buffer objects
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
 
+    VBO = 0;
+    EBO = 0;
+
     // Delete vertex array object if exists
     if (VAO != 0) {
         glDeleteVertexArrays(1, &VAO);
         VAO = 0;
     }
-    // Delete texture if exists
-    if (texture_id != 0) {
-        glDeleteTextures(1, &texture_id);
-        texture_id = 0;
-    }
+    // Textures are owned by the asset manager, they may still be used by other meshes
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include <GL/glew.h>
 
+#include "PackedVertex.hpp"
 #include "ShaderProgram.hpp"
 #include "Vertex.hpp"
 
@@ -13,11 +14,12 @@ public:
     // mesh data
     std::vector<Vertex> vertices;
     std::vector<GLuint> indices;
-    GLuint texture_id{ 0 }; // texture id=0  means no texture
+    std::vector<MeshLod> lods; // Index ranges, LOD 0 is full detail, never empty once constructed
     GLenum primitive_type = GL_POINTS;
     ;
-    Mesh(GLenum primitive_type, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, GLuint texture_id);
-    void Draw(ShaderProgram& shader, glm::mat4 mx_model);
+    Mesh(GLenum primitive_type, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const std::vector<MeshLod>& lods = {});
+    Mesh(GLenum primitive_type, const PackedMeshData& packed); // Quantized layout, no CPU side copy is kept
+    void Draw(ShaderProgram& shader, glm::mat4 mx_model, GLuint texture_id, size_t lod = 0); // texture id=0  means no texture
     void Clear();
 
     // Tell the compiler to do what it would have if we didn't define a ctor:
@@ -26,4 +28,11 @@ private:
     // OpenGL buffer IDs
     // ID = 0 is reserved (i.e. uninitalized)
     unsigned int VAO{ 0 }, VBO{ 0 }, EBO{ 0 };
+
+    // Index buffer and vertex decoding state, see shader.vert
+    GLsizei index_count{ 0 };
+    GLenum index_type = GL_UNSIGNED_INT;
+    bool packed = false;
+    glm::vec3 position_offset{ 0.0f };
+    glm::vec3 position_scale{ 1.0f };
 };
\ No newline at end of file
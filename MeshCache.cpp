@@ -0,0 +1,194 @@
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+
+namespace {
+
+int64_t SourceModificationTime(const std::filesystem::path& source_path, std::error_code& error)
+{
+    auto time = std::filesystem::last_write_time(source_path, error);
+    return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+// FNV-1a, 64 bit
+uint64_t HashFile(const std::filesystem::path& path)
+{
+    MappedFile file(path);
+    uint64_t hash = 14695981039346656037ull;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(file.Data());
+    for (size_t i = 0; i < file.Size(); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Indices within the vertices, LOD ranges within the indices, known bounds enums
+bool IsValidMeshData(const MeshData& data)
+{
+    for (GLuint index : data.indices) {
+        if (index >= data.vertices.size())
+            return false;
+    }
+    for (const MeshLod& lod : data.lods) {
+        if (static_cast<uint64_t>(lod.index_offset) + lod.index_count > data.indices.size())
+            return false;
+    }
+    return static_cast<uint32_t>(data.bounds.shape) <= static_cast<uint32_t>(BoundingShape::Hull) &&
+        static_cast<uint32_t>(data.bounds.sphere_method) <= static_cast<uint32_t>(BoundingSphereMethod::Approximate);
+}
+
+} // namespace
+
+std::filesystem::path MeshCachePath(const std::filesystem::path& source_path, BoundingSphereMethod sphere_method)
+{
+    std::filesystem::path cache_path = source_path;
+    if (sphere_method != BoundingSphereMethod::Auto) {
+        cache_path += ".";
+        cache_path += BoundingSphereMethodName(sphere_method);
+    }
+    cache_path += ".pg2mesh";
+    return cache_path;
+}
+
+bool LoadMeshCache(const std::filesystem::path& source_path, BoundingSphereMethod sphere_method, MeshData& data)
+{
+    const auto cache_path = MeshCachePath(source_path, sphere_method);
+
+    std::error_code error;
+    if (!std::filesystem::exists(cache_path, error))
+        return false;
+
+    const uint64_t source_size = std::filesystem::file_size(source_path, error);
+    if (error)
+        return false;
+    const int64_t source_mtime = SourceModificationTime(source_path, error);
+    if (error)
+        return false;
+
+    bool refresh_mtime = false;
+    {
+        MappedFile cache(cache_path);
+        if (!cache.IsOpen() || cache.Size() < sizeof(MeshCacheHeader))
+            return false;
+
+        MeshCacheHeader header;
+        std::memcpy(&header, cache.Data(), sizeof(header));
+        if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != MESH_CACHE_VERSION ||
+            header.vertex_size != sizeof(Vertex) ||
+            header.sphere_method != sphere_method) {
+            std::cout << "MeshCache: Rebuilding outdated cache: " << cache_path << "\n";
+            return false;
+        }
+
+        // Counts are bounded by the file before they are multiplied, a corrupt header cannot overflow the sizes
+        const size_t payload_size = cache.Size() - sizeof(header);
+        if (header.vertex_count > payload_size / sizeof(Vertex) ||
+            header.index_count > payload_size / sizeof(GLuint) ||
+            header.lod_count > payload_size / sizeof(MeshLod)) {
+            std::cout << "MeshCache: Rebuilding truncated cache: " << cache_path << "\n";
+            return false;
+        }
+        const size_t vertex_bytes = header.vertex_count * sizeof(Vertex);
+        const size_t index_bytes = header.index_count * sizeof(GLuint);
+        const size_t lod_bytes = header.lod_count * sizeof(MeshLod);
+        if (cache.Size() != sizeof(header) + vertex_bytes + index_bytes + lod_bytes) {
+            std::cout << "MeshCache: Rebuilding truncated cache: " << cache_path << "\n";
+            return false;
+        }
+
+        // Size and time identify an unchanged source cheaply; a touched but identical file is detected by its hash
+        if (header.source_size != source_size) {
+            std::cout << "MeshCache: Rebuilding stale cache: " << cache_path << "\n";
+            return false;
+        }
+        if (header.source_mtime != source_mtime) {
+            if (HashFile(source_path) != header.source_hash) {
+                std::cout << "MeshCache: Rebuilding stale cache: " << cache_path << "\n";
+                return false;
+            }
+            refresh_mtime = true;
+        }
+
+        const char* payload = cache.Data() + sizeof(header);
+        data.vertices.resize(header.vertex_count);
+        data.indices.resize(header.index_count);
+        data.lods.resize(header.lod_count);
+        std::memcpy(data.vertices.data(), payload, vertex_bytes);
+        std::memcpy(data.indices.data(), payload + vertex_bytes, index_bytes);
+        std::memcpy(data.lods.data(), payload + vertex_bytes + index_bytes, lod_bytes);
+        data.bounds = header.bounds;
+        data.cache_before = header.cache_before;
+        data.cache_after = header.cache_after;
+
+        // A consistent size does not make the contents valid, nothing out of range may reach the draw calls
+        if (!IsValidMeshData(data)) {
+            std::cout << "MeshCache: Rebuilding corrupt cache: " << cache_path << "\n";
+            data = MeshData();
+            return false;
+        }
+    }
+
+    // Store the new time so the next start skips hashing; the mapping is closed by now
+    if (refresh_mtime) {
+        std::fstream cache_file(cache_path, std::ios::in | std::ios::out | std::ios::binary);
+        cache_file.seekp(offsetof(MeshCacheHeader, source_mtime));
+        cache_file.write(reinterpret_cast<const char*>(&source_mtime), sizeof(source_mtime));
+    }
+
+    return true;
+}
+
+bool SaveMeshCache(const std::filesystem::path& source_path, BoundingSphereMethod sphere_method, const MeshData& data)
+{
+    const auto cache_path = MeshCachePath(source_path, sphere_method);
+
+    std::error_code error;
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.vertex_size = sizeof(Vertex);
+    header.source_size = std::filesystem::file_size(source_path, error);
+    if (!error)
+        header.source_mtime = SourceModificationTime(source_path, error);
+    if (error) {
+        std::cerr << "MeshCache: Cannot stat source: " << source_path << "\n";
+        return false;
+    }
+    header.source_hash = HashFile(source_path);
+    header.vertex_count = data.vertices.size();
+    header.index_count = data.indices.size();
+    header.lod_count = data.lods.size();
+    header.bounds = data.bounds;
+    header.cache_before = data.cache_before;
+    header.cache_after = data.cache_after;
+    header.sphere_method = sphere_method;
+
+    // Write to a temporary file first so that an interrupted write never leaves a valid-looking cache
+    auto temp_path = cache_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream cache_file(temp_path, std::ios::binary | std::ios::trunc);
+        cache_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        cache_file.write(reinterpret_cast<const char*>(data.vertices.data()), data.vertices.size() * sizeof(Vertex));
+        cache_file.write(reinterpret_cast<const char*>(data.indices.data()), data.indices.size() * sizeof(GLuint));
+        cache_file.write(reinterpret_cast<const char*>(data.lods.data()), data.lods.size() * sizeof(MeshLod));
+        if (!cache_file) {
+            std::cerr << "MeshCache: Cannot write: " << temp_path << "\n";
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp_path, cache_path, error);
+    if (error) {
+        std::cerr << "MeshCache: Cannot replace: " << cache_path << "\n";
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
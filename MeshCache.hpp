@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "MeshData.hpp"
+
+// Binary mesh cache (.pg2mesh) stored next to the source model
+//
+// Layout: MeshCacheHeader, Vertex[vertex_count], GLuint[index_count], MeshLod[lod_count]
+// A cache is valid when its version matches and the source file has the recorded size and
+// modification time; if only the time differs, the source is hashed and compared instead.
+// Every requested bounding sphere method has a cache of its own, the header records which.
+
+constexpr char MESH_CACHE_MAGIC[8] = { 'P', 'G', '2', 'M', 'E', 'S', 'H', '\0' };
+constexpr uint32_t MESH_CACHE_VERSION = 7; // Bump whenever the stored data or the pipeline producing it changes
+
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertex_size; // sizeof(Vertex), guards against layout changes
+    uint64_t source_size; // Size of the source file in bytes
+    int64_t source_mtime; // Last write time of the source file, in file clock ticks
+    uint64_t source_hash; // FNV-1a hash of the source file contents
+    uint64_t vertex_count;
+    uint64_t index_count;
+    uint64_t lod_count;
+    MeshBounds bounds;
+    VertexCacheStats cache_before;
+    VertexCacheStats cache_after;
+    BoundingSphereMethod sphere_method; // Method requested for the bounds, Auto or an explicit one
+};
+
+// e.g. box.obj -> box.obj.pg2mesh for Auto, box.obj.exact.pg2mesh for Exact
+std::filesystem::path MeshCachePath(const std::filesystem::path& source_path, BoundingSphereMethod sphere_method);
+
+// Loads the cache of source_path built for sphere_method into data, returns false when missing or stale
+bool LoadMeshCache(const std::filesystem::path& source_path, BoundingSphereMethod sphere_method, MeshData& data);
+
+// Writes the cache of source_path built for sphere_method, returns false on I/O errors
+bool SaveMeshCache(const std::filesystem::path& source_path, BoundingSphereMethod sphere_method, const MeshData& data);
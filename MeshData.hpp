@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "BoundingVolume.hpp"
+#include "ConvexHull.hpp"
+#include "Vertex.hpp"
+
+// Model space bounding volumes of a mesh
+struct MeshBounds {
+    glm::vec3 sphere_center{}; // Center of the bounding sphere
+    float sphere_radius{}; // Radius of the bounding sphere
+    glm::vec3 aabb_min{}; // Minimum point of the axis-aligned bounding box
+    glm::vec3 aabb_max{}; // Maximum point of the axis-aligned bounding box
+    BoundingSphereMethod sphere_method = BoundingSphereMethod::Exact; // How the sphere was computed
+    BoundingBox box{}; // Oriented box fitted at load time, tight under any rotation of the object
+    BoundingCapsule capsule{}; // Capsule along the longest axis of box
+    BoundingShape shape = BoundingShape::Sphere; // Tightest cheap collision shape, the hull only where it is much tighter
+};
+
+// Post-transform vertex cache efficiency of an index order, see MeshOptimizer
+struct VertexCacheStats {
+    float acmr{}; // Average cache miss ratio, transformed vertices per triangle (0.5 - 3, lower is better)
+    float atvr{}; // Average transformed vertex ratio, transformed vertices per unique vertex (1 is optimal)
+};
+
+// Index range of one level of detail, all levels share the vertices
+struct MeshLod {
+    GLuint index_offset;
+    GLuint index_count;
+    float error; // Largest deviation from the full detail mesh, in model units
+};
+
+// CPU side mesh, ready to be uploaded by Mesh
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices; // All LODs, LOD 0 first
+    std::vector<MeshLod> lods; // Empty: all indices are one full detail level
+    MeshBounds bounds;
+    std::shared_ptr<const ConvexHull> hull; // Built only when bounds.shape is Hull, not cached
+    VertexCacheStats cache_before; // Index order as loaded
+    VertexCacheStats cache_after; // Index order after OptimizeMesh
+};
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <numeric>
+
+#include <glm/glm.hpp>
+
+#include "MeshOptimizer.hpp"
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size)
+{
+    // Zeroed stats without a whole triangle, the ratios would divide by zero
+    VertexCacheStats stats;
+    if (indices.size() < 3 || vertex_count == 0)
+        return stats;
+
+    // A vertex is cached while fewer than cache_size misses happened since it was loaded
+    std::vector<size_t> loaded_at(vertex_count, 0);
+    std::vector<bool> seen(vertex_count, false);
+    size_t misses = 0, unique = 0;
+    for (GLuint index : indices) {
+        if (!seen[index]) {
+            seen[index] = true;
+            unique++;
+        }
+        else if (misses - loaded_at[index] < cache_size) {
+            continue;
+        }
+        loaded_at[index] = misses++;
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(unique);
+    return stats;
+}
+
+void OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size)
+{
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0 || vertex_count == 0)
+        return;
+
+    // Vertex -> triangle adjacency in one flat array
+    std::vector<GLuint> live(vertex_count, 0); // Triangles not yet emitted, per vertex
+    for (GLuint index : indices)
+        live[index]++;
+    std::vector<size_t> adjacency_offset(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++)
+        adjacency_offset[v + 1] = adjacency_offset[v] + live[v];
+    std::vector<GLuint> adjacency(indices.size());
+    {
+        std::vector<size_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = static_cast<GLuint>(i / 3);
+    }
+
+    std::vector<size_t> cache_time(vertex_count, 0); // Time stamp of the last load, a vertex is cached while time - stamp <= cache_size
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<GLuint> dead_end; // Recently used vertices, revisited when the fan vertex runs out of triangles
+    std::vector<GLuint> candidates;
+    std::vector<GLuint> output;
+    output.reserve(indices.size());
+
+    size_t time = cache_size + 1;
+    size_t cursor = 0; // Next vertex in input order for restarting after a dead end
+    long long fan = 0;
+
+    while (fan >= 0) {
+        // Emit all remaining triangles around the fan vertex
+        candidates.clear();
+        for (size_t a = adjacency_offset[fan]; a < adjacency_offset[fan + 1]; a++) {
+            GLuint triangle = adjacency[a];
+            if (emitted[triangle])
+                continue;
+            emitted[triangle] = true;
+            for (int corner = 0; corner < 3; corner++) {
+                GLuint v = indices[triangle * 3 + corner];
+                output.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - cache_time[v] > cache_size) {
+                    cache_time[v] = time++;
+                }
+            }
+        }
+
+        // Next fan: the candidate that stays in the cache while its remaining triangles are emitted, oldest first
+        fan = -1;
+        long long best_priority = -1;
+        for (GLuint v : candidates) {
+            if (live[v] == 0)
+                continue;
+            long long priority = 0;
+            if (time - cache_time[v] + 2 * live[v] <= cache_size)
+                priority = static_cast<long long>(time - cache_time[v]);
+            if (priority > best_priority) {
+                best_priority = priority;
+                fan = v;
+            }
+        }
+
+        // Dead end: go back to a recently used vertex, then continue in input order
+        while (fan < 0 && !dead_end.empty()) {
+            GLuint v = dead_end.back();
+            dead_end.pop_back();
+            if (live[v] > 0)
+                fan = v;
+        }
+        while (fan < 0 && cursor < vertex_count) {
+            if (live[cursor] > 0)
+                fan = static_cast<long long>(cursor);
+            cursor++;
+        }
+    }
+
+    indices.swap(output);
+}
+
+void OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<Vertex>& vertices, unsigned int cache_size)
+{
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count < 2)
+        return;
+
+    // Clusters start at triangles whose three vertices all miss the cache
+    std::vector<size_t> cluster_start;
+    {
+        std::vector<size_t> loaded_at(vertices.size(), 0);
+        std::vector<bool> seen(vertices.size(), false);
+        size_t misses = 0;
+        for (size_t t = 0; t < triangle_count; t++) {
+            int triangle_misses = 0;
+            for (int corner = 0; corner < 3; corner++) {
+                GLuint v = indices[t * 3 + corner];
+                if (seen[v] && misses - loaded_at[v] < cache_size)
+                    continue;
+                seen[v] = true;
+                loaded_at[v] = misses++;
+                triangle_misses++;
+            }
+            if (triangle_misses == 3)
+                cluster_start.push_back(t);
+        }
+    }
+    if (cluster_start.size() < 2)
+        return;
+    cluster_start.push_back(triangle_count);
+
+    // Area weighted centroid and normal of every cluster and of the whole mesh
+    struct Cluster {
+        size_t first, last; // Triangle range [first, last)
+        float sort_key;
+    };
+    std::vector<Cluster> clusters(cluster_start.size() - 1);
+    std::vector<glm::vec3> cluster_centroid(clusters.size()), cluster_normal(clusters.size());
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        clusters[c].first = cluster_start[c];
+        clusters[c].last = cluster_start[c + 1];
+
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusters[c].first; t < clusters[c].last; t++) {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0); // Length is twice the area
+            float triangle_area = glm::length(cross);
+            centroid += (p0 + p1 + p2) * (triangle_area / 3.0f);
+            normal += cross;
+            area += triangle_area;
+        }
+        mesh_centroid += centroid;
+        mesh_area += area;
+        cluster_centroid[c] = area > 0.0f ? centroid / area : vertices[indices[clusters[c].first * 3]].position;
+        cluster_normal[c] = normal;
+    }
+    if (mesh_area > 0.0f)
+        mesh_centroid /= mesh_area;
+
+    // Clusters facing away from the center are in front when visible, draw them first
+    for (size_t c = 0; c < clusters.size(); c++) {
+        float normal_length = glm::length(cluster_normal[c]);
+        clusters[c].sort_key = normal_length > 0.0f ? glm::dot(cluster_centroid[c] - mesh_centroid, cluster_normal[c] / normal_length) : 0.0f;
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+    std::vector<GLuint> output;
+    output.reserve(indices.size());
+    for (const auto& cluster : clusters)
+        output.insert(output.end(), indices.begin() + cluster.first * 3, indices.begin() + cluster.last * 3);
+    indices.swap(output);
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+    constexpr GLuint unused = ~GLuint(0);
+    std::vector<GLuint> remap(vertices.size(), unused);
+    std::vector<Vertex> output;
+    output.reserve(vertices.size());
+
+    for (GLuint& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<GLuint>(output.size());
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(output);
+}
+
+void OptimizeMesh(MeshData& data)
+{
+    data.cache_before = AnalyzeVertexCache(data.indices, data.vertices.size());
+    OptimizeVertexCache(data.indices, data.vertices.size());
+    OptimizeOverdraw(data.indices, data.vertices);
+    OptimizeVertexFetch(data.vertices, data.indices);
+    data.cache_after = AnalyzeVertexCache(data.indices, data.vertices.size());
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "MeshData.hpp"
+#include "Vertex.hpp"
+
+// Triangle and vertex reordering for indexed triangle lists
+//
+// The optimized order renders the same triangles, only faster: fewer vertex shader runs
+// (post-transform cache), less overdraw and better locality of vertex fetches.
+
+constexpr unsigned int VERTEX_CACHE_SIZE = 16; // Simulated FIFO post-transform cache, in vertices
+
+// Simulates a FIFO vertex cache over the index order
+VertexCacheStats AnalyzeVertexCache(const std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size = VERTEX_CACHE_SIZE);
+
+// Reorders triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007)
+void OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size = VERTEX_CACHE_SIZE);
+
+// Splits the cache optimized order into clusters at cache flushes and draws outward facing clusters first
+// Cluster boundaries are where all three vertices miss anyway, so the vertex cache efficiency is kept
+void OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<Vertex>& vertices, unsigned int cache_size = VERTEX_CACHE_SIZE);
+
+// Renumbers vertices in order of first use and drops unreferenced ones
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+// Runs all passes above on data and records the cache statistics before and after
+void OptimizeMesh(MeshData& data);
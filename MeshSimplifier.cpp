@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+
+namespace {
+
+// Symmetric 4x4 matrix, sum of squared distances to a set of planes
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0; // Sum of plane weights, Error() / weight is a mean squared distance
+
+    void AddPlane(const glm::dvec3& n, double d, double w)
+    {
+        a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+        a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+        a22 += w * n.z * n.z; a23 += w * n.z * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        weight += q.weight;
+    }
+
+    double Error(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+            + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+            + a22 * z * z + 2 * a23 * z
+            + a33;
+        return std::max(error, 0.0);
+    }
+};
+
+struct PositionHash {
+    size_t operator()(const glm::vec3& p) const
+    {
+        uint32_t bits[3];
+        std::memcpy(bits, &p, sizeof(bits));
+        return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    }
+};
+
+struct Collapse {
+    GLuint from, to;
+    double cost; // Area weighted quadric error
+    double distance; // Approximate distance moved off the original surface
+};
+
+constexpr double BORDER_PLANE_WEIGHT = 10.0; // Weight of open border constraints relative to triangle area (per squared edge length)
+
+uint64_t EdgeKey(GLuint a, GLuint b)
+{
+    if (a > b)
+        std::swap(a, b);
+    return (uint64_t(a) << 32) | b;
+}
+
+// Counts how many triangles use every undirected position edge
+void CountEdgeUse(const std::vector<GLuint>& indices, const std::vector<GLuint>& position_id, std::unordered_map<uint64_t, GLuint>& edge_use)
+{
+    edge_use.clear();
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int e = 0; e < 3; e++)
+            edge_use[EdgeKey(position_id[indices[i + e]], position_id[indices[i + (e + 1) % 3]])]++;
+    }
+}
+
+} // namespace
+
+size_t SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, size_t target_index_count, std::vector<GLuint>& destination, float& error)
+{
+    destination = indices;
+    error = 0.0f;
+    const size_t vertex_count = vertices.size();
+    if (destination.size() <= target_index_count || vertex_count == 0)
+        return destination.size();
+
+    // Vertices sharing a position are wedges of one position, identified by the first of them
+    std::vector<GLuint> position_id(vertex_count);
+    {
+        std::unordered_map<glm::vec3, GLuint, PositionHash> first_vertex;
+        first_vertex.reserve(vertex_count);
+        for (GLuint v = 0; v < vertex_count; v++)
+            position_id[v] = first_vertex.emplace(vertices[v].position, v).first->second;
+    }
+
+    // Plane quadrics accumulated per position, weighted by triangle area
+    // Open border edges add a plane perpendicular to their triangle so the outline is kept in place
+    std::unordered_map<uint64_t, GLuint> edge_use; // Undirected position edge -> triangles using it
+    CountEdgeUse(destination, position_id, edge_use);
+    std::vector<Quadric> quadrics(vertex_count);
+    for (size_t i = 0; i < destination.size(); i += 3) {
+        glm::dvec3 p[3];
+        for (int corner = 0; corner < 3; corner++)
+            p[corner] = vertices[destination[i + corner]].position;
+        glm::dvec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+        double length = glm::length(normal);
+        if (length == 0.0)
+            continue;
+        normal /= length;
+        double area = length * 0.5;
+        for (int corner = 0; corner < 3; corner++)
+            quadrics[position_id[destination[i + corner]]].AddPlane(normal, -glm::dot(normal, p[0]), area);
+
+        for (int e = 0; e < 3; e++) {
+            GLuint pa = position_id[destination[i + e]], pb = position_id[destination[i + (e + 1) % 3]];
+            if (edge_use[EdgeKey(pa, pb)] != 1)
+                continue;
+            glm::dvec3 edge = p[(e + 1) % 3] - p[e];
+            double edge_length = glm::length(edge);
+            if (edge_length == 0.0)
+                continue;
+            glm::dvec3 border_normal = glm::normalize(glm::cross(edge, normal));
+            double weight = BORDER_PLANE_WEIGHT * edge_length * edge_length;
+            quadrics[pa].AddPlane(border_normal, -glm::dot(border_normal, p[e]), weight);
+            quadrics[pb].AddPlane(border_normal, -glm::dot(border_normal, p[e]), weight);
+        }
+    }
+
+    std::vector<GLuint> border_edges(vertex_count); // Open border edges per position
+    std::vector<bool> collapsible(vertex_count);
+    std::vector<Collapse> collapses;
+    std::vector<size_t> adjacency_offset(vertex_count + 1);
+    std::vector<GLuint> adjacency;
+    std::vector<GLuint> remap(vertex_count);
+    std::vector<bool> locked(vertex_count);
+    std::vector<std::pair<GLuint, GLuint>> wedge_remap;
+    std::vector<GLuint> unmapped;
+    double max_distance = 0.0;
+
+    // Each pass collapses independent edges in order of increasing cost, then compacts the index list
+    while (destination.size() > target_index_count) {
+        const size_t triangle_count = destination.size() / 3;
+
+        // Interior positions collapse freely, positions on a simple open border only along it,
+        // positions on non-manifold edges or where borders meet are kept
+        CountEdgeUse(destination, position_id, edge_use);
+        std::fill(border_edges.begin(), border_edges.end(), 0);
+        std::fill(collapsible.begin(), collapsible.end(), true);
+        for (const auto& [key, use] : edge_use) {
+            GLuint pa = static_cast<GLuint>(key >> 32), pb = static_cast<GLuint>(key & 0xffffffffu);
+            if (use == 1) {
+                border_edges[pa]++;
+                border_edges[pb]++;
+            }
+            else if (use > 2) {
+                collapsible[pa] = false;
+                collapsible[pb] = false;
+            }
+        }
+        for (size_t v = 0; v < vertex_count; v++) {
+            if (border_edges[v] != 0 && border_edges[v] != 2)
+                collapsible[v] = false;
+        }
+
+        // Position -> triangle adjacency of the current index list
+        std::fill(adjacency_offset.begin(), adjacency_offset.end(), 0);
+        for (GLuint v : destination)
+            adjacency_offset[position_id[v] + 1]++;
+        for (size_t v = 0; v < vertex_count; v++)
+            adjacency_offset[v + 1] += adjacency_offset[v];
+        adjacency.resize(destination.size());
+        {
+            std::vector<size_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+            for (size_t i = 0; i < destination.size(); i++)
+                adjacency[fill[position_id[destination[i]]]++] = static_cast<GLuint>(i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < destination.size(); i += 3) {
+            for (int e = 0; e < 3; e++) {
+                GLuint a = position_id[destination[i + e]], b = position_id[destination[i + (e + 1) % 3]];
+                for (int direction = 0; direction < 2; direction++, std::swap(a, b)) {
+                    if (!collapsible[a] || a == b)
+                        continue;
+                    if (border_edges[a] != 0 && edge_use[EdgeKey(a, b)] != 1)
+                        continue;
+                    const glm::vec3& target = vertices[b].position;
+                    double cost = quadrics[a].Error(target) + quadrics[b].Error(target);
+                    double weight = quadrics[a].weight + quadrics[b].weight;
+                    collapses.push_back({ a, b, cost, weight > 0.0 ? std::sqrt(cost / weight) : 0.0 });
+                }
+            }
+        }
+        if (collapses.empty())
+            break;
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        for (GLuint v = 0; v < vertex_count; v++)
+            remap[v] = v;
+        std::fill(locked.begin(), locked.end(), false);
+
+        // Every collapse removes about two triangles
+        const size_t triangles_to_remove = triangle_count - target_index_count / 3;
+        size_t removed = 0;
+        for (const auto& collapse : collapses) {
+            if (removed >= triangles_to_remove)
+                break;
+            GLuint a = collapse.from, b = collapse.to;
+            if (locked[a] || locked[b])
+                continue;
+
+            // Every wedge of a takes the wedge of b it shares a triangle with, so seams and hard edges stay intact
+            // Rejected when a wedge has two different ones, has no acceptable one, or a remaining triangle flips
+            const glm::vec3& target = vertices[b].position;
+            bool valid = true;
+            size_t degenerate = 0;
+            wedge_remap.clear();
+            for (size_t t = adjacency_offset[a]; t < adjacency_offset[a + 1] && valid; t++) {
+                const GLuint* triangle = &destination[adjacency[t] * 3];
+                GLuint wedge_a = 0, wedge_b = 0;
+                bool contains_b = false;
+                for (int corner = 0; corner < 3; corner++) {
+                    if (position_id[triangle[corner]] == a)
+                        wedge_a = triangle[corner];
+                    if (position_id[triangle[corner]] == b) {
+                        wedge_b = triangle[corner];
+                        contains_b = true;
+                    }
+                }
+                if (!contains_b)
+                    continue;
+                degenerate++;
+                auto mapped = std::find_if(wedge_remap.begin(), wedge_remap.end(), [&](const auto& pair) { return pair.first == wedge_a; });
+                if (mapped == wedge_remap.end())
+                    wedge_remap.push_back({ wedge_a, wedge_b });
+                else
+                    valid = mapped->second == wedge_b;
+            }
+            // Wedges of a without a triangle at b (corners of hard edges) take the most similar wedge of b,
+            // if it is close enough that the change of shading is not noticeable
+            unmapped.clear();
+            for (size_t t = adjacency_offset[a]; t < adjacency_offset[a + 1] && valid; t++) {
+                const GLuint* triangle = &destination[adjacency[t] * 3];
+                for (int corner = 0; corner < 3; corner++) {
+                    if (position_id[triangle[corner]] == a && std::none_of(wedge_remap.begin(), wedge_remap.end(), [&](const auto& pair) { return pair.first == triangle[corner]; }))
+                        unmapped.push_back(triangle[corner]);
+                }
+            }
+            for (GLuint wedge_a : unmapped) {
+                if (!valid)
+                    break;
+                if (std::any_of(wedge_remap.begin(), wedge_remap.end(), [&](const auto& pair) { return pair.first == wedge_a; }))
+                    continue;
+                GLuint best = 0;
+                float best_distance = -1.0f;
+                for (size_t t = adjacency_offset[b]; t < adjacency_offset[b + 1]; t++) {
+                    for (int corner = 0; corner < 3; corner++) {
+                        GLuint wedge_b = destination[adjacency[t] * 3 + corner];
+                        if (position_id[wedge_b] != b)
+                            continue;
+                        const Vertex& va = vertices[wedge_a];
+                        const Vertex& vb = vertices[wedge_b];
+                        if (glm::dot(va.normal, vb.normal) < MESH_LOD_WEDGE_NORMAL_COS * glm::length(va.normal) * glm::length(vb.normal))
+                            continue;
+                        float distance = glm::length(va.tex_coords - vb.tex_coords);
+                        if (distance <= MESH_LOD_WEDGE_TEX_DISTANCE && (best_distance < 0.0f || distance < best_distance)) {
+                            best = wedge_b;
+                            best_distance = distance;
+                        }
+                    }
+                }
+                if (best_distance < 0.0f)
+                    valid = false;
+                else
+                    wedge_remap.push_back({ wedge_a, best });
+            }
+            for (size_t t = adjacency_offset[a]; t < adjacency_offset[a + 1] && valid; t++) {
+                const GLuint* triangle = &destination[adjacency[t] * 3];
+                glm::vec3 p[3], q[3];
+                bool contains_b = false;
+                for (int corner = 0; corner < 3; corner++) {
+                    GLuint position = position_id[triangle[corner]];
+                    p[corner] = vertices[triangle[corner]].position;
+                    q[corner] = position == a ? target : p[corner];
+                    contains_b |= position == b;
+                }
+                if (contains_b || !valid)
+                    continue;
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                valid = glm::dot(before, after) > 0.25f * glm::length(before) * glm::length(after);
+            }
+            if (!valid)
+                continue;
+
+            // The one-ring of a changes, keep it out of further collapses in this pass
+            for (size_t t = adjacency_offset[a]; t < adjacency_offset[a + 1]; t++) {
+                for (int corner = 0; corner < 3; corner++)
+                    locked[position_id[destination[adjacency[t] * 3 + corner]]] = true;
+            }
+            for (const auto& [wedge_a, wedge_b] : wedge_remap)
+                remap[wedge_a] = wedge_b;
+            quadrics[b].Add(quadrics[a]);
+            max_distance = std::max(max_distance, collapse.distance);
+            removed += degenerate;
+        }
+        if (removed == 0)
+            break;
+
+        // Apply the collapses and drop triangles that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < destination.size(); i += 3) {
+            GLuint v0 = remap[destination[i + 0]], v1 = remap[destination[i + 1]], v2 = remap[destination[i + 2]];
+            if (position_id[v0] == position_id[v1] || position_id[v1] == position_id[v2] || position_id[v0] == position_id[v2])
+                continue;
+            destination[write++] = v0;
+            destination[write++] = v1;
+            destination[write++] = v2;
+        }
+        destination.resize(write);
+    }
+
+    error = static_cast<float>(max_distance);
+    return destination.size();
+}
+
+void GenerateMeshLods(MeshData& data)
+{
+    data.lods.clear();
+    data.lods.push_back({ 0, static_cast<GLuint>(data.indices.size()), 0.0f });
+
+    std::vector<GLuint> source(data.indices), simplified;
+    while (data.lods.size() < MESH_LOD_COUNT) {
+        const MeshLod& previous = data.lods.back();
+        size_t target = static_cast<size_t>(previous.index_count / 3 * MESH_LOD_REDUCTION) * 3;
+        float error = 0.0f;
+        SimplifyMesh(data.vertices, source, target, simplified, error);
+        if (simplified.empty() || simplified.size() > previous.index_count * MESH_LOD_MIN_REDUCTION)
+            break;
+
+        // Each level is simplified from the previous one, so errors add up
+        OptimizeVertexCache(simplified, data.vertices.size());
+        MeshLod lod{ static_cast<GLuint>(data.indices.size()), static_cast<GLuint>(simplified.size()), previous.error + error };
+        data.indices.insert(data.indices.end(), simplified.begin(), simplified.end());
+        data.lods.push_back(lod);
+        source.swap(simplified);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "MeshData.hpp"
+#include "Vertex.hpp"
+
+// Quadric error metric simplification and LOD chains
+//
+// Edges are collapsed onto one of their existing vertices, so every LOD indexes the same
+// vertex buffer and only adds an index range. Positions with several wedges (attribute seams,
+// hard edges) collapse along the seam or onto wedges with similar attributes, vertices on open
+// borders only move along the border.
+
+constexpr size_t MESH_LOD_COUNT = 4; // Levels including the full detail mesh
+constexpr float MESH_LOD_REDUCTION = 0.5f; // Triangle count of a level relative to the previous one
+constexpr float MESH_LOD_MIN_REDUCTION = 0.9f; // A level that cannot get below this ratio of the previous one ends the chain
+constexpr float MESH_LOD_WEDGE_NORMAL_COS = 0.8f; // Seam wedges may merge with wedges whose normals are within ~37 degrees
+constexpr float MESH_LOD_WEDGE_TEX_DISTANCE = 0.05f; // and whose texture coordinates are this close
+
+// Simplifies the triangle list towards target_index_count, returns the reached index count
+// error receives the largest collapse error, an approximate distance in model units
+size_t SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, size_t target_index_count, std::vector<GLuint>& destination, float& error);
+
+// Appends the LODs of data.indices (full detail) to data.indices and fills data.lods, LOD 0 first
+void GenerateMeshLods(MeshData& data);
@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Narrowphase.hpp"
+
+namespace {
+
+constexpr float PARALLEL_EPSILON = 1e-6f; // Added to the rotation terms of the box test, near parallel edges give no false separation
+
+glm::vec3 ClosestOnSegment(const glm::vec3& a, const glm::vec3& b, const glm::vec3& point)
+{
+    const glm::vec3 ab = b - a;
+    const float length2 = glm::dot(ab, ab);
+    const float t = length2 > 0.0f ? std::clamp(glm::dot(point - a, ab) / length2, 0.0f, 1.0f) : 0.0f;
+    return a + ab * t;
+}
+
+// Squared distance between segments [p1, q1] and [p2, q2], Ericson, Real-Time Collision Detection 5.1.9
+float SegmentDistance2(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2)
+{
+    const glm::vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+    const float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, r);
+    float s = 0.0f, t = 0.0f;
+    if (a > 0.0f || e > 0.0f) {
+        if (a == 0.0f) {
+            t = std::clamp(f / e, 0.0f, 1.0f);
+        }
+        else {
+            const float c = glm::dot(d1, r);
+            if (e == 0.0f) {
+                s = std::clamp(-c / a, 0.0f, 1.0f);
+            }
+            else {
+                const float b = glm::dot(d1, d2);
+                const float denominator = a * e - b * b;
+                s = denominator != 0.0f ? std::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+                t = (b * s + f) / e;
+                if (t < 0.0f) {
+                    t = 0.0f;
+                    s = std::clamp(-c / a, 0.0f, 1.0f);
+                }
+                else if (t > 1.0f) {
+                    t = 1.0f;
+                    s = std::clamp((b - c) / a, 0.0f, 1.0f);
+                }
+            }
+        }
+    }
+    const glm::vec3 between = (p1 + d1 * s) - (p2 + d2 * t);
+    return glm::dot(between, between);
+}
+
+glm::vec3 SphereSupport(const glm::vec3& center, float radius, const glm::vec3& direction)
+{
+    const float length = glm::length(direction);
+    return length > 0.0f ? center + direction * (radius / length) : center;
+}
+
+// Weights of the ends of segment [a, b] for its point nearest the origin
+void SegmentWeights(const glm::vec3& a, const glm::vec3& b, float* weights)
+{
+    const glm::vec3 ab = b - a;
+    const float length2 = glm::dot(ab, ab);
+    const float t = length2 > 0.0f ? std::clamp(-glm::dot(a, ab) / length2, 0.0f, 1.0f) : 0.0f;
+    weights[0] = 1.0f - t;
+    weights[1] = t;
+}
+
+// Weights of the corners of triangle abc for its point nearest the origin, Ericson, Real-Time Collision Detection 5.1.5
+void TriangleWeights(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float* weights)
+{
+    const glm::vec3 ab = b - a, ac = c - a;
+    weights[0] = weights[1] = weights[2] = 0.0f;
+    const float d1 = -glm::dot(ab, a), d2 = -glm::dot(ac, a);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        weights[0] = 1.0f;
+        return;
+    }
+    const float d3 = -glm::dot(ab, b), d4 = -glm::dot(ac, b);
+    if (d3 >= 0.0f && d4 <= d3) {
+        weights[1] = 1.0f;
+        return;
+    }
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        weights[1] = d1 / (d1 - d3);
+        weights[0] = 1.0f - weights[1];
+        return;
+    }
+    const float d5 = -glm::dot(ab, c), d6 = -glm::dot(ac, c);
+    if (d6 >= 0.0f && d5 <= d6) {
+        weights[2] = 1.0f;
+        return;
+    }
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        weights[2] = d2 / (d2 - d6);
+        weights[0] = 1.0f - weights[2];
+        return;
+    }
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        weights[2] = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        weights[1] = 1.0f - weights[2];
+        return;
+    }
+    const float denominator = va + vb + vc;
+    if (denominator > 0.0f) {
+        weights[1] = vb / denominator;
+        weights[2] = vc / denominator;
+        weights[0] = 1.0f - weights[1] - weights[2];
+        return;
+    }
+    // Degenerate triangle, the nearest of its edges
+    const glm::vec3* corners[3] = { &a, &b, &c };
+    float best = std::numeric_limits<float>::max();
+    for (int edge = 0; edge < 3; edge++) {
+        const int first = edge, second = (edge + 1) % 3;
+        float pair[2];
+        SegmentWeights(*corners[first], *corners[second], pair);
+        const glm::vec3 point = *corners[first] * pair[0] + *corners[second] * pair[1];
+        if (glm::dot(point, point) < best) {
+            best = glm::dot(point, point);
+            weights[0] = weights[1] = weights[2] = 0.0f;
+            weights[first] = pair[0];
+            weights[second] = pair[1];
+        }
+    }
+}
+
+glm::vec3 Weighted(const gjk::Vertex* simplex, const int* corners, const float* weights, int count)
+{
+    glm::vec3 point(0.0f);
+    for (int i = 0; i < count; i++)
+        point += simplex[corners[i]].point * weights[i];
+    return point;
+}
+
+// Box around a box of the given center and half extents rotated by rotation
+void RotatedBounds(const glm::vec3& center, const glm::mat3& rotation, const glm::vec3& half_extents, glm::vec3& aabb_min, glm::vec3& aabb_max)
+{
+    glm::vec3 reach(0.0f);
+    for (int axis = 0; axis < 3; axis++)
+        reach += glm::abs(rotation[axis]) * half_extents[axis];
+    aabb_min = center - reach;
+    aabb_max = center + reach;
+}
+
+} // namespace
+
+glm::vec3 Center(const SphereShape& shape)
+{
+    return shape.center;
+}
+
+glm::vec3 Center(const AabbShape& shape)
+{
+    return (shape.aabb_min + shape.aabb_max) * 0.5f;
+}
+
+glm::vec3 Center(const ObbShape& shape)
+{
+    return shape.center;
+}
+
+glm::vec3 Center(const CapsuleShape& shape)
+{
+    return (shape.a + shape.b) * 0.5f;
+}
+
+glm::vec3 Center(const HullShape& shape)
+{
+    return shape.position + shape.rotation * (shape.scale * shape.hull->centroid);
+}
+
+glm::vec3 Support(const SphereShape& shape, const glm::vec3& direction)
+{
+    return SphereSupport(shape.center, shape.radius, direction);
+}
+
+glm::vec3 Support(const AabbShape& shape, const glm::vec3& direction)
+{
+    return glm::vec3(
+        direction.x >= 0.0f ? shape.aabb_max.x : shape.aabb_min.x,
+        direction.y >= 0.0f ? shape.aabb_max.y : shape.aabb_min.y,
+        direction.z >= 0.0f ? shape.aabb_max.z : shape.aabb_min.z);
+}
+
+glm::vec3 Support(const ObbShape& shape, const glm::vec3& direction)
+{
+    glm::vec3 point = shape.center;
+    for (int axis = 0; axis < 3; axis++)
+        point += shape.axes[axis] * (glm::dot(direction, shape.axes[axis]) >= 0.0f ? shape.half_extents[axis] : -shape.half_extents[axis]);
+    return point;
+}
+
+glm::vec3 Support(const CapsuleShape& shape, const glm::vec3& direction)
+{
+    return SphereSupport(glm::dot(direction, shape.b - shape.a) >= 0.0f ? shape.b : shape.a, shape.radius, direction);
+}
+
+glm::vec3 Support(const HullShape& shape, const glm::vec3& direction)
+{
+    // Farthest vertex in model space, the scale is positive and does not change which one
+    const glm::vec3 local = glm::transpose(shape.rotation) * direction;
+    const auto& vertices = shape.hull->vertices;
+    size_t best = 0;
+    float best_distance = glm::dot(vertices[0], local);
+    for (size_t i = 1; i < vertices.size(); i++) {
+        const float distance = glm::dot(vertices[i], local);
+        if (distance > best_distance) {
+            best_distance = distance;
+            best = i;
+        }
+    }
+    return shape.position + shape.rotation * (shape.scale * vertices[best]);
+}
+
+void Bounds(const SphereShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max)
+{
+    aabb_min = shape.center - glm::vec3(shape.radius);
+    aabb_max = shape.center + glm::vec3(shape.radius);
+}
+
+void Bounds(const AabbShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max)
+{
+    aabb_min = shape.aabb_min;
+    aabb_max = shape.aabb_max;
+}
+
+void Bounds(const ObbShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max)
+{
+    RotatedBounds(shape.center, shape.axes, shape.half_extents, aabb_min, aabb_max);
+}
+
+void Bounds(const CapsuleShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max)
+{
+    aabb_min = glm::min(shape.a, shape.b) - glm::vec3(shape.radius);
+    aabb_max = glm::max(shape.a, shape.b) + glm::vec3(shape.radius);
+}
+
+void Bounds(const HullShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max)
+{
+    // The hull's own box carried along, as for the mesh box
+    const glm::vec3 center = shape.position + shape.rotation * (shape.scale * (shape.hull->aabb_min + shape.hull->aabb_max) * 0.5f);
+    RotatedBounds(center, shape.rotation, shape.scale * (shape.hull->aabb_max - shape.hull->aabb_min) * 0.5f, aabb_min, aabb_max);
+}
+
+bool Contains(const SphereShape& shape, const glm::vec3& point)
+{
+    const glm::vec3 offset = point - shape.center;
+    return glm::dot(offset, offset) < shape.radius * shape.radius;
+}
+
+bool Contains(const AabbShape& shape, const glm::vec3& point)
+{
+    return glm::all(glm::greaterThanEqual(point, shape.aabb_min)) && glm::all(glm::lessThanEqual(point, shape.aabb_max));
+}
+
+bool Contains(const ObbShape& shape, const glm::vec3& point)
+{
+    const glm::vec3 offset = point - shape.center;
+    for (int axis = 0; axis < 3; axis++) {
+        if (std::fabs(glm::dot(offset, shape.axes[axis])) > shape.half_extents[axis])
+            return false;
+    }
+    return true;
+}
+
+bool Contains(const CapsuleShape& shape, const glm::vec3& point)
+{
+    const glm::vec3 offset = point - ClosestOnSegment(shape.a, shape.b, point);
+    return glm::dot(offset, offset) < shape.radius * shape.radius;
+}
+
+bool Contains(const HullShape& shape, const glm::vec3& point)
+{
+    const glm::vec3 local = glm::transpose(shape.rotation) * (point - shape.position) / shape.scale;
+    for (const glm::vec4& plane : shape.hull->planes) {
+        if (glm::dot(glm::vec3(plane), local) > plane.w)
+            return false;
+    }
+    return true;
+}
+
+bool Intersects(const SphereShape& a, const SphereShape& b)
+{
+    const glm::vec3 offset = a.center - b.center;
+    const float reach = a.radius + b.radius;
+    return glm::dot(offset, offset) <= reach * reach;
+}
+
+bool Intersects(const SphereShape& a, const AabbShape& b)
+{
+    const glm::vec3 offset = a.center - glm::clamp(a.center, b.aabb_min, b.aabb_max);
+    return glm::dot(offset, offset) <= a.radius * a.radius;
+}
+
+bool Intersects(const SphereShape& a, const ObbShape& b)
+{
+    // In the box frame the box is axis-aligned
+    const glm::vec3 local = glm::transpose(b.axes) * (a.center - b.center);
+    const glm::vec3 offset = local - glm::clamp(local, -b.half_extents, b.half_extents);
+    return glm::dot(offset, offset) <= a.radius * a.radius;
+}
+
+bool Intersects(const SphereShape& a, const CapsuleShape& b)
+{
+    const glm::vec3 offset = a.center - ClosestOnSegment(b.a, b.b, a.center);
+    const float reach = a.radius + b.radius;
+    return glm::dot(offset, offset) <= reach * reach;
+}
+
+bool Intersects(const AabbShape& a, const AabbShape& b)
+{
+    return glm::all(glm::lessThanEqual(a.aabb_min, b.aabb_max)) && glm::all(glm::lessThanEqual(b.aabb_min, a.aabb_max));
+}
+
+bool Intersects(const AabbShape& a, const ObbShape& b)
+{
+    return Intersects(ObbShape{ Center(a), glm::mat3(1.0f), (a.aabb_max - a.aabb_min) * 0.5f }, b);
+}
+
+bool Intersects(const ObbShape& a, const ObbShape& b)
+{
+    // Separating axis test over the 15 candidate axes, Ericson, Real-Time Collision Detection 4.4.1
+    float r[3][3], abs_r[3][3];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            r[i][j] = glm::dot(a.axes[i], b.axes[j]);
+            abs_r[i][j] = std::fabs(r[i][j]) + PARALLEL_EPSILON;
+        }
+    }
+    const glm::vec3 offset = b.center - a.center;
+    const float t[3] = { glm::dot(offset, a.axes[0]), glm::dot(offset, a.axes[1]), glm::dot(offset, a.axes[2]) };
+    const glm::vec3& ea = a.half_extents;
+    const glm::vec3& eb = b.half_extents;
+
+    // Axes of a, then of b
+    for (int i = 0; i < 3; i++) {
+        if (std::fabs(t[i]) > ea[i] + eb[0] * abs_r[i][0] + eb[1] * abs_r[i][1] + eb[2] * abs_r[i][2])
+            return false;
+    }
+    for (int j = 0; j < 3; j++) {
+        if (std::fabs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > ea[0] * abs_r[0][j] + ea[1] * abs_r[1][j] + ea[2] * abs_r[2][j] + eb[j])
+            return false;
+    }
+    // Cross products of an axis of a (i) and one of b (j)
+    for (int i = 0; i < 3; i++) {
+        const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+        for (int j = 0; j < 3; j++) {
+            const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+            const float ra = ea[i1] * abs_r[i2][j] + ea[i2] * abs_r[i1][j];
+            const float rb = eb[j1] * abs_r[i][j2] + eb[j2] * abs_r[i][j1];
+            if (std::fabs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Intersects(const CapsuleShape& a, const CapsuleShape& b)
+{
+    const float reach = a.radius + b.radius;
+    return SegmentDistance2(a.a, a.b, b.a, b.b) <= reach * reach;
+}
+
+namespace gjk {
+
+bool Update(Simplex& simplex, glm::vec3& direction)
+{
+    glm::vec3& a = simplex.a;
+    glm::vec3& b = simplex.b;
+    glm::vec3& c = simplex.c;
+    glm::vec3& d = simplex.d;
+    const glm::vec3 ao = -a;
+
+    if (simplex.count == 2) {
+        // Segment, or its newest end alone
+        const glm::vec3 ab = b - a;
+        if (glm::dot(ab, ao) > 0.0f) {
+            direction = glm::cross(glm::cross(ab, ao), ab);
+        }
+        else {
+            simplex.count = 1;
+            direction = ao;
+        }
+        return false;
+    }
+
+    if (simplex.count == 3) {
+        // Triangle, or one of its edges at the newest point; kept wound so that the origin is above it
+        const glm::vec3 ab = b - a, ac = c - a;
+        const glm::vec3 normal = glm::cross(ab, ac);
+        if (glm::dot(glm::cross(ab, normal), ao) > 0.0f) {
+            simplex.count = 2;
+            direction = glm::cross(glm::cross(ab, ao), ab);
+        }
+        else if (glm::dot(glm::cross(normal, ac), ao) > 0.0f) {
+            simplex.count = 2;
+            b = c;
+            direction = glm::cross(glm::cross(ac, ao), ac);
+        }
+        else if (glm::dot(normal, ao) > 0.0f) {
+            direction = normal;
+        }
+        else {
+            std::swap(b, c);
+            direction = -normal;
+        }
+        return false;
+    }
+
+    // Tetrahedron: the origin is inside unless it is above one of the faces at the newest point
+    const glm::vec3 abc = glm::cross(b - a, c - a), acd = glm::cross(c - a, d - a), adb = glm::cross(d - a, b - a);
+    simplex.count = 3;
+    if (glm::dot(abc, ao) > 0.0f) {
+        direction = abc;
+        return false;
+    }
+    if (glm::dot(acd, ao) > 0.0f) {
+        b = c;
+        c = d;
+        direction = acd;
+        return false;
+    }
+    if (glm::dot(adb, ao) > 0.0f) {
+        c = b;
+        b = d;
+        direction = adb;
+        return false;
+    }
+    simplex.count = 4;
+    return true;
+}
+
+bool Closest(Vertex* simplex, int& count, float* weights, glm::vec3& closest)
+{
+    int corners[3] = { 0, 1, 2 };
+    float corner_weights[3] = { 1.0f, 0.0f, 0.0f };
+    int corner_count = count;
+    if (count == 2) {
+        SegmentWeights(simplex[0].point, simplex[1].point, corner_weights);
+    }
+    else if (count == 3) {
+        TriangleWeights(simplex[0].point, simplex[1].point, simplex[2].point, corner_weights);
+    }
+    else if (count == 4) {
+        // The nearest of the faces the origin is outside of; nearly flat tetrahedra have no inside,
+        // the sides of their faces are rounding noise
+        static constexpr int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+        const glm::vec3 ab = simplex[1].point - simplex[0].point, ac = simplex[2].point - simplex[0].point, ad = simplex[3].point - simplex[0].point;
+        const float size = std::max({ glm::length(ab), glm::length(ac), glm::length(ad) });
+        const bool flat = std::fabs(glm::dot(ab, glm::cross(ac, ad))) <= 1e-5f * size * size * size;
+        float best = std::numeric_limits<float>::max();
+        corner_count = 0;
+        for (const auto& face : faces) {
+            const glm::vec3& a = simplex[face[0]].point;
+            const glm::vec3 normal = glm::cross(simplex[face[1]].point - a, simplex[face[2]].point - a);
+            const float origin_side = -glm::dot(normal, a), opposite_side = glm::dot(normal, simplex[face[3]].point - a);
+            if (!flat && origin_side * opposite_side >= 0.0f)
+                continue;
+            float face_weights[3];
+            TriangleWeights(a, simplex[face[1]].point, simplex[face[2]].point, face_weights);
+            const glm::vec3 point = Weighted(simplex, face, face_weights, 3);
+            if (glm::dot(point, point) < best) {
+                best = glm::dot(point, point);
+                corner_count = 3;
+                for (int i = 0; i < 3; i++) {
+                    corners[i] = face[i];
+                    corner_weights[i] = face_weights[i];
+                }
+            }
+        }
+        if (corner_count == 0)
+            return false;
+    }
+
+    // Only the corners carrying weight stay
+    closest = Weighted(simplex, corners, corner_weights, corner_count);
+    Vertex kept[3];
+    int kept_count = 0;
+    for (int i = 0; i < corner_count; i++) {
+        if (corner_weights[i] > 0.0f) {
+            kept[kept_count] = simplex[corners[i]];
+            weights[kept_count] = corner_weights[i];
+            kept_count++;
+        }
+    }
+    for (int i = 0; i < kept_count; i++)
+        simplex[i] = kept[i];
+    count = kept_count;
+    return true;
+}
+
+} // namespace gjk
+
+bool Sweep(const SphereShape& moving, const glm::vec3& motion, const SphereShape& obstacle, SweepHit& hit)
+{
+    return SweepSphereSphere(moving.center, moving.radius, motion, obstacle.center, obstacle.radius, hit);
+}
+
+bool Sweep(const SphereShape& moving, const glm::vec3& motion, const AabbShape& obstacle, SweepHit& hit)
+{
+    return SweepSphereAabb(moving.center, moving.radius, motion, obstacle.aabb_min, obstacle.aabb_max, hit);
+}
+
+bool Sweep(const SphereShape& moving, const glm::vec3& motion, const ObbShape& obstacle, SweepHit& hit)
+{
+    const glm::mat3 to_box = glm::transpose(obstacle.axes);
+    if (!SweepSphereAabb(to_box * (moving.center - obstacle.center), moving.radius, to_box * motion, -obstacle.half_extents, obstacle.half_extents, hit))
+        return false;
+    hit.position = obstacle.center + obstacle.axes * hit.position;
+    hit.normal = obstacle.axes * hit.normal;
+    return true;
+}
+
+bool Contains(const Shape& shape, const glm::vec3& point)
+{
+    return std::visit([&point](const auto& alternative) { return Contains(alternative, point); }, shape);
+}
+
+bool Intersects(const Shape& a, const Shape& b)
+{
+    return std::visit([](const auto& first, const auto& second) { return Intersects(first, second); }, a, b);
+}
+
+void Bounds(const Shape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max)
+{
+    std::visit([&aabb_min, &aabb_max](const auto& alternative) { Bounds(alternative, aabb_min, aabb_max); }, shape);
+}
+
+bool Sweep(const SphereShape& moving, const glm::vec3& motion, const Shape& obstacle, SweepHit& hit)
+{
+    return std::visit([&moving, &motion, &hit](const auto& alternative) { return Sweep(moving, motion, alternative, hit); }, obstacle);
+}
+
+bool Sweep(const CapsuleShape& moving, const glm::vec3& motion, const Shape& obstacle, SweepHit& hit)
+{
+    return std::visit([&moving, &motion, &hit](const auto& alternative) { return Sweep(moving, motion, alternative, hit); }, obstacle);
+}
+
+int FirstSwept(const SphereShape& moving, const glm::vec3& motion, const Shape* shapes, const int* ids, size_t id_count, SweepHit& hit)
+{
+    int first = -1;
+    SweepHit shape_hit;
+    for (size_t i = 0; i < id_count; i++) {
+        if (Sweep(moving, motion, shapes[ids[i]], shape_hit) && (first < 0 || shape_hit.time < hit.time)) {
+            first = ids[i];
+            hit = shape_hit;
+        }
+    }
+    return first;
+}
+
+int FirstSwept(const CapsuleShape& moving, const glm::vec3& motion, const Shape* shapes, const int* ids, size_t id_count, SweepHit& hit)
+{
+    int first = -1;
+    SweepHit shape_hit;
+    for (size_t i = 0; i < id_count; i++) {
+        if (!Sweep(moving, motion, shapes[ids[i]], shape_hit))
+            continue;
+        // A shape that moved into the capsule does not hold it, motion out of the shape is free
+        if (shape_hit.time == 0.0f && glm::dot(motion, shape_hit.normal) >= 0.0f)
+            continue;
+        if (first < 0 || shape_hit.time < hit.time) {
+            first = ids[i];
+            hit = shape_hit;
+        }
+    }
+    return first;
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <variant>
+
+#include <glm/glm.hpp>
+
+#include "ConvexHull.hpp"
+#include "SweptCollision.hpp"
+
+constexpr int GJK_MAX_ITERATIONS = 32; // Pairs still undecided after this many support points count as touching
+constexpr int GJK_DISTANCE_MAX_ITERATIONS = 64; // Support points added at most per distance query
+constexpr int SWEEP_MAX_ITERATIONS = 32; // Advancement steps of a sweep, a grazing sweep still closing in after them hits where it is
+constexpr float SWEEP_TOLERANCE = 1e-4f; // Gap at which a sweep counts as touching
+
+// World space collision shapes
+struct SphereShape {
+    glm::vec3 center{ 0.0f };
+    float radius = 0.0f;
+};
+
+struct AabbShape {
+    glm::vec3 aabb_min{ 0.0f };
+    glm::vec3 aabb_max{ 0.0f };
+};
+
+struct ObbShape {
+    glm::vec3 center{ 0.0f };
+    glm::mat3 axes{ 1.0f }; // Unit box axes as columns
+    glm::vec3 half_extents{ 0.0f }; // Along the axes
+};
+
+struct CapsuleShape {
+    glm::vec3 a{ 0.0f }; // Segment the capsule surrounds
+    glm::vec3 b{ 0.0f };
+    float radius = 0.0f;
+};
+
+struct HullShape {
+    const ConvexHull* hull = nullptr; // Model space, owned by the mesh
+    glm::mat3 rotation{ 1.0f };
+    float scale = 1.0f;
+    glm::vec3 position{ 0.0f }; // World point = position + rotation * (scale * model point)
+};
+
+using Shape = std::variant<SphereShape, AabbShape, ObbShape, CapsuleShape, HullShape>;
+
+// Narrowphase tests between the shapes above
+//
+// Each shape has a center, a support function (its farthest point in a direction), a box around
+// it and a point test; spheres and capsules contain points strictly inside, the others points on
+// the surface too. Intersects() is overloaded for every pair of shape types: the pairs with a
+// closed form (spheres, boxes through the separating axis test, capsules through the closest
+// points of their segments) have their own kernels, all other pairs instantiate the GJK template
+// on their two support functions. The Shape overloads dispatch through std::visit, which picks
+// the kernel for the pair of alternatives with one jump; no kernel branches on the shape kind.
+//
+// Sweeps find the first contact of a sphere or capsule moving by a motion the same way: a sphere
+// against a sphere or box has a closed form, every other pair advances conservatively. Each shape
+// is a core (point, segment or polytope) grown by a margin; GJK gives the closest points of the
+// cores, and the moving shape is advanced by the gap over the speed at which it closes along the
+// line between them, which can never overshoot the contact.
+
+glm::vec3 Center(const SphereShape& shape);
+glm::vec3 Center(const AabbShape& shape);
+glm::vec3 Center(const ObbShape& shape);
+glm::vec3 Center(const CapsuleShape& shape);
+glm::vec3 Center(const HullShape& shape);
+
+glm::vec3 Support(const SphereShape& shape, const glm::vec3& direction);
+glm::vec3 Support(const AabbShape& shape, const glm::vec3& direction);
+glm::vec3 Support(const ObbShape& shape, const glm::vec3& direction);
+glm::vec3 Support(const CapsuleShape& shape, const glm::vec3& direction);
+glm::vec3 Support(const HullShape& shape, const glm::vec3& direction);
+
+void Bounds(const SphereShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max);
+void Bounds(const AabbShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max);
+void Bounds(const ObbShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max);
+void Bounds(const CapsuleShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max);
+void Bounds(const HullShape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max);
+
+// Margin around the core: the radius of spheres and capsules, 0 for the polytopes
+inline float Margin(const SphereShape& shape) { return shape.radius; }
+inline float Margin(const AabbShape&) { return 0.0f; }
+inline float Margin(const ObbShape&) { return 0.0f; }
+inline float Margin(const CapsuleShape& shape) { return shape.radius; }
+inline float Margin(const HullShape&) { return 0.0f; }
+
+// Support function of the core alone
+inline glm::vec3 CoreSupport(const SphereShape& shape, const glm::vec3&) { return shape.center; }
+inline glm::vec3 CoreSupport(const AabbShape& shape, const glm::vec3& direction) { return Support(shape, direction); }
+inline glm::vec3 CoreSupport(const ObbShape& shape, const glm::vec3& direction) { return Support(shape, direction); }
+inline glm::vec3 CoreSupport(const CapsuleShape& shape, const glm::vec3& direction) { return glm::dot(direction, shape.b - shape.a) >= 0.0f ? shape.b : shape.a; }
+inline glm::vec3 CoreSupport(const HullShape& shape, const glm::vec3& direction) { return Support(shape, direction); }
+
+bool Contains(const SphereShape& shape, const glm::vec3& point);
+bool Contains(const AabbShape& shape, const glm::vec3& point);
+bool Contains(const ObbShape& shape, const glm::vec3& point);
+bool Contains(const CapsuleShape& shape, const glm::vec3& point);
+bool Contains(const HullShape& shape, const glm::vec3& point);
+
+// Closed form pairs, the reversed orders forward to them
+bool Intersects(const SphereShape& a, const SphereShape& b);
+bool Intersects(const SphereShape& a, const AabbShape& b);
+bool Intersects(const SphereShape& a, const ObbShape& b);
+bool Intersects(const SphereShape& a, const CapsuleShape& b);
+bool Intersects(const AabbShape& a, const AabbShape& b);
+bool Intersects(const AabbShape& a, const ObbShape& b);
+bool Intersects(const ObbShape& a, const ObbShape& b);
+bool Intersects(const CapsuleShape& a, const CapsuleShape& b);
+
+inline bool Intersects(const AabbShape& a, const SphereShape& b) { return Intersects(b, a); }
+inline bool Intersects(const ObbShape& a, const SphereShape& b) { return Intersects(b, a); }
+inline bool Intersects(const CapsuleShape& a, const SphereShape& b) { return Intersects(b, a); }
+inline bool Intersects(const ObbShape& a, const AabbShape& b) { return Intersects(b, a); }
+
+namespace gjk {
+
+// Simplex of Minkowski difference points, a is the newest
+struct Simplex {
+    glm::vec3 a, b, c, d;
+    int count;
+};
+
+// Reduces a simplex of count + 1 points to the feature nearest the origin and sets the next
+// search direction towards the origin, true when the tetrahedron encloses the origin
+bool Update(Simplex& simplex, glm::vec3& direction);
+
+// Point of a Minkowski difference a - b with the support points of a and b it came from
+struct Vertex {
+    glm::vec3 point, on_a, on_b;
+};
+
+// Point of the simplex of count vertices nearest the origin as weights of its vertices; the
+// simplex keeps only the vertices of the nearest feature. False when a tetrahedron encloses the origin.
+bool Closest(Vertex* simplex, int& count, float* weights, glm::vec3& closest);
+
+} // namespace gjk
+
+// Every other pair: GJK on the Minkowski difference a - b, which holds the origin when they touch
+template <typename A, typename B>
+bool Intersects(const A& a, const B& b)
+{
+    auto support = [&a, &b](const glm::vec3& direction) { return Support(a, direction) - Support(b, -direction); };
+
+    gjk::Simplex simplex{};
+    glm::vec3 direction = Center(a) - Center(b);
+    if (glm::dot(direction, direction) == 0.0f)
+        direction = glm::vec3(1.0f, 0.0f, 0.0f);
+    simplex.a = support(direction);
+    simplex.count = 1;
+    direction = -simplex.a;
+    for (int i = 0; i < GJK_MAX_ITERATIONS; i++) {
+        // The origin is on the simplex
+        if (glm::dot(direction, direction) == 0.0f)
+            return true;
+        const glm::vec3 point = support(direction);
+        if (glm::dot(point, direction) < 0.0f)
+            return false;
+        simplex.d = simplex.c;
+        simplex.c = simplex.b;
+        simplex.b = simplex.a;
+        simplex.a = point;
+        simplex.count++;
+        if (gjk::Update(simplex, direction))
+            return true;
+    }
+    return true;
+}
+
+// Distance between the cores of a moved by offset and b with their closest points, 0 when the cores overlap
+template <typename A, typename B>
+float CoreDistance(const A& a, const glm::vec3& offset, const B& b, glm::vec3& point_a, glm::vec3& point_b)
+{
+    auto support = [&a, &offset, &b](const glm::vec3& direction) {
+        const glm::vec3 on_a = CoreSupport(a, direction) + offset, on_b = CoreSupport(b, -direction);
+        return gjk::Vertex{ on_a - on_b, on_a, on_b };
+    };
+
+    gjk::Vertex simplex[4];
+    float weights[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    int count = 1;
+    simplex[0] = support(Center(b) - Center(a) - offset);
+    glm::vec3 closest = simplex[0].point;
+    for (int i = 0; i < GJK_DISTANCE_MAX_ITERATIONS; i++) {
+        const float distance2 = glm::dot(closest, closest);
+        if (distance2 <= 1e-12f)
+            return 0.0f;
+        // Done when no support point comes nearer to the origin than the closest point found
+        const gjk::Vertex vertex = support(-closest);
+        if (distance2 - glm::dot(closest, vertex.point) <= 1e-6f * distance2)
+            break;
+        bool known = false;
+        for (int j = 0; j < count; j++)
+            known = known || vertex.point == simplex[j].point;
+        if (known)
+            break;
+        // Rounding can pick a farther feature once the new point is nearly in the simplex's plane, the nearer one stays then
+        gjk::Vertex previous[4] = { simplex[0], simplex[1], simplex[2], simplex[3] };
+        const float previous_weights[4] = { weights[0], weights[1], weights[2], weights[3] };
+        const int previous_count = count;
+        simplex[count++] = vertex;
+        const glm::vec3 previous_closest = closest;
+        if (!gjk::Closest(simplex, count, weights, closest))
+            return 0.0f;
+        if (glm::dot(closest, closest) >= distance2) {
+            std::copy(previous, previous + 4, simplex);
+            std::copy(previous_weights, previous_weights + 4, weights);
+            count = previous_count;
+            closest = previous_closest;
+            break;
+        }
+    }
+    point_a = point_b = glm::vec3(0.0f);
+    for (int j = 0; j < count; j++) {
+        point_a += simplex[j].on_a * weights[j];
+        point_b += simplex[j].on_b * weights[j];
+    }
+    return glm::length(closest);
+}
+
+// Closed form sweeps of a sphere, the box by SweepSphereAabb in its own frame
+bool Sweep(const SphereShape& moving, const glm::vec3& motion, const SphereShape& obstacle, SweepHit& hit);
+bool Sweep(const SphereShape& moving, const glm::vec3& motion, const AabbShape& obstacle, SweepHit& hit);
+bool Sweep(const SphereShape& moving, const glm::vec3& motion, const ObbShape& obstacle, SweepHit& hit);
+
+// Every other pair: conservative advancement, see above. A start with the cores overlapping hits at
+// time 0 with the normal from the obstacle's center towards the moving shape's.
+template <typename A, typename B>
+bool Sweep(const A& moving, const glm::vec3& motion, const B& obstacle, SweepHit& hit)
+{
+    const float margin = Margin(moving) + Margin(obstacle);
+    float time = 0.0f;
+    glm::vec3 normal(0.0f, 1.0f, 0.0f), on_obstacle(0.0f);
+    for (int i = 0; i < SWEEP_MAX_ITERATIONS; i++) {
+        glm::vec3 on_moving;
+        const float distance = CoreDistance(moving, motion * time, obstacle, on_moving, on_obstacle);
+        if (distance == 0.0f) {
+            const glm::vec3 away = Center(moving) + motion * time - Center(obstacle);
+            hit.time = time;
+            hit.normal = glm::dot(away, away) > 0.0f ? glm::normalize(away) : glm::vec3(0.0f, 1.0f, 0.0f);
+            hit.position = Center(moving) + motion * time;
+            return true;
+        }
+        normal = (on_moving - on_obstacle) / distance;
+        const float gap = distance - margin;
+        if (gap <= SWEEP_TOLERANCE)
+            break;
+        // The gap along the normal shrinks at this rate, the distance never faster
+        const float closing = -glm::dot(motion, normal);
+        if (closing <= 0.0f)
+            return false;
+        time += (gap - 0.5f * SWEEP_TOLERANCE) / closing;
+        if (time > 1.0f)
+            return false;
+    }
+    hit.time = time;
+    hit.normal = normal;
+    hit.position = on_obstacle + normal * Margin(obstacle);
+    return true;
+}
+
+// Dispatch on the alternatives held
+bool Contains(const Shape& shape, const glm::vec3& point);
+bool Intersects(const Shape& a, const Shape& b);
+void Bounds(const Shape& shape, glm::vec3& aabb_min, glm::vec3& aabb_max);
+bool Sweep(const SphereShape& moving, const glm::vec3& motion, const Shape& obstacle, SweepHit& hit);
+bool Sweep(const CapsuleShape& moving, const glm::vec3& motion, const Shape& obstacle, SweepHit& hit);
+
+// Of the shapes at ids[0, id_count), the one moving touches first, -1 if none
+int FirstSwept(const SphereShape& moving, const glm::vec3& motion, const Shape* shapes, const int* ids, size_t id_count, SweepHit& hit);
+// Same for a capsule, where shapes it overlaps at the start only block motion into them
+int FirstSwept(const CapsuleShape& moving, const glm::vec3& motion, const Shape* shapes, const int* ids, size_t id_count, SweepHit& hit);
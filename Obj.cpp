@@ -1,359 +1,175 @@
-﻿#include <iostream>
-#include <fstream>
+﻿#include <algorithm>
+#include <iostream>
 #include <string>
-#include "Miniball.hpp"
+#include <glm/gtc/quaternion.hpp>
 #include "Obj.hpp"
 #include "Texture.hpp"
 
 
-Obj::Obj(std::string name, const std::filesystem::path& path_main, const std::filesystem::path& path_tex, glm::vec3 position, float scale, glm::vec4 init_rotation, bool is_height_map, bool use_aabb) :
+Obj::Obj(std::string name, AssetManager& assets, const std::filesystem::path& path_main, const std::filesystem::path& path_tex, glm::vec3 position, float scale, glm::vec4 init_rotation, bool use_aabb, BoundingSphereMethod sphere_method) :
     name(std::move(name)),
     position(position),
     scale(scale),
     initial_rotation(init_rotation),
     use_aabb(use_aabb)
 {
-    if (!is_height_map)
-        LoadObj(path_main);
-    else
-        LoadHeightMap(path_main);
-
-    GLuint texture_id = textureInit(path_tex.string().c_str());
-    mesh = Mesh(GL_TRIANGLES, vertices, uv_coords, texture_id);
+    // Both are loaded in the background, the object appears once they are uploaded
+    mesh = assets.GetMesh(path_main, sphere_method);
+    texture = assets.GetTexture(path_tex);
+    previous_position = position;
 }
 
-
-void Obj::LoadObj(const std::filesystem::path& file_name)
+bool Obj::IsReady() const
 {
+    return mesh && mesh->ready && texture && texture->ready;
+}
 
-    std::vector<GLuint> vertexIndices, uvIndices, normalIndices;
-    std::vector<glm::vec3> temp_vertices;
-    std::vector<glm::vec2> temp_uvs;
-    std::vector<glm::vec3> temp_normals;
-
-    vertices.clear();
-    uv_coords.clear();
-
-    std::string first_two_chars, first_three_chars;
-    glm::vec2 uv;
-    glm::vec3 vertex_or_normal;
-
-    bool line_success;
-
-    std::string line;
-    std::ifstream file_reader(file_name);
-    while (getline(file_reader, line)) {
-        if (!line.empty()) {
-            line_success = true;
-            first_two_chars = line.substr(0, 2);
-            first_three_chars = line.substr(0, 3);
-            if (first_two_chars == "v ") {
-                vertex_or_normal = {};
-                (void)sscanf_s(line.c_str(), "v %f %f %f", &vertex_or_normal.x, &vertex_or_normal.y, &vertex_or_normal.z);
-                temp_vertices.push_back(vertex_or_normal);
-            }
-            else if (first_three_chars == "vt ") {
-                uv = {};
-                (void)sscanf_s(line.c_str(), "vt %f %f", &uv.x, &uv.y);
-                uv.y = -uv.y;
-                temp_uvs.push_back(uv);
-            }
-            else if (first_three_chars == "vn ") {
-                vertex_or_normal = {};
-                (void)sscanf_s(line.c_str(), "vn %f %f %f", &vertex_or_normal.x, &vertex_or_normal.y, &vertex_or_normal.z);
-                temp_normals.push_back(vertex_or_normal);
-            }
-            else if (first_two_chars == "f ") {
-                auto n = std::count(line.begin(), line.end(), '/');
-                if (n == 0) {
-                    unsigned int indices_temp[3]{};
-                    (void)sscanf_s(line.c_str(), "f %d %d %d", &indices_temp[0], &indices_temp[1], &indices_temp[2]);
-                    vertexIndices.insert(vertexIndices.end(), { indices_temp[0], indices_temp[1], indices_temp[2] });
-                }
-                else if (n == 3) {
-                    unsigned int indices_temp[6]{};
-                    (void)sscanf_s(line.c_str(), "f %d/%d %d/%d %d/%d", &indices_temp[0], &indices_temp[3], &indices_temp[1], &indices_temp[4], &indices_temp[2], &indices_temp[5]);
-                    vertexIndices.insert(vertexIndices.end(), { indices_temp[0], indices_temp[1], indices_temp[2] });
-                    uvIndices.insert(uvIndices.end(), { indices_temp[3], indices_temp[4], indices_temp[5] });
-                }
-                else if (n == 6) {
-
-                    if (line.find("//") != std::string::npos) {
-                        unsigned int indices_temp[6]{};
-                        (void)sscanf_s(line.c_str(), "f %d//%d %d//%d %d//%d", &indices_temp[0], &indices_temp[3], &indices_temp[1], &indices_temp[4], &indices_temp[2], &indices_temp[5]);
-                        vertexIndices.insert(vertexIndices.end(), { indices_temp[0], indices_temp[1], indices_temp[2] });
-                        normalIndices.insert(normalIndices.end(), { indices_temp[3], indices_temp[4], indices_temp[5] });
-                    }
-                    else {
-                        unsigned int indices_temp[9]{};
-                        (void)sscanf_s(line.c_str(), "f %d/%d/%d %d/%d/%d %d/%d/%d", &indices_temp[0], &indices_temp[3], &indices_temp[6], &indices_temp[1], &indices_temp[4], &indices_temp[7], &indices_temp[2], &indices_temp[5], &indices_temp[8]);
-                        vertexIndices.insert(vertexIndices.end(), { indices_temp[0], indices_temp[1], indices_temp[2] });
-                        uvIndices.insert(uvIndices.end(), { indices_temp[3], indices_temp[4], indices_temp[5] });
-                        normalIndices.insert(normalIndices.end(), { indices_temp[6], indices_temp[7], indices_temp[8] });
-                    }
-                }
-                else if (n == 8) {
-                    unsigned int v[4]{};
-                    unsigned int vt[4]{};
-                    unsigned int vn[4]{};
-                    (void)sscanf_s(line.c_str(), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d", &v[0], &vt[0], &vn[0], &v[1], &vt[1], &vn[1], &v[2], &vt[2], &vn[2], &v[3], &vt[3], &vn[3]);
-                    vertexIndices.insert(vertexIndices.end(), { v[0], v[1], v[2], v[0], v[2], v[3] });
-                    uvIndices.insert(uvIndices.end(), { vt[0], vt[1], vt[2], vt[0], vt[2], vt[3] });
-                    normalIndices.insert(normalIndices.end(), { vn[0], vn[1], vn[2], vn[0], vn[2], vn[3] });
-                }
-                else {
-                    line_success = false;
-                }
-            }
-            else {
-                line_success = false;
-            }
-        }
+MeshBounds Obj::GetCollisionBounds() const
+{
+    MeshBounds bounds;
+    if (mesh && mesh->ready) {
+        bounds.sphere_center = mesh->bounds.sphere_center * scale;
+        bounds.sphere_radius = mesh->bounds.sphere_radius * scale;
+        bounds.aabb_min = mesh->bounds.aabb_min * scale;
+        bounds.aabb_max = mesh->bounds.aabb_max * scale;
+        bounds.box.center = mesh->bounds.box.center * scale;
+        bounds.box.axes = mesh->bounds.box.axes;
+        bounds.box.half_extents = mesh->bounds.box.half_extents * scale;
     }
-    file_reader.close();
+    return bounds;
+}
 
-    // If not using AABB collision detection
-    if (!use_aabb) {
-        // Dimension of points (x, y, z)
-        int d = 3;
-        // Number of vertices
-        auto n = temp_vertices.size();
-        // Vector to store coordinates of points
-        std::vector<std::vector<float>> ap(n, std::vector<float>(d));
-        // Extract x, y, z coordinates of each vertex and store them
-        for (int i = 0; i < n; i++) {
-            ap[i][0] = temp_vertices[i].x;
-            ap[i][1] = temp_vertices[i].y;
-            ap[i][2] = temp_vertices[i].z;
-        }
-        // Define types for Miniball algorithm
-        typedef std::vector<float>::const_iterator CoordIterator;
-        typedef Miniball::Miniball <Miniball::CoordAccessor<std::vector<std::vector<float>>::const_iterator, CoordIterator>> MB;
-        // Compute bounding sphere using Miniball algorithm
-        MB mb(d, ap.begin(), ap.end());
-        // Get center of the bounding sphere
-        const float* center = mb.center();
-        // Assign center coordinates to collision_bs_center
-        for (int i = 0; i < d; ++i, ++center) collision_bs_center[i] = *center;
-        // Scale center and compute scaled radius
-        collision_bs_center *= scale;
-        collision_bs_radius = sqrt(mb.squared_radius()) * scale;
+bool Obj::GetCollisionShape(Shape& shape) const
+{
+    if (!mesh || !mesh->ready)
+        return false;
+
+    // The mesh's fitted shape carried by the model matrix; the matrix is the scale times a rotation
+    const glm::mat4 matrix = ModelMatrix();
+    const glm::mat3 rotation = glm::mat3(matrix) / scale;
+    const MeshBounds& bounds = mesh->bounds;
+    const BoundingShape kind = use_aabb || (bounds.shape == BoundingShape::Hull && !mesh->hull) ? BoundingShape::Box : bounds.shape;
+    switch (kind) {
+    case BoundingShape::Sphere:
+        shape = SphereShape{ glm::vec3(matrix * glm::vec4(bounds.sphere_center, 1.0f)), bounds.sphere_radius * scale };
+        break;
+    case BoundingShape::Capsule:
+        shape = CapsuleShape{ glm::vec3(matrix * glm::vec4(bounds.capsule.a, 1.0f)), glm::vec3(matrix * glm::vec4(bounds.capsule.b, 1.0f)), bounds.capsule.radius * scale };
+        break;
+    case BoundingShape::Hull:
+        shape = HullShape{ mesh->hull.get(), rotation, scale, position };
+        break;
+    default: {
+        // Boxes whose axes end up on the world axes keep the cheaper axis-aligned tests
+        const glm::vec3 center = glm::vec3(matrix * glm::vec4(bounds.box.center, 1.0f));
+        const glm::vec3 half_extents = bounds.box.half_extents * scale;
+        const glm::mat3 axes = rotation * bounds.box.axes;
+        if (axes == glm::mat3(1.0f))
+            shape = AabbShape{ center - half_extents, center + half_extents };
+        else
+            shape = ObbShape{ center, axes, half_extents };
+        break;
     }
-    // If using AABB collision detection
-    else {
-        // Initialize AABB min and max points
-        collision_aabb_min = temp_vertices[0];
-        collision_aabb_max = temp_vertices[0];
-        // Find minimum and maximum coordinates for each axis
-        for (const auto& point : temp_vertices) {
-            if (point.x < collision_aabb_min.x) collision_aabb_min.x = point.x;
-            if (point.y < collision_aabb_min.y) collision_aabb_min.y = point.y;
-            if (point.z < collision_aabb_min.z) collision_aabb_min.z = point.z;
-            if (point.x > collision_aabb_max.x) collision_aabb_max.x = point.x;
-            if (point.y > collision_aabb_max.y) collision_aabb_max.y = point.y;
-            if (point.z > collision_aabb_max.z) collision_aabb_max.z = point.z;
-        }
-        // Scale AABB coordinates
-        collision_aabb_min *= scale;
-        collision_aabb_max *= scale;
     }
+    return true;
+}
 
-    // Initialize vectors to hold processed data
-    std::vector<glm::vec3> vertices_direct;
-    std::vector<glm::vec2> texture_coordinates_direct;
-    std::vector<glm::vec3> vertex_normals_direct;
+bool Obj::GetCollisionAabb(glm::vec3& aabb_min, glm::vec3& aabb_max) const
+{
+    Shape shape;
+    if (!GetCollisionShape(shape))
+        return false;
+    Bounds(shape, aabb_min, aabb_max);
+    return true;
+}
 
-    // Process vertex, texture coordinate, and normal data
-    for (unsigned int u = 0; u < vertexIndices.size(); u++) {
-        vertices_direct.push_back(temp_vertices[vertexIndices[u] - 1]);
-    }
-    for (unsigned int u = 0; u < uvIndices.size(); u++) {
-        texture_coordinates_direct.push_back(temp_uvs[uvIndices[u] - 1]);
-    }
-    for (unsigned int u = 0; u < normalIndices.size(); u++) {
-        vertex_normals_direct.push_back(temp_normals[normalIndices[u] - 1]);
+void Obj::UpdateLod(const glm::vec3& camera_position, float projection_scale)
+{
+    if (!IsReady() || mesh->mesh.lods.size() < 2 || mesh->bounds.sphere_radius <= 0.0f) {
+        lod = 0;
+        return;
     }
+    const auto& lods = mesh->mesh.lods;
 
-    // Compute sizes for texture coordinates and normals
-    auto n_direct_uvs = texture_coordinates_direct.size();
-    auto n_direct_normals = vertex_normals_direct.size();
+    // Projected radius of the bounding sphere in pixels, full detail when the camera is inside it
+    const MeshBounds bounds = GetCollisionBounds();
+    float distance = glm::distance(camera_position, position + bounds.sphere_center) - bounds.sphere_radius;
+    if (distance <= 0.0f) {
+        lod = 0;
+        return;
+    }
+    float projected_radius = projection_scale * bounds.sphere_radius / distance;
+    float pixels_per_unit = projected_radius / mesh->bounds.sphere_radius; // Model units to pixels
 
-    // Populate output vertex data
-    for (unsigned int u = 0; u < vertices_direct.size(); u++) {
-        Vertex vertex{};
-        vertex.position = vertices_direct[u];
-        if (u < n_direct_uvs) vertex.tex_coords = texture_coordinates_direct[u];
-        if (u < n_direct_normals) vertex.normal = vertex_normals_direct[u];
-        vertices.push_back(vertex);
-        uv_coords.push_back(u);
+    // Refine as soon as the error shows, coarsen only well below the limit so that LODs do not pop back and forth
+    lod = std::min(lod, lods.size() - 1);
+    while (lod > 0 && lods[lod].error * pixels_per_unit > LOD_PIXEL_ERROR) {
+        lod--;
     }
+    while (lod + 1 < lods.size() && lods[lod + 1].error * pixels_per_unit < LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS)) {
+        lod++;
+    }
+}
 
-    // Print loaded file name
-    std::cout << "LoadObj: Loaded file: " << file_name << "\n";
+void Obj::SaveState()
+{
+    previous_position = position;
+    previous_rotation = rotation;
 }
 
-void Obj::Draw(ShaderProgram& shader)
+glm::mat4 Obj::ModelMatrix(float alpha) const
 {
     // Initialize model matrix as identity matrix
-    model_matrix = glm::mat4(1.0f);
+    glm::mat4 matrix(1.0f);
 
-    // Apply translation
-    model_matrix = glm::translate(model_matrix, position);
+    // Apply translation, interpolated between the simulation steps
+    matrix = glm::translate(matrix, glm::mix(previous_position, position, alpha));
 
     // Apply scaling
-    model_matrix = glm::scale(model_matrix, glm::vec3(scale));
+    matrix = glm::scale(matrix, glm::vec3(scale));
 
     // Initialize rotation axis from initial rotation
     glm::vec3 init_rotation_axes(initial_rotation);
 
     // Apply initial rotation
-    model_matrix = glm::rotate(model_matrix, glm::radians(initial_rotation.w), init_rotation_axes);
+    matrix = glm::rotate(matrix, glm::radians(initial_rotation.w), init_rotation_axes);
 
-    // Apply current rotation
-    glm::vec3 rotation_axes(rotation);
-    model_matrix = glm::rotate(model_matrix, glm::radians(rotation.w), rotation_axes);
-
-    // Draw the object using the current model matrix
-    mesh.Draw(shader, model_matrix);
+    // Apply current rotation, the shorter way from the saved one
+    if (alpha >= 1.0f || previous_rotation == rotation) {
+        glm::vec3 rotation_axes(rotation);
+        return glm::rotate(matrix, glm::radians(rotation.w), rotation_axes);
+    }
+    const glm::quat from = glm::angleAxis(glm::radians(previous_rotation.w), glm::normalize(glm::vec3(previous_rotation)));
+    const glm::quat to = glm::angleAxis(glm::radians(rotation.w), glm::normalize(glm::vec3(rotation)));
+    return matrix * glm::mat4_cast(glm::slerp(from, to, alpha));
 }
 
-void Obj::LoadHeightMap(const std::filesystem::path& file_name)
+void Obj::Draw(ShaderProgram& shader, float alpha)
 {
-    vertices.clear();
-    uv_coords.clear();
-    cv::Mat hmap = cv::imread(file_name.u8string(), cv::IMREAD_GRAYSCALE);
-    const unsigned int mesh_step_size = 5;
-    glm::vec3 a{};
-    glm::vec3 b{};
-    glm::vec3 c{};
-    unsigned int indices_counter = 0;
-
-    std::map<std::pair<unsigned int, unsigned int>, glm::vec3> normal_sums;
-    std::pair<unsigned int, unsigned int> pair, pair0, pair1, pair2, pair3;
-
-    if (hmap.empty())
+    if (!IsReady())
         return;
 
-    std::cout << "Note: heightmap size:" << hmap.size << ", channels: " << hmap.channels() << std::endl;
-
-
-    if (hmap.channels() != 1)
-    {
-        std::cerr << "WARN: requested 1 channel, got: " << hmap.channels() << std::endl;
-    }
-
-    // Create heightmap mesh from TRIANGLES in XZ plane, Y is UP (right hand rule)
-    //
-    //   3-----2
-    //   |    /|
-    //   |  /  |
-    //   |/    |
-    //   0-----1
-    //
-    //   012,023
-
-    for (unsigned int x_coord = 0; x_coord < (hmap.cols - mesh_step_size); x_coord += mesh_step_size) {
-        for (unsigned int z_coord = 0; z_coord < (hmap.rows - mesh_step_size); z_coord += mesh_step_size) {
-            // Get The (X, Y, Z) Value For The Bottom Left Vertex = 0
-            glm::vec3 p0(x_coord, hmap.at<uchar>(cv::Point(x_coord, z_coord)), z_coord);
-            // Get The (X, Y, Z) Value For The Bottom Right Vertex = 1
-            glm::vec3 p1(x_coord + mesh_step_size, hmap.at<uchar>(cv::Point(x_coord + mesh_step_size, z_coord)), z_coord);
-            // Get The (X, Y, Z) Value For The Top Right Vertex = 2
-            glm::vec3 p2(x_coord + mesh_step_size, hmap.at<uchar>(cv::Point(x_coord + mesh_step_size, z_coord + mesh_step_size)), z_coord + mesh_step_size);
-            // Get The (X, Y, Z) Value For The Top Left Vertex = 3
-            glm::vec3 p3(x_coord, hmap.at<uchar>(cv::Point(x_coord, z_coord + mesh_step_size)), z_coord + mesh_step_size);
-
-            // Get max normalized height for tile, set texture accordingly
-            // Grayscale image returns 0..256, normalize to 0.0f..1.0f by dividing by 256 (255 ?)
-            float max_h = std::max(hmap.at<uchar>(cv::Point(x_coord, z_coord)) / 256.0f,
-                std::max(hmap.at<uchar>(cv::Point(x_coord, z_coord + mesh_step_size)) / 256.0f,
-                    std::max(hmap.at<uchar>(cv::Point(x_coord + mesh_step_size, z_coord + mesh_step_size)) / 256.0f,
-                        hmap.at<uchar>(cv::Point(x_coord + mesh_step_size, z_coord)) / 256.0f
-                    )));
-
-
-            // Get texture coords in vertices, bottom left of geometry == bottom left of texture
-            // Get texture coords in vertices, bottom left of geometry == bottom left of texture
-            glm::vec2 texture_coords = HeightMap_GetSubtex(max_h);
-            glm::vec2 tc0 = texture_coords;
-            glm::vec2 tc1 = texture_coords + glm::vec2(1.0f / 16, 0.0f);		      // add offset for bottom right corner
-            glm::vec2 tc2 = texture_coords + glm::vec2(1.0f / 16, 1.0f / 16);    // add offset for top right corner
-            glm::vec2 tc3 = texture_coords + glm::vec2(0.0f, 1.0f / 16);         // add offset for bottom left corner
-
-            // compute normal vector
-            glm::vec3 normal1 = glm::normalize(glm::cross(p1 - p0, p2 - p0));
-            glm::vec3 normal2 = glm::normalize(glm::cross(p2 - p0, p3 - p0));
-            glm::vec3 avgNormal = (normal1 + normal2) * 0.5f; // Multiplication is marginally faster than division
-
-            // add vertices and texture coordinates to mesh
-            vertices.emplace_back(Vertex{ p0, -avgNormal, tc0 });
-            vertices.emplace_back(Vertex{ p1, -avgNormal, tc1 });
-            vertices.emplace_back(Vertex{ p2, -avgNormal, tc2 });
-            vertices.emplace_back(Vertex{ p3, -avgNormal, tc3 });
-
-            // update indices
-            indices_counter += 4;
-            uv_coords.insert(uv_coords.end(), { indices_counter - 4, indices_counter - 2, indices_counter - 3,
-                                            indices_counter - 4, indices_counter - 1, indices_counter - 2 });
-
-            // average normals
-            pair0 = { x_coord, z_coord };
-            pair1 = { x_coord + mesh_step_size, z_coord };
-            pair2 = { x_coord + mesh_step_size, z_coord + mesh_step_size };
-            pair3 = { x_coord, z_coord + mesh_step_size };
-            normal_sums[pair0] -= avgNormal;
-            normal_sums[pair1] -= avgNormal;
-            normal_sums[pair2] -= avgNormal;
-            normal_sums[pair3] -= avgNormal;
-
-        }
-    }
-
-    // averaging for normals, 2nd iteration
-    for (auto& vertex : vertices) {
-        // Calculate the index pair for the normal sum lookup
-        auto pair = std::make_pair(static_cast<unsigned int>(vertex.position.x), static_cast<unsigned int>(vertex.position.z));
-
-        // Calculate the normal by normalizing the summed normals directly
-        vertex.normal = glm::normalize(normal_sums[pair]);
-
-        // Store the vertex height for heightmap collision
-        _heights[{vertex.position.x* HEIGHTMAP_SCALE, vertex.position.z* HEIGHTMAP_SCALE}] = vertex.position.y;
-    }
-}
-
-glm::vec2 Obj::HeightMap_GetSubtex(const float height)
-{
-    if (height > 0.8)
-        return glm::vec2(1.0f / 16, 4.0f / 16);
-    else if (height > 0.5)
-        return glm::vec2(7.0f / 16, 1.0f / 16);
-    else if (height > 0.3)
-        return glm::vec2(4.0f / 16, 1.0f / 16);
-    else
-        return glm::vec2(1.0f / 16, 1.0f / 16);
+    // Draw the object using the current model matrix
+    model_matrix = ModelMatrix(alpha);
+    mesh->mesh.Draw(shader, model_matrix, texture->id, lod);
 }
 
-bool Obj::CheckCollisionWithPoint(glm::vec3 point) const
+bool Obj::GetWorldAabb(glm::vec3& aabb_min, glm::vec3& aabb_max) const
 {
-    // Bounding sphere
-    if (!use_aabb) {
-        return glm::distance(point, position + collision_bs_center) < collision_bs_radius;
-    }
-    // AABB
-    else {
-        return
-            point.x <= position.x + collision_aabb_max.x &&
-            point.x >= position.x + collision_aabb_min.x &&
-            point.y <= position.y + collision_aabb_max.y &&
-            point.y >= position.y + collision_aabb_min.y &&
-            point.z <= position.z + collision_aabb_max.z &&
-            point.z >= position.z + collision_aabb_min.z
-            ;
-    }
+    if (!mesh || !mesh->ready)
+        return false;
+
+    // Box around the fitted box carried by the model matrix, each world axis reaches as far as the box axes project on it
+    const glm::mat4 matrix = ModelMatrix();
+    const BoundingBox& box = mesh->bounds.box;
+    const glm::mat3 axes = glm::mat3(matrix) / scale * box.axes;
+    Bounds(ObbShape{ glm::vec3(matrix * glm::vec4(box.center, 1.0f)), axes, box.half_extents * scale }, aabb_min, aabb_max);
+    return true;
 }
 
 void Obj::Clear()
 {
-    mesh.Clear();
+    // Assets are released once no other object uses them
+    mesh.reset();
+    texture.reset();
 }
\ No newline at end of file
@@ -1,49 +1,57 @@
 #pragma once
 
 #include <filesystem>
-#include <map>
+#include <memory>
 
-#include "Vertex.hpp"
-#include "Mesh.hpp"
+#include "AssetManager.hpp"
+#include "MeshData.hpp"
+#include "Narrowphase.hpp"
 #include "ShaderProgram.hpp"
 
-#define HEIGHTMAP_SCALE 0.1f 
+constexpr float LOD_PIXEL_ERROR = 1.0f; // Largest simplification error allowed on screen, in pixels
+constexpr float LOD_HYSTERESIS = 0.3f; // A coarser LOD is taken only below (1 - LOD_HYSTERESIS) * LOD_PIXEL_ERROR
 
 class Obj
 {
 public:
     std::string name; // Name of the object
 
-    Obj(std::string name, const std::filesystem::path& path_main, const std::filesystem::path& path_tex, glm::vec3 position, float scale, glm::vec4 init_rotation, bool is_height_map, bool use_aabb); // Constructor
-    void Draw(ShaderProgram& shader); // Method to draw the object
+    Obj(std::string name, AssetManager& assets, const std::filesystem::path& path_main, const std::filesystem::path& path_tex, glm::vec3 position, float scale, glm::vec4 init_rotation, bool use_aabb, BoundingSphereMethod sphere_method = BoundingSphereMethod::Auto); // Constructor
+    void Draw(ShaderProgram& shader, float alpha = 1.0f); // Method to draw the object at alpha between the saved and the current state, skipped until the assets are loaded
     void Clear(); // Method to clear object data
+    bool IsReady() const; // Mesh and texture have been uploaded
+
+    // Picks the level of detail drawn next from the projected bounding sphere size
+    // projection_scale = viewport height / (2 * tan(fov / 2)), pixels per unit at distance 1
+    void UpdateLod(const glm::vec3& camera_position, float projection_scale);
+    size_t lod = 0; // Level of detail drawn, 0 = full detail
 
     glm::vec3 position{}; // Position of the object
     float scale{}; // Scale of the object
     glm::vec4 rotation = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f); // Rotation of the object
+    void SaveState(); // Remembers position and rotation before a simulation step, Draw interpolates from them
 
     float distance_from_camera; // Distance of the object from the camera
-    std::map<std::pair<float, float>, float> _heights; // Map to store height data
 
-    bool use_aabb; // Flag indicating whether to use axis-aligned bounding box for collision
-    glm::vec3 collision_bs_center{}; // Center of the bounding sphere for collision
-    float collision_bs_radius{}; // Radius of the bounding sphere for collision
-    glm::vec3 collision_aabb_min{}; // Minimum point of the axis-aligned bounding box
-    glm::vec3 collision_aabb_max{}; // Maximum point of the axis-aligned bounding box
-    bool CheckCollisionWithPoint(glm::vec3 point) const; // Method to check collision with a point
+    bool use_aabb; // Flag indicating whether to collide as the mesh box following the rotation instead of the mesh's fitted shape
+    MeshBounds GetCollisionBounds() const; // Mesh bounds scaled to the object, relative to position; empty until ready
+    bool GetCollisionShape(Shape& shape) const; // World collision shape, false until ready
+    bool GetCollisionAabb(glm::vec3& aabb_min, glm::vec3& aabb_max) const; // World box around the collision shape, false until ready
+
+    bool GetWorldAabb(glm::vec3& aabb_min, glm::vec3& aabb_max) const; // World box around the transformed mesh, false until ready
+    int scene_proxy = -1; // Leaf of the object in App::scene_tree
+    bool in_view = true; // Passed the last frustum query, drawn only then
 
 private:
-    Mesh mesh; // Mesh object
-    std::vector<Vertex> vertices{}; // Vector to store output vertices
-    std::vector<GLuint> uv_coords{}; // Vector to store output texture coordinates
+    std::shared_ptr<MeshAsset> mesh; // Mesh, shared with other objects using the same model
+    std::shared_ptr<TextureAsset> texture; // Texture, shared with other objects using the same image
 
     glm::mat4 model_matrix{}; // Model matrix
+    glm::mat4 ModelMatrix(float alpha = 1.0f) const; // Model matrix at alpha between the saved and the current position and rotation
+    glm::vec3 previous_position{}; // Saved by SaveState
+    glm::vec4 previous_rotation = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f); // Saved by SaveState
     glm::vec3 rotation_axes{}; // Rotation axes
     glm::vec3 initial_rotation_axes{}; // Initial rotation axes
 
     glm::vec4 initial_rotation{}; // Initial rotation
-
-    void LoadObj(const std::filesystem::path& file_name); // Method to load OBJ file
-    void LoadHeightMap(const std::filesystem::path& file_name); // Method to load heightmap
-    glm::vec2 HeightMap_GetSubtex(const float height); // Method to get subtexture from height
 };
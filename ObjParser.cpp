@@ -0,0 +1,564 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OBJ_PARSER_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define OBJ_PARSER_SSE2 0
+#endif
+
+#include "MappedFile.hpp"
+#include "ObjParser.hpp"
+#include "ThreadPool.hpp"
+
+void ObjData::Clear()
+{
+    positions.clear();
+    uvs.clear();
+    normals.clear();
+    position_indices.clear();
+    uv_indices.clear();
+    normal_indices.clear();
+}
+
+const char* ObjParserModeName(ObjParserMode mode)
+{
+    switch (mode) {
+    case ObjParserMode::Stream:
+        return "stream";
+    case ObjParserMode::Mapped:
+        return "mapped";
+    case ObjParserMode::Parallel:
+        return "parallel";
+    }
+    return "unknown";
+}
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Stream parser (std::getline + sscanf_s)
+// ---------------------------------------------------------------------------
+
+bool ParseObjStream(const std::filesystem::path& file_name, ObjData& data)
+{
+    std::ifstream file_reader(file_name);
+    if (!file_reader.is_open()) {
+        std::cerr << "ParseObj: cannot open " << file_name << "\n";
+        return false;
+    }
+
+    std::string first_two_chars, first_three_chars;
+    glm::vec2 uv;
+    glm::vec3 vertex_or_normal;
+
+    std::string line;
+    while (getline(file_reader, line)) {
+        if (line.empty())
+            continue;
+
+        first_two_chars = line.substr(0, 2);
+        first_three_chars = line.substr(0, 3);
+        if (first_two_chars == "v ") {
+            vertex_or_normal = {};
+            (void)sscanf_s(line.c_str(), "v %f %f %f", &vertex_or_normal.x, &vertex_or_normal.y, &vertex_or_normal.z);
+            data.positions.push_back(vertex_or_normal);
+        }
+        else if (first_three_chars == "vt ") {
+            uv = {};
+            (void)sscanf_s(line.c_str(), "vt %f %f", &uv.x, &uv.y);
+            uv.y = -uv.y;
+            data.uvs.push_back(uv);
+        }
+        else if (first_three_chars == "vn ") {
+            vertex_or_normal = {};
+            (void)sscanf_s(line.c_str(), "vn %f %f %f", &vertex_or_normal.x, &vertex_or_normal.y, &vertex_or_normal.z);
+            data.normals.push_back(vertex_or_normal);
+        }
+        else if (first_two_chars == "f ") {
+            auto n = std::count(line.begin(), line.end(), '/');
+            if (n == 0) {
+                unsigned int indices_temp[3]{};
+                (void)sscanf_s(line.c_str(), "f %d %d %d", &indices_temp[0], &indices_temp[1], &indices_temp[2]);
+                data.position_indices.insert(data.position_indices.end(), { indices_temp[0], indices_temp[1], indices_temp[2] });
+            }
+            else if (n == 3) {
+                unsigned int indices_temp[6]{};
+                (void)sscanf_s(line.c_str(), "f %d/%d %d/%d %d/%d", &indices_temp[0], &indices_temp[3], &indices_temp[1], &indices_temp[4], &indices_temp[2], &indices_temp[5]);
+                data.position_indices.insert(data.position_indices.end(), { indices_temp[0], indices_temp[1], indices_temp[2] });
+                data.uv_indices.insert(data.uv_indices.end(), { indices_temp[3], indices_temp[4], indices_temp[5] });
+            }
+            else if (n == 6) {
+                if (line.find("//") != std::string::npos) {
+                    unsigned int indices_temp[6]{};
+                    (void)sscanf_s(line.c_str(), "f %d//%d %d//%d %d//%d", &indices_temp[0], &indices_temp[3], &indices_temp[1], &indices_temp[4], &indices_temp[2], &indices_temp[5]);
+                    data.position_indices.insert(data.position_indices.end(), { indices_temp[0], indices_temp[1], indices_temp[2] });
+                    data.normal_indices.insert(data.normal_indices.end(), { indices_temp[3], indices_temp[4], indices_temp[5] });
+                }
+                else {
+                    unsigned int indices_temp[9]{};
+                    (void)sscanf_s(line.c_str(), "f %d/%d/%d %d/%d/%d %d/%d/%d", &indices_temp[0], &indices_temp[3], &indices_temp[6], &indices_temp[1], &indices_temp[4], &indices_temp[7], &indices_temp[2], &indices_temp[5], &indices_temp[8]);
+                    data.position_indices.insert(data.position_indices.end(), { indices_temp[0], indices_temp[1], indices_temp[2] });
+                    data.uv_indices.insert(data.uv_indices.end(), { indices_temp[3], indices_temp[4], indices_temp[5] });
+                    data.normal_indices.insert(data.normal_indices.end(), { indices_temp[6], indices_temp[7], indices_temp[8] });
+                }
+            }
+            else if (n == 8) {
+                unsigned int v[4]{};
+                unsigned int vt[4]{};
+                unsigned int vn[4]{};
+                (void)sscanf_s(line.c_str(), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d", &v[0], &vt[0], &vn[0], &v[1], &vt[1], &vn[1], &v[2], &vt[2], &vn[2], &v[3], &vt[3], &vn[3]);
+                data.position_indices.insert(data.position_indices.end(), { v[0], v[1], v[2], v[0], v[2], v[3] });
+                data.uv_indices.insert(data.uv_indices.end(), { vt[0], vt[1], vt[2], vt[0], vt[2], vt[3] });
+                data.normal_indices.insert(data.normal_indices.end(), { vn[0], vn[1], vn[2], vn[0], vn[2], vn[3] });
+            }
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Mapped parser (in-place tokenizer)
+// ---------------------------------------------------------------------------
+
+inline unsigned int CountTrailingZeros(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+// Returns pointer to the next '\n' in [p, end), or end; scans 16 bytes at a time
+inline const char* FindNewline(const char* p, const char* end)
+{
+#if OBJ_PARSER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask != 0)
+            return p + CountTrailingZeros(static_cast<unsigned int>(mask));
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '\n')
+        ++p;
+    return p;
+}
+
+inline bool IsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* SkipBlanks(const char* p, const char* end)
+{
+    while (p < end && IsBlank(*p))
+        ++p;
+    return p;
+}
+
+inline bool ParseFloat(const char*& p, const char* end, float& value)
+{
+    p = SkipBlanks(p, end);
+    if (p < end && *p == '+')
+        ++p;
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc())
+        return false;
+    p = ptr;
+    return true;
+}
+
+// Parses up to count floats, components that are missing stay untouched
+inline void ParseFloats(const char*& p, const char* end, float* values, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (!ParseFloat(p, end, values[i]))
+            return;
+    }
+}
+
+inline bool ParseIndex(const char*& p, const char* end, int& value)
+{
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc())
+        return false;
+    p = ptr;
+    return true;
+}
+
+// Parses one face corner: "v", "v/vt", "v//vn" or "v/vt/vn"; missing attributes are 0, negative values are relative
+inline bool ParseCorner(const char*& p, const char* end, int corner[3])
+{
+    corner[1] = 0;
+    corner[2] = 0;
+    if (!ParseIndex(p, end, corner[0]) || corner[0] == 0)
+        return false;
+    if (p < end && *p == '/') {
+        ++p;
+        if (p < end && *p != '/' && !ParseIndex(p, end, corner[1]))
+            return false;
+        if (p < end && *p == '/') {
+            ++p;
+            if (!ParseIndex(p, end, corner[2]))
+                return false;
+        }
+    }
+    return true;
+}
+
+enum class ObjRecord { None, Position, Uv, Normal, Face };
+
+// Classifies a line by its keyword, p is moved past the keyword
+inline ObjRecord ClassifyLine(const char*& p, const char* line_end)
+{
+    p = SkipBlanks(p, line_end);
+    const auto length = line_end - p;
+    if (length < 2)
+        return ObjRecord::None;
+
+    if (p[0] == 'v') {
+        if (IsBlank(p[1])) {
+            p += 2;
+            return ObjRecord::Position;
+        }
+        if (length >= 3 && IsBlank(p[2])) {
+            if (p[1] == 't') {
+                p += 3;
+                return ObjRecord::Uv;
+            }
+            if (p[1] == 'n') {
+                p += 3;
+                return ObjRecord::Normal;
+            }
+        }
+    }
+    else if (p[0] == 'f' && IsBlank(p[1])) {
+        p += 2;
+        return ObjRecord::Face;
+    }
+    return ObjRecord::None;
+}
+
+struct ObjRecordCounts {
+    size_t positions = 0;
+    size_t uvs = 0;
+    size_t normals = 0;
+    size_t faces = 0;
+};
+
+// Cheap pre-pass so that the output arrays can be reserved exactly
+ObjRecordCounts CountObjRecords(const char* begin, const char* end)
+{
+    ObjRecordCounts counts;
+    const char* p = begin;
+    while (p < end) {
+        const char* line_end = FindNewline(p, end);
+        switch (ClassifyLine(p, line_end)) {
+        case ObjRecord::Position: counts.positions++; break;
+        case ObjRecord::Uv: counts.uvs++; break;
+        case ObjRecord::Normal: counts.normals++; break;
+        case ObjRecord::Face: counts.faces++; break;
+        default: break;
+        }
+        p = line_end + 1;
+    }
+    return counts;
+}
+
+// Records parsed from one newline-aligned part of the file
+struct ObjChunk {
+    ObjData data;
+    // Relative (negative) face indices are stored as 1-based indices counted from the start of the chunk
+    // and need the number of records in the preceding chunks added; these are their positions in the index arrays
+    std::vector<size_t> relative_position_indices;
+    std::vector<size_t> relative_uv_indices;
+    std::vector<size_t> relative_normal_indices;
+    bool has_uv_indices = false;
+    bool has_normal_indices = false;
+};
+
+inline void PushIndex(int value, size_t record_count, std::vector<GLuint>& indices, std::vector<size_t>& relative_indices)
+{
+    if (value < 0) {
+        relative_indices.push_back(indices.size());
+        value += static_cast<int>(record_count) + 1;
+    }
+    indices.push_back(static_cast<GLuint>(value));
+}
+
+// Parses all records in [begin, end) into chunk
+void ParseObjRange(const char* begin, const char* end, ObjChunk& chunk)
+{
+    ObjData& data = chunk.data;
+
+    ObjRecordCounts counts = CountObjRecords(begin, end);
+    data.positions.reserve(counts.positions);
+    data.uvs.reserve(counts.uvs);
+    data.normals.reserve(counts.normals);
+    data.position_indices.reserve(counts.faces * 3);
+    data.uv_indices.reserve(counts.faces * 3);
+    data.normal_indices.reserve(counts.faces * 3);
+
+    const char* p = begin;
+    while (p < end) {
+        const char* line_end = FindNewline(p, end);
+        switch (ClassifyLine(p, line_end)) {
+        case ObjRecord::Position: {
+            glm::vec3 position{};
+            ParseFloats(p, line_end, &position.x, 3);
+            data.positions.push_back(position);
+            break;
+        }
+        case ObjRecord::Uv: {
+            glm::vec2 uv{};
+            ParseFloats(p, line_end, &uv.x, 2);
+            uv.y = -uv.y;
+            data.uvs.push_back(uv);
+            break;
+        }
+        case ObjRecord::Normal: {
+            glm::vec3 normal{};
+            ParseFloats(p, line_end, &normal.x, 3);
+            data.normals.push_back(normal);
+            break;
+        }
+        case ObjRecord::Face: {
+            // Triangulate polygons as a fan around the first corner
+            int first[3]{}, previous[3]{}, current[3]{};
+            int corner_count = 0;
+            while (true) {
+                p = SkipBlanks(p, line_end);
+                if (p >= line_end || !ParseCorner(p, line_end, current))
+                    break;
+                if (corner_count == 0) {
+                    std::copy(current, current + 3, first);
+                }
+                else if (corner_count >= 2) {
+                    for (const int* corner : { first, previous, current }) {
+                        PushIndex(corner[0], data.positions.size(), data.position_indices, chunk.relative_position_indices);
+                        PushIndex(corner[1], data.uvs.size(), data.uv_indices, chunk.relative_uv_indices);
+                        PushIndex(corner[2], data.normals.size(), data.normal_indices, chunk.relative_normal_indices);
+                        chunk.has_uv_indices |= corner[1] != 0;
+                        chunk.has_normal_indices |= corner[2] != 0;
+                    }
+                }
+                std::copy(current, current + 3, previous);
+                corner_count++;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        p = line_end + 1;
+    }
+}
+
+// Drops index arrays of attributes that no face referenced
+void DropUnusedIndices(ObjData& data, bool has_uv_indices, bool has_normal_indices)
+{
+    if (!has_uv_indices)
+        data.uv_indices.clear();
+    if (!has_normal_indices)
+        data.normal_indices.clear();
+}
+
+// Splits [begin, end) into chunk_count parts that start at line boundaries
+std::vector<const char*> SplitAtNewlines(const char* begin, const char* end, size_t chunk_count)
+{
+    std::vector<const char*> bounds{ begin };
+    const size_t size = end - begin;
+    for (size_t i = 1; i < chunk_count; i++) {
+        const char* split = std::max(begin + size * i / chunk_count, bounds.back());
+        split = FindNewline(split, end);
+        if (split < end)
+            ++split;
+        if (split > bounds.back() && split < end)
+            bounds.push_back(split);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+// Concatenates the chunks into data; prefix sums of the per-chunk record counts give each chunk's
+// destination offsets and the base for its relative face indices
+void MergeObjChunks(std::vector<ObjChunk>& chunks, ObjData& data)
+{
+    struct Offsets {
+        size_t positions = 0;
+        size_t uvs = 0;
+        size_t normals = 0;
+        size_t indices = 0;
+    };
+    std::vector<Offsets> offsets(chunks.size() + 1);
+    bool has_uv_indices = false;
+    bool has_normal_indices = false;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        const ObjData& chunk_data = chunks[c].data;
+        offsets[c + 1].positions = offsets[c].positions + chunk_data.positions.size();
+        offsets[c + 1].uvs = offsets[c].uvs + chunk_data.uvs.size();
+        offsets[c + 1].normals = offsets[c].normals + chunk_data.normals.size();
+        offsets[c + 1].indices = offsets[c].indices + chunk_data.position_indices.size();
+        has_uv_indices |= chunks[c].has_uv_indices;
+        has_normal_indices |= chunks[c].has_normal_indices;
+    }
+
+    const Offsets& total = offsets.back();
+    data.positions.resize(total.positions);
+    data.uvs.resize(total.uvs);
+    data.normals.resize(total.normals);
+    data.position_indices.resize(total.indices);
+    data.uv_indices.resize(total.indices);
+    data.normal_indices.resize(total.indices);
+
+    ThreadPool::Shared().ParallelFor(chunks.size(), [&](size_t c) {
+        const ObjChunk& chunk = chunks[c];
+        const Offsets& offset = offsets[c];
+
+        std::copy(chunk.data.positions.begin(), chunk.data.positions.end(), data.positions.begin() + offset.positions);
+        std::copy(chunk.data.uvs.begin(), chunk.data.uvs.end(), data.uvs.begin() + offset.uvs);
+        std::copy(chunk.data.normals.begin(), chunk.data.normals.end(), data.normals.begin() + offset.normals);
+
+        auto copy_indices = [&](const std::vector<GLuint>& source, std::vector<GLuint>& destination,
+            const std::vector<size_t>& relative_indices, size_t record_offset) {
+            std::copy(source.begin(), source.end(), destination.begin() + offset.indices);
+            for (size_t i : relative_indices) {
+                destination[offset.indices + i] = static_cast<GLuint>(source[i] + record_offset);
+            }
+        };
+        copy_indices(chunk.data.position_indices, data.position_indices, chunk.relative_position_indices, offset.positions);
+        copy_indices(chunk.data.uv_indices, data.uv_indices, chunk.relative_uv_indices, offset.uvs);
+        copy_indices(chunk.data.normal_indices, data.normal_indices, chunk.relative_normal_indices, offset.normals);
+    });
+
+    DropUnusedIndices(data, has_uv_indices, has_normal_indices);
+}
+
+bool ParseObjMapped(const std::filesystem::path& file_name, ObjData& data, bool parallel)
+{
+    MappedFile file(file_name);
+    if (!file.IsOpen()) {
+        std::cerr << "ParseObj: cannot open " << file_name << "\n";
+        return false;
+    }
+
+    const char* begin = file.Data();
+    const char* end = begin + file.Size();
+
+    // Workers plus the calling thread, but no chunks so small that the merge dominates
+    size_t chunk_count = 1;
+    if (parallel) {
+        chunk_count = std::min<size_t>(ThreadPool::Shared().ThreadCount() + 1, file.Size() / OBJ_PARALLEL_MIN_CHUNK_BYTES);
+    }
+
+    if (chunk_count <= 1) {
+        // With a single chunk the chunk-relative indices are already file-relative
+        ObjChunk chunk;
+        ParseObjRange(begin, end, chunk);
+        data = std::move(chunk.data);
+        DropUnusedIndices(data, chunk.has_uv_indices, chunk.has_normal_indices);
+        return true;
+    }
+
+    std::vector<const char*> bounds = SplitAtNewlines(begin, end, chunk_count);
+    std::vector<ObjChunk> chunks(bounds.size() - 1);
+    ThreadPool::Shared().ParallelFor(chunks.size(), [&](size_t c) {
+        ParseObjRange(bounds[c], bounds[c + 1], chunks[c]);
+    });
+
+    MergeObjChunks(chunks, data);
+    return true;
+}
+
+} // namespace
+
+void BuildIndexedMesh(const ObjData& data, std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+    vertices.clear();
+    indices.clear();
+
+    const size_t corner_count = data.position_indices.size();
+    indices.reserve(corner_count);
+
+    // Open addressing table from (v, vt, vn) to output vertex, sized to stay at most half full
+    size_t table_size = 16;
+    while (table_size < corner_count * 2)
+        table_size *= 2;
+    const GLuint empty_slot = ~0u;
+    std::vector<GLuint> table(table_size, empty_slot);
+    std::vector<std::array<GLuint, 3>> vertex_keys; // (v, vt, vn) of each output vertex
+    vertex_keys.reserve(corner_count / 2);
+    vertices.reserve(corner_count / 2);
+
+    // Out of range attribute indices are treated as missing; triangles with invalid positions are dropped
+    auto attribute_index = [](const std::vector<GLuint>& attribute_indices, size_t corner, size_t attribute_count) -> GLuint {
+        if (corner >= attribute_indices.size())
+            return 0;
+        GLuint index = attribute_indices[corner];
+        return index <= attribute_count ? index : 0;
+    };
+
+    for (size_t triangle = 0; triangle + 2 < corner_count; triangle += 3) {
+        std::array<GLuint, 3> keys[3];
+        bool valid = true;
+        for (size_t k = 0; k < 3; k++) {
+            size_t corner = triangle + k;
+            keys[k] = { attribute_index(data.position_indices, corner, data.positions.size()),
+                        attribute_index(data.uv_indices, corner, data.uvs.size()),
+                        attribute_index(data.normal_indices, corner, data.normals.size()) };
+            valid &= keys[k][0] != 0;
+        }
+        if (!valid)
+            continue;
+
+        for (const auto& key : keys) {
+            size_t hash = (key[0] * 73856093u) ^ (key[1] * 19349663u) ^ (key[2] * 83492791u);
+            size_t slot = hash & (table_size - 1);
+            while (table[slot] != empty_slot && vertex_keys[table[slot]] != key)
+                slot = (slot + 1) & (table_size - 1);
+
+            if (table[slot] == empty_slot) {
+                table[slot] = static_cast<GLuint>(vertices.size());
+                vertex_keys.push_back(key);
+
+                Vertex vertex{};
+                vertex.position = data.positions[key[0] - 1];
+                if (key[1] != 0) vertex.tex_coords = data.uvs[key[1] - 1];
+                if (key[2] != 0) vertex.normal = data.normals[key[2] - 1];
+                vertices.push_back(vertex);
+            }
+            indices.push_back(table[slot]);
+        }
+    }
+}
+
+bool ParseObj(const std::filesystem::path& file_name, ObjData& data, ObjParserMode mode)
+{
+    data.Clear();
+
+    switch (mode) {
+    case ObjParserMode::Stream:
+        return ParseObjStream(file_name, data);
+    case ObjParserMode::Mapped:
+        return ParseObjMapped(file_name, data, false);
+    case ObjParserMode::Parallel:
+        return ParseObjMapped(file_name, data, true);
+    }
+    return false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Vertex.hpp"
+
+// Selects how OBJ files are read
+enum class ObjParserMode {
+    Stream, // std::getline + sscanf_s, line by line
+    Mapped, // memory-mapped file, tokenized in place with std::from_chars, no per-line allocations
+    Parallel // Mapped, split into newline-aligned chunks parsed on the shared thread pool
+};
+
+constexpr ObjParserMode OBJ_PARSER_MODE = ObjParserMode::Parallel; // Parser used for model files, Stream = original getline/sscanf_s reader
+constexpr size_t OBJ_PARALLEL_MIN_CHUNK_BYTES = 1 << 20; // Files below two chunks are parsed on the calling thread
+
+// Raw OBJ records as written in the file
+struct ObjData {
+    std::vector<glm::vec3> positions; // "v" records
+    std::vector<glm::vec2> uvs; // "vt" records, y is flipped
+    std::vector<glm::vec3> normals; // "vn" records
+
+    // Triangulated face corners, 1-based indices into the arrays above
+    // Mapped/Parallel parser: uv/normal index arrays are either empty or parallel to position_indices, 0 = attribute missing
+    std::vector<GLuint> position_indices;
+    std::vector<GLuint> uv_indices;
+    std::vector<GLuint> normal_indices;
+
+    void Clear();
+};
+
+// Parses an OBJ file into data, returns false if the file cannot be read
+bool ParseObj(const std::filesystem::path& file_name, ObjData& data, ObjParserMode mode);
+
+// Builds an indexed triangle list, corners with identical (v, vt, vn) share one vertex
+void BuildIndexedMesh(const ObjData& data, std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+// Human readable name of the parser mode, for load statistics
+const char* ObjParserModeName(ObjParserMode mode);
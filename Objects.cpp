@@ -1,17 +1,19 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <filesystem>
 #include "App.hpp"
 #include <opencv2/opencv.hpp>
 
 // Function to create a model object
-Obj* App::CreateModel(const std::string& name, const std::string& obj, const std::string& tex, bool is_opaque, const glm::vec3& position, float scale, const glm::vec4& rotation, bool collision, bool use_aabb)
+Obj* App::CreateModel(const std::string& name, const std::string& obj, const std::string& tex, bool is_opaque, const glm::vec3& position, float scale, const glm::vec4& rotation, bool collision, bool use_aabb, BoundingSphereMethod sphere_method)
 {
     // Construct paths for model and texture
     std::filesystem::path modelpath("./resources/objects/" + obj);
     std::filesystem::path texturepath("./resources/textures/" + tex);
 
-    // Create a new Obj instance
-    auto model = new Obj(name, modelpath, texturepath, position, scale, rotation, false, use_aabb);
+    // Create a new Obj instance, the mesh and texture are loaded once and shared
+    auto model = new Obj(name, assets, modelpath, texturepath, position, scale, rotation, use_aabb, sphere_method);
 
     // Insert the model into the appropriate scene container based on its opacity
     if (is_opaque) {
@@ -21,14 +23,91 @@ Obj* App::CreateModel(const std::string& name, const std::string& obj, const std
         transparent_scene.insert({ name, model });
     }
 
+    // Index the object, a point at its position until the mesh has loaded
+    model->scene_proxy = scene_tree.CreateProxy(position, position, model);
+
     // Add the model to the collisions vector if collision is enabled
     if (collision) {
         collisions.push_back(model);
+        // Shape and bounds are known once the mesh has loaded, until then the object is in no grid cell
+        collision_grid.Insert();
+        collision_shapes.Add();
+        collision_exact_shapes.emplace_back();
+        collision_bodies.push_back(-1);
+        collisions_without_bounds.push_back(static_cast<int>(collisions.size()) - 1);
     }
 
     return model;
 }
 
+// Function to remember the simulated state that the next frames interpolate from
+void App::SaveSimulationState()
+{
+    previous_camera_position = camera.position;
+    for (auto& [key, value] : opaque_scene)
+        value->SaveState();
+    for (auto& [key, value] : transparent_scene)
+        value->SaveState();
+}
+
+// Function to refit the scene index and cull the objects against the view frustum
+void App::UpdateSceneTree(const glm::mat4& mx_view_projection)
+{
+    auto refit = [this](Obj* model) {
+        glm::vec3 aabb_min, aabb_max;
+        if (!model->GetWorldAabb(aabb_min, aabb_max))
+            aabb_min = aabb_max = model->position;
+        scene_tree.MoveProxy(model->scene_proxy, aabb_min, aabb_max);
+        model->in_view = false;
+    };
+    for (auto& [key, value] : opaque_scene)
+        refit(value);
+    for (auto& [key, value] : transparent_scene)
+        refit(value);
+
+    // Only the visited leaves are drawn, whole subtrees outside the frustum are skipped
+    objects_in_view = 0;
+    scene_tree.QueryFrustum(Frustum(mx_view_projection), [this](int proxy) {
+        static_cast<Obj*>(scene_tree.UserData(proxy))->in_view = true;
+        objects_in_view++;
+        return true;
+    });
+}
+
+// Function to find the closest object whose world box a ray hits
+Obj* App::PickObject(const glm::vec3& origin, const glm::vec3& direction, float max_distance, float& distance) const
+{
+    const glm::vec3 unit = glm::normalize(direction);
+    Obj* picked = nullptr;
+    scene_tree.Raycast(origin, unit, max_distance, [&](int proxy, float reach) {
+        // The fat box only narrows the search, test the object's own box
+        auto model = static_cast<Obj*>(scene_tree.UserData(proxy));
+        glm::vec3 aabb_min, aabb_max;
+        if (!model->GetWorldAabb(aabb_min, aabb_max))
+            return reach;
+        float t_near = 0.0f, t_far = reach;
+        for (int axis = 0; axis < 3; axis++) {
+            if (unit[axis] == 0.0f) {
+                if (origin[axis] < aabb_min[axis] || origin[axis] > aabb_max[axis])
+                    return reach;
+                continue;
+            }
+            const float t0 = (aabb_min[axis] - origin[axis]) / unit[axis];
+            const float t1 = (aabb_max[axis] - origin[axis]) / unit[axis];
+            t_near = std::max(t_near, std::min(t0, t1));
+            t_far = std::min(t_far, std::max(t0, t1));
+        }
+        // Boxes around the origin, such as the camera's own, are looked through
+        if (t_near > t_far || t_near <= 0.0f)
+            return reach;
+        // Closer hits only from now on
+        picked = model;
+        distance = t_near;
+        return t_near;
+    });
+    return picked;
+}
+
 // Function to update model rotations
 void App::UpdateModel(float delta_time)
 {
@@ -44,11 +123,18 @@ void App::UpdateModel(float delta_time)
         }
         };
 
-    float angle = glfwGetTime() * 23.0f;
+    // Simulation time, not the wall clock: every step turns the spheres further and Draw interpolates between the steps
+    model_angle = std::fmod(model_angle + 23.0f * delta_time, 360.0f);
+    const float angle = model_angle;
     for (int i = 1; i <= 10; ++i) {
         std::string name = "obj_sphere_" + std::to_string(i);
         updateRotation(name, angle * (i % 3 == 0 ? 2 : 1));
     }
+    // The fitted shapes and grid cells of the turned spheres follow their new pose
+    for (int id = 0; id < static_cast<int>(collisions.size()); id++) {
+        if (collisions[id]->name.substr(0, 10) == "obj_sphere")
+            UpdateCollisionBounds(id);
+    }
 }
 
 // Function to initialize the scene
@@ -57,21 +143,52 @@ void App::InitScene()
     // Load shader programs
     std::filesystem::path VS_path("./resources/shaders/shader.vert");
     std::filesystem::path FS_path("./resources/shaders/shader.frag");
+    std::filesystem::path terrain_VS_path("./resources/shaders/terrain.vert");
     my_shader = ShaderProgram(VS_path, FS_path);
+    terrain_shader = ShaderProgram(terrain_VS_path, FS_path);
+    // The tessellated terrain is optional, CDLOD is used where it does not build
+    try {
+        terrain_tessellation_shader = ShaderProgram("./resources/shaders/terrain_tess.vert", "./resources/shaders/terrain.tesc",
+            "./resources/shaders/terrain.tese", FS_path);
+        terrain_tessellation_supported = true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Terrain: Tessellation shaders unavailable, using CDLOD only: " << e.what() << "\n";
+    }
 
     glm::vec3 position;
     float scale;
     glm::vec4 rotation;
 
-    // Load heightmap object
+    // Load heightmap terrain
     std::filesystem::path heightspath("./resources/textures/heights.png");
     std::filesystem::path texturepath("./resources/textures/tex_256.png");
     position = glm::vec3(-HEIGHTMAP_SHIFT, 0.0f, -HEIGHTMAP_SHIFT);
-    scale = HEIGHTMAP_SCALE;
-    rotation = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
-    auto obj_heightmap = new Obj("heightmap", heightspath, texturepath, position, scale, rotation, true, false);
-    opaque_scene.insert({ "obj_heightmap", obj_heightmap });
-    _heights = &obj_heightmap->_heights;
+    terrain.Load(assets, heightspath, texturepath, position, HEIGHTMAP_SCALE);
+
+    // Rigid bodies and the player rest on the heightmap, its normal by central differences over one sample;
+    // the four neighbors are one batched lookup
+    auto ground = [this](float x, float z, glm::vec3& normal) {
+        const float xs[4] = { x - HEIGHTMAP_SCALE, x + HEIGHTMAP_SCALE, x, x };
+        const float zs[4] = { z, z, z - HEIGHTMAP_SCALE, z + HEIGHTMAP_SCALE };
+        float heights[4];
+        GetHeightmapY(xs, zs, heights, 4);
+        normal = glm::normalize(glm::vec3(heights[0] - heights[1], 2.0f * HEIGHTMAP_SCALE, heights[2] - heights[3]));
+        return GetHeightmapY(x, z);
+    };
+    physics.SetGround(ground);
+    player.SetGround(ground);
+
+    // The player collides with the collisions in the grid cells around its sweep only, however many the level holds
+    player.SetSweep([this](const glm::vec3& base, float height, float radius, const glm::vec3& motion, SweepHit& hit) {
+        const float reach = radius + SWEEP_TOLERANCE;
+        const glm::vec3 low = base - glm::vec3(reach), high = base + glm::vec3(reach, height + reach, reach);
+        const glm::vec3 sweep_min = glm::min(low, low + motion), sweep_max = glm::max(high, high + motion);
+        collision_grid.QueryAabb(sweep_min, sweep_max, collision_candidates);
+        collision_candidates.resize(collision_shapes.Overlapping(sweep_min, sweep_max, collision_candidates.data(), collision_candidates.size()));
+        const CapsuleShape capsule{ base, base + glm::vec3(0.0f, height, 0.0f), radius };
+        return FirstSwept(capsule, motion, collision_exact_shapes.data(), collision_candidates.data(), collision_candidates.size(), hit) >= 0;
+    });
 
     // Create boxes
     position = glm::vec3(4.0f, 0.5f, 15.0f);
@@ -111,6 +228,12 @@ void App::InitScene()
     position = glm::vec3(2.5f, 3.5f, 15.0f);
     CreateModel("obj_box10", "box.obj", "box.png", true, position, scale, rotation, true, true);
 
+    // The pyramid is simulated, see App::UpdatePhysics
+    for (int id = 0; id < static_cast<int>(collisions.size()); id++) {
+        if (collisions[id]->name.substr(0, 7) == "obj_box")
+            bodies_pending.push_back(id);
+    }
+
 
 
     // Create spheres in a circular pattern
@@ -151,4 +274,7 @@ void App::InitScene()
     for (auto& pair : transparent_scene) {
         transparent_scene_pairs.push_back(&pair);
     }
+
+    // Loads continue in the background, see App::Run
+    assets.PrintStatistics();
 }
@@ -1,9 +1,17 @@
+#include <string>
+
 #include "app.hpp"
+#include "CollisionShapes.hpp"
 
 App app;
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Measurements without a window
+    if (argc > 1 && std::string(argv[1]) == "--bench-collision") {
+        return RunCollisionBenchmark();
+    }
+
     if (app.Init()) {
         return app.Run();
     }
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/packing.hpp>
+
+#include "PackedVertex.hpp"
+
+namespace {
+
+glm::vec2 SignNotZero(glm::vec2 v)
+{
+    return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+glm::vec2 OctahedralEncode(glm::vec3 normal)
+{
+    // Project onto the octahedron |x| + |y| + |z| = 1, fold the lower half over the diagonals
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec2 encoded = glm::vec2(normal.x, normal.y) / length;
+    if (normal.z < 0.0f)
+        encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * SignNotZero(encoded);
+    return encoded;
+}
+
+} // namespace
+
+void PackMesh(const MeshData& data, PackedMeshData& packed)
+{
+    packed = PackedMeshData();
+    if (data.vertices.empty())
+        return;
+
+    // Quantization box, computed from the vertices as not every builder fills data.bounds
+    glm::vec3 aabb_min = data.vertices[0].position;
+    glm::vec3 aabb_max = data.vertices[0].position;
+    for (const auto& vertex : data.vertices) {
+        aabb_min = glm::min(aabb_min, vertex.position);
+        aabb_max = glm::max(aabb_max, vertex.position);
+    }
+    packed.position_offset = aabb_min;
+    packed.position_scale = aabb_max - aabb_min;
+    // Flat axes decode to offset whatever is stored
+    glm::vec3 inverse_scale;
+    for (int axis = 0; axis < 3; axis++)
+        inverse_scale[axis] = packed.position_scale[axis] > 0.0f ? 1.0f / packed.position_scale[axis] : 0.0f;
+
+    packed.vertices.resize(data.vertices.size());
+    for (size_t i = 0; i < data.vertices.size(); i++) {
+        const Vertex& vertex = data.vertices[i];
+        PackedVertex& out = packed.vertices[i];
+
+        glm::vec3 unit_position = (vertex.position - aabb_min) * inverse_scale;
+        for (int axis = 0; axis < 3; axis++)
+            out.position[axis] = glm::packUnorm1x16(unit_position[axis]);
+        out.position[3] = 0;
+
+        glm::vec2 normal = OctahedralEncode(vertex.normal);
+        out.normal[0] = static_cast<int16_t>(glm::packSnorm1x16(normal.x));
+        out.normal[1] = static_cast<int16_t>(glm::packSnorm1x16(normal.y));
+
+        out.tex_coords[0] = glm::packHalf1x16(vertex.tex_coords.x);
+        out.tex_coords[1] = glm::packHalf1x16(vertex.tex_coords.y);
+    }
+
+    if (data.vertices.size() <= std::numeric_limits<uint16_t>::max() + size_t(1)) {
+        packed.indices16.resize(data.indices.size());
+        for (size_t i = 0; i < data.indices.size(); i++)
+            packed.indices16[i] = static_cast<uint16_t>(data.indices[i]);
+    }
+    else {
+        packed.indices32 = data.indices;
+    }
+    packed.lods = data.lods;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "MeshData.hpp"
+
+// Selects the vertex layout meshes are uploaded with
+enum class MeshVertexFormat {
+    Float, // Vertex, 32 bytes, 32 bit indices
+    Packed // PackedVertex, 16 bytes, 16 bit indices when possible
+};
+
+constexpr MeshVertexFormat MESH_VERTEX_FORMAT = MeshVertexFormat::Packed; // Layout used for uploaded meshes
+
+// Quantized vertex, decoded by shader.vert
+struct PackedVertex {
+    uint16_t position[4]; // Unorm16 inside the mesh AABB, w is padding
+    int16_t normal[2]; // Octahedral encoded unit normal, snorm16
+    uint16_t tex_coords[2]; // Half floats
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+// CPU side packed mesh, ready to be uploaded by Mesh
+struct PackedMeshData {
+    std::vector<PackedVertex> vertices;
+    std::vector<uint16_t> indices16; // Used when all indices fit, otherwise indices32
+    std::vector<GLuint> indices32;
+    std::vector<MeshLod> lods; // Ranges in whichever index array is used
+    glm::vec3 position_offset{ 0.0f }; // Decoded position = offset + unorm * scale
+    glm::vec3 position_scale{ 1.0f };
+};
+
+// Quantizes data into packed, data is left unchanged
+void PackMesh(const MeshData& data, PackedMeshData& packed);
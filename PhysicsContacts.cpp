@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "PhysicsWorld.hpp"
+
+// Contact generation of PhysicsWorld
+//
+// Box pairs use the separating axis test over the 15 candidate axes (3 face normals of each box,
+// 9 edge cross products). When a face normal separates least, the most anti-parallel face of the
+// other box is clipped against the side planes of that reference face, giving up to 8 points that
+// are reduced to the 4 spanning the largest area. Otherwise the closest points of the two edges
+// give one contact. Face axes are preferred within a tolerance, so that resting boxes keep stable
+// face contacts. Contacts are kept up to PHYSICS_CONTACT_MARGIN apart.
+
+namespace {
+
+constexpr float AXIS_EPSILON = 1e-5f; // Shorter edge cross products are parallel edges, their axis is skipped
+constexpr float AXIS_PREFERENCE = 0.005f; // Box b's faces and then the edges must separate this much more to be used, keeps the contact type stable
+constexpr int MAX_POLYGON_POINTS = 8; // A quad clipped by four planes gains at most one point per plane
+
+struct Box {
+    glm::vec3 center;
+    glm::mat3 axes; // Columns
+    glm::vec3 half;
+};
+
+struct ContactCandidate {
+    glm::vec3 position;
+    float separation;
+};
+
+// Fixed capacity, contacts are generated for every pair in every step
+struct ContactCandidates {
+    ContactCandidate points[MAX_POLYGON_POINTS];
+    int count = 0;
+
+    void Add(const glm::vec3& position, float separation)
+    {
+        if (count < MAX_POLYGON_POINTS)
+            points[count++] = { position, separation };
+    }
+};
+
+struct Polygon {
+    glm::vec3 points[MAX_POLYGON_POINTS];
+    int count = 0;
+
+    void Add(const glm::vec3& point)
+    {
+        if (count < MAX_POLYGON_POINTS)
+            points[count++] = point;
+    }
+};
+
+Box MakeBox(const RigidBody& body)
+{
+    return { body.position, glm::mat3_cast(body.orientation), body.half_extents };
+}
+
+float Sign(float value)
+{
+    return value < 0.0f ? -1.0f : 1.0f;
+}
+
+// Half length of the box projected on axis
+float ProjectedRadius(const Box& box, const glm::vec3& axis)
+{
+    return box.half.x * std::fabs(glm::dot(box.axes[0], axis)) + box.half.y * std::fabs(glm::dot(box.axes[1], axis)) + box.half.z * std::fabs(glm::dot(box.axes[2], axis));
+}
+
+// Keeps the part of the polygon with dot(normal, p) <= offset (Sutherland-Hodgman)
+void ClipPolygon(Polygon& polygon, const glm::vec3& normal, float offset)
+{
+    Polygon clipped;
+    for (int i = 0; i < polygon.count; i++) {
+        const glm::vec3& from = polygon.points[i];
+        const glm::vec3& to = polygon.points[(i + 1) % polygon.count];
+        const float distance_from = glm::dot(normal, from) - offset, distance_to = glm::dot(normal, to) - offset;
+        if (distance_from <= 0.0f)
+            clipped.Add(from);
+        // Points on the plane are kept above, crossing only strictly through it adds no duplicate
+        if ((distance_from < 0.0f && distance_to > 0.0f) || (distance_from > 0.0f && distance_to < 0.0f))
+            clipped.Add(from + (to - from) * (distance_from / (distance_from - distance_to)));
+    }
+    polygon = clipped;
+}
+
+// At most four of the candidates: the deepest, the farthest from it, then the two spanning most area on either side
+void ReduceContacts(ContactCandidates& candidates, const glm::vec3& normal)
+{
+    if (candidates.count <= 4)
+        return;
+    const ContactCandidate* begin = candidates.points;
+    const ContactCandidate* end = candidates.points + candidates.count;
+    auto deepest = std::min_element(begin, end, [](const ContactCandidate& a, const ContactCandidate& b) { return a.separation < b.separation; });
+    const ContactCandidate first = *deepest;
+
+    auto farthest = [&](auto score) {
+        return *std::max_element(begin, end, [&](const ContactCandidate& a, const ContactCandidate& b) { return score(a) < score(b); });
+    };
+    const ContactCandidate second = farthest([&](const ContactCandidate& c) {
+        const glm::vec3 offset = c.position - first.position;
+        return glm::dot(offset, offset);
+    });
+    auto signed_area = [&](const ContactCandidate& c) {
+        return glm::dot(glm::cross(second.position - first.position, c.position - first.position), normal);
+    };
+    const ContactCandidate third = farthest(signed_area);
+    const ContactCandidate fourth = farthest([&](const ContactCandidate& c) { return -signed_area(c); });
+    candidates.points[0] = first;
+    candidates.points[1] = second;
+    candidates.points[2] = third;
+    candidates.points[3] = fourth;
+    candidates.count = 4;
+}
+
+// Contacts of boxes a and b, normal from a towards b
+bool CollideBoxes(const Box& a, const Box& b, glm::vec3& normal, ContactCandidates& contacts)
+{
+    const glm::vec3 offset = b.center - a.center;
+
+    // Least separating face axis of either box, box a's faces first
+    float face_separation = -std::numeric_limits<float>::max();
+    int face_box = 0, face_axis = 0;
+    for (int box = 0; box < 2; box++) {
+        const float best_of_a = face_separation;
+        for (int k = 0; k < 3; k++) {
+            const glm::vec3 axis = box == 0 ? a.axes[k] : b.axes[k];
+            const float separation = std::fabs(glm::dot(offset, axis)) - ProjectedRadius(a, axis) - ProjectedRadius(b, axis);
+            if (separation > PHYSICS_CONTACT_MARGIN)
+                return false;
+            if (separation > face_separation && (box == 0 || separation > best_of_a + AXIS_PREFERENCE)) {
+                face_separation = separation;
+                face_box = box;
+                face_axis = k;
+            }
+        }
+    }
+
+    float edge_separation = -std::numeric_limits<float>::max();
+    int edge_a = 0, edge_b = 0;
+    glm::vec3 edge_normal(0.0f);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            glm::vec3 axis = glm::cross(a.axes[i], b.axes[j]);
+            const float length = glm::length(axis);
+            if (length < AXIS_EPSILON)
+                continue;
+            axis /= length;
+            const float separation = std::fabs(glm::dot(offset, axis)) - ProjectedRadius(a, axis) - ProjectedRadius(b, axis);
+            if (separation > PHYSICS_CONTACT_MARGIN)
+                return false;
+            if (separation > edge_separation) {
+                edge_separation = separation;
+                edge_a = i;
+                edge_b = j;
+                edge_normal = axis;
+            }
+        }
+    }
+
+    contacts.count = 0;
+    if (edge_separation > face_separation + AXIS_PREFERENCE) {
+        // Edge against edge: closest points of the two edges facing each other
+        normal = edge_normal * Sign(glm::dot(offset, edge_normal));
+        glm::vec3 point_a = a.center, point_b = b.center;
+        for (int k = 0; k < 3; k++) {
+            if (k != edge_a)
+                point_a += a.axes[k] * (a.half[k] * Sign(glm::dot(a.axes[k], normal)));
+            if (k != edge_b)
+                point_b -= b.axes[k] * (b.half[k] * Sign(glm::dot(b.axes[k], normal)));
+        }
+        const glm::vec3 direction_a = a.axes[edge_a], direction_b = b.axes[edge_b];
+        const glm::vec3 between = point_a - point_b;
+        const float cosine = glm::dot(direction_a, direction_b);
+        const float denominator = 1.0f - cosine * cosine;
+        const float c = glm::dot(direction_a, between), f = glm::dot(direction_b, between);
+        const float s = std::clamp((cosine * f - c) / denominator, -a.half[edge_a], a.half[edge_a]);
+        const float t = std::clamp((f - cosine * c) / denominator, -b.half[edge_b], b.half[edge_b]);
+        contacts.Add((point_a + direction_a * s + point_b + direction_b * t) * 0.5f, edge_separation);
+        return true;
+    }
+
+    // Face contact: reference face of one box, incident face of the other
+    const Box& reference = face_box == 0 ? a : b;
+    const Box& incident = face_box == 0 ? b : a;
+    const glm::vec3 face_normal = reference.axes[face_axis] * Sign(glm::dot(offset, reference.axes[face_axis]));
+    normal = face_normal;
+    const glm::vec3 reference_normal = face_box == 0 ? face_normal : -face_normal; // Out of the reference box
+
+    int incident_axis = 0;
+    float alignment = -1.0f;
+    for (int k = 0; k < 3; k++) {
+        const float value = std::fabs(glm::dot(incident.axes[k], reference_normal));
+        if (value > alignment) {
+            alignment = value;
+            incident_axis = k;
+        }
+    }
+    const glm::vec3 incident_center = incident.center -
+        incident.axes[incident_axis] * (incident.half[incident_axis] * Sign(glm::dot(incident.axes[incident_axis], reference_normal)));
+    const glm::vec3 incident_u = incident.axes[(incident_axis + 1) % 3] * incident.half[(incident_axis + 1) % 3];
+    const glm::vec3 incident_v = incident.axes[(incident_axis + 2) % 3] * incident.half[(incident_axis + 2) % 3];
+    Polygon polygon;
+    polygon.Add(incident_center + incident_u + incident_v);
+    polygon.Add(incident_center - incident_u + incident_v);
+    polygon.Add(incident_center - incident_u - incident_v);
+    polygon.Add(incident_center + incident_u - incident_v);
+
+    const glm::vec3 face_center = reference.center + reference_normal * reference.half[face_axis];
+    for (int side = 1; side <= 2; side++) {
+        const int k = (face_axis + side) % 3;
+        const glm::vec3& axis = reference.axes[k];
+        ClipPolygon(polygon, axis, glm::dot(axis, face_center) + reference.half[k]);
+        ClipPolygon(polygon, -axis, -glm::dot(axis, face_center) + reference.half[k]);
+    }
+
+    for (int i = 0; i < polygon.count; i++) {
+        const glm::vec3& point = polygon.points[i];
+        const float separation = glm::dot(reference_normal, point - face_center);
+        if (separation <= PHYSICS_CONTACT_MARGIN)
+            contacts.Add(point - reference_normal * (separation * 0.5f), separation);
+    }
+    ReduceContacts(contacts, reference_normal);
+    return contacts.count > 0;
+}
+
+} // namespace
+
+bool PhysicsWorld::CollidePair(int body_a, int body_b, Manifold& manifold) const
+{
+    const RigidBody& a = bodies[body_a];
+    const RigidBody& b = bodies[body_b];
+    glm::vec3 normal;
+    ContactCandidates contacts;
+    if (!CollideBoxes(MakeBox(a), MakeBox(b), normal, contacts))
+        return false;
+
+    manifold.body_a = body_a;
+    manifold.body_b = body_b;
+    manifold.normal = normal;
+    manifold.friction = std::sqrt(a.friction * b.friction);
+    manifold.restitution = std::max(a.restitution, b.restitution);
+    manifold.point_count = contacts.count;
+    const glm::quat to_local = glm::conjugate(a.orientation);
+    for (int i = 0; i < manifold.point_count; i++) {
+        manifold.points[i].position = contacts.points[i].position;
+        manifold.points[i].separation = contacts.points[i].separation;
+        manifold.points[i].local_position = to_local * (contacts.points[i].position - a.position);
+    }
+    return true;
+}
+
+bool PhysicsWorld::CollideGround(int body_id, Manifold& manifold) const
+{
+    // The ground is a plane through the height below the center, tilted by its normal there
+    const RigidBody& body = bodies[body_id];
+    glm::vec3 ground_normal;
+    ground(body.position.x, body.position.z, ground_normal);
+
+    // The eight corners, reduced to four
+    ContactCandidates contacts;
+    const Box box = MakeBox(body);
+    for (int corner = 0; corner < 8; corner++) {
+        const glm::vec3 point = box.center + box.axes[0] * ((corner & 1) ? box.half.x : -box.half.x) +
+            box.axes[1] * ((corner & 2) ? box.half.y : -box.half.y) + box.axes[2] * ((corner & 4) ? box.half.z : -box.half.z);
+        glm::vec3 unused;
+        const float height = ground(point.x, point.z, unused);
+        const float separation = (point.y - height) * ground_normal.y;
+        if (separation <= PHYSICS_CONTACT_MARGIN)
+            contacts.Add(point - ground_normal * (separation * 0.5f), separation);
+    }
+    ReduceContacts(contacts, ground_normal);
+    if (contacts.count == 0)
+        return false;
+
+    manifold.body_a = body_id;
+    manifold.body_b = -1;
+    manifold.normal = -ground_normal;
+    manifold.friction = body.friction;
+    manifold.restitution = body.restitution;
+    manifold.point_count = contacts.count;
+    const glm::quat to_local = glm::conjugate(body.orientation);
+    for (int i = 0; i < manifold.point_count; i++) {
+        manifold.points[i].position = contacts.points[i].position;
+        manifold.points[i].separation = contacts.points[i].separation;
+        manifold.points[i].local_position = to_local * (contacts.points[i].position - body.position);
+    }
+    return true;
+}
@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "PhysicsWorld.hpp"
+
+namespace {
+
+// Two unit vectors perpendicular to normal and to each other
+void TangentBasis(const glm::vec3& normal, glm::vec3 tangent[2])
+{
+    const glm::vec3 other = std::fabs(normal.x) < 0.57735f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    tangent[0] = glm::normalize(glm::cross(normal, other));
+    tangent[1] = glm::cross(normal, tangent[0]);
+}
+
+// Inverse of the mass seen along direction at the given offsets from the centers of mass
+float EffectiveMass(const RigidBody& a, const RigidBody* b, const glm::vec3& offset_a, const glm::vec3& offset_b, const glm::vec3& direction)
+{
+    const glm::vec3 arm_a = glm::cross(offset_a, direction);
+    float inverse = a.inverse_mass + glm::dot(arm_a, a.inverse_inertia_world * arm_a);
+    if (b) {
+        const glm::vec3 arm_b = glm::cross(offset_b, direction);
+        inverse += b->inverse_mass + glm::dot(arm_b, b->inverse_inertia_world * arm_b);
+    }
+    return inverse > 0.0f ? 1.0f / inverse : 0.0f;
+}
+
+// Union-find root with path halving
+int Root(std::vector<int>& parent, int body)
+{
+    while (parent[body] != body) {
+        parent[body] = parent[parent[body]];
+        body = parent[body];
+    }
+    return body;
+}
+
+} // namespace
+
+int PhysicsWorld::AddBody(RigidBody body)
+{
+    const int id = static_cast<int>(bodies.size());
+    UpdateInertia(body);
+    glm::vec3 aabb_min, aabb_max;
+    ShapeAabb(body, aabb_min, aabb_max);
+    body.proxy = tree.CreateProxy(aabb_min, aabb_max, reinterpret_cast<void*>(static_cast<intptr_t>(id)));
+    bodies.push_back(body);
+    return id;
+}
+
+int PhysicsWorld::AddBox(const glm::vec3& position, const glm::quat& orientation, const glm::vec3& half_extents, float mass, bool awake, void* user_data)
+{
+    RigidBody body;
+    body.half_extents = half_extents;
+    body.position = position;
+    body.orientation = glm::normalize(orientation);
+    body.awake = awake && mass > 0.0f;
+    body.user_data = user_data;
+    if (mass > 0.0f) {
+        const glm::vec3 size_squared = half_extents * half_extents;
+        body.inverse_mass = 1.0f / mass;
+        body.inverse_inertia_local = 3.0f / mass / glm::vec3(size_squared.y + size_squared.z, size_squared.x + size_squared.z, size_squared.x + size_squared.y);
+    }
+    return AddBody(body);
+}
+
+void PhysicsWorld::Clear()
+{
+    bodies.clear();
+    manifolds.clear();
+    manifold_index.clear();
+    tree.Clear();
+    moved.clear();
+}
+
+void PhysicsWorld::ApplyImpulse(int id, const glm::vec3& impulse, const glm::vec3& point)
+{
+    RigidBody& body = bodies[id];
+    if (body.inverse_mass == 0.0f)
+        return;
+    Wake(id);
+    body.linear_velocity += impulse * body.inverse_mass;
+    body.angular_velocity += body.inverse_inertia_world * glm::cross(point - body.position, impulse);
+}
+
+void PhysicsWorld::Wake(int id)
+{
+    RigidBody& body = bodies[id];
+    if (body.inverse_mass == 0.0f)
+        return;
+    body.awake = true;
+    body.sleep_time = 0.0f;
+}
+
+size_t PhysicsWorld::ContactCount() const
+{
+    size_t count = 0;
+    for (const Manifold& manifold : manifolds)
+        count += manifold.point_count;
+    return count;
+}
+
+int PhysicsWorld::AwakeCount() const
+{
+    return static_cast<int>(std::count_if(bodies.begin(), bodies.end(), [](const RigidBody& body) { return body.awake; }));
+}
+
+uint64_t PhysicsWorld::PairKey(int body_a, int body_b)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(body_a)) << 32) | static_cast<uint32_t>(body_b);
+}
+
+void PhysicsWorld::UpdateInertia(RigidBody& body) const
+{
+    const glm::mat3 rotation = glm::mat3_cast(body.orientation);
+    body.inverse_inertia_world = rotation * glm::mat3(
+        body.inverse_inertia_local.x, 0.0f, 0.0f,
+        0.0f, body.inverse_inertia_local.y, 0.0f,
+        0.0f, 0.0f, body.inverse_inertia_local.z) * glm::transpose(rotation);
+}
+
+void PhysicsWorld::ShapeAabb(const RigidBody& body, glm::vec3& aabb_min, glm::vec3& aabb_max) const
+{
+    // Rotated box: sum of the absolute projections of its axes
+    const glm::mat3 rotation = glm::mat3_cast(body.orientation);
+    const glm::vec3 extent = glm::abs(rotation[0]) * body.half_extents.x + glm::abs(rotation[1]) * body.half_extents.y + glm::abs(rotation[2]) * body.half_extents.z;
+    aabb_min = body.position - extent - glm::vec3(PHYSICS_CONTACT_MARGIN);
+    aabb_max = body.position + extent + glm::vec3(PHYSICS_CONTACT_MARGIN);
+}
+
+void PhysicsWorld::Step(float delta_time)
+{
+    moved.clear();
+    if (delta_time <= 0.0f || bodies.empty())
+        return;
+
+    Collide();
+    WakeTouched();
+
+    // Gravity and damping
+    const float damping = std::max(0.0f, 1.0f - PHYSICS_DAMPING * delta_time);
+    for (RigidBody& body : bodies) {
+        if (!body.awake)
+            continue;
+        body.linear_velocity.y -= PHYSICS_GRAVITY * delta_time;
+        body.linear_velocity *= damping;
+        body.angular_velocity *= damping;
+    }
+
+    PrepareContacts(delta_time);
+    for (int iteration = 0; iteration < PHYSICS_ITERATIONS; iteration++)
+        SolveContacts();
+
+    // Positions from the solved velocities
+    for (int id = 0; id < static_cast<int>(bodies.size()); id++) {
+        RigidBody& body = bodies[id];
+        if (!body.awake)
+            continue;
+        body.position += body.linear_velocity * delta_time;
+        const glm::quat spin(0.0f, body.angular_velocity);
+        body.orientation = glm::normalize(body.orientation + spin * body.orientation * (0.5f * delta_time));
+        UpdateInertia(body);
+        glm::vec3 aabb_min, aabb_max;
+        ShapeAabb(body, aabb_min, aabb_max);
+        tree.MoveProxy(body.proxy, aabb_min, aabb_max);
+        moved.push_back(id);
+    }
+
+    UpdateSleep(delta_time);
+}
+
+void PhysicsWorld::Collide()
+{
+    std::vector<Manifold>& previous = previous_manifolds;
+    previous.swap(manifolds);
+    manifolds.clear();
+    previous_index.swap(manifold_index);
+    manifold_index.clear();
+
+    auto add = [&](Manifold& manifold) {
+        // Warm start from the closest contact of the last step, if near enough
+        auto old = previous_index.find(PairKey(manifold.body_a, manifold.body_b));
+        if (old != previous_index.end()) {
+            const Manifold& old_manifold = previous[old->second];
+            for (int i = 0; i < manifold.point_count; i++) {
+                ContactPoint& point = manifold.points[i];
+                float best = PHYSICS_MATCH_DISTANCE * PHYSICS_MATCH_DISTANCE;
+                for (int j = 0; j < old_manifold.point_count; j++) {
+                    const glm::vec3 offset = old_manifold.points[j].local_position - point.local_position;
+                    const float distance_squared = glm::dot(offset, offset);
+                    if (distance_squared < best) {
+                        best = distance_squared;
+                        point.normal_impulse = old_manifold.points[j].normal_impulse;
+                        point.tangent_impulse[0] = old_manifold.points[j].tangent_impulse[0];
+                        point.tangent_impulse[1] = old_manifold.points[j].tangent_impulse[1];
+                    }
+                }
+            }
+        }
+        // The impulses were accumulated along the old tangents, close enough while the normal persists
+        manifold_index[PairKey(manifold.body_a, manifold.body_b)] = manifolds.size();
+        manifolds.push_back(manifold);
+    };
+
+    // Pairs with an awake body; two awake bodies are paired from the lower id only
+    for (int a = 0; a < static_cast<int>(bodies.size()); a++) {
+        const RigidBody& body = bodies[a];
+        if (!body.awake)
+            continue;
+        tree.QueryAabb(tree.FatMin(body.proxy), tree.FatMax(body.proxy), [&](int proxy) {
+            const int b = static_cast<int>(reinterpret_cast<intptr_t>(tree.UserData(proxy)));
+            if (b == a || (bodies[b].awake && b < a) || (bodies[b].inverse_mass == 0.0f && body.inverse_mass == 0.0f))
+                return true;
+            Manifold manifold;
+            if (CollidePair(std::min(a, b), std::max(a, b), manifold))
+                add(manifold);
+            return true;
+        });
+        Manifold manifold;
+        if (ground && CollideGround(a, manifold))
+            add(manifold);
+    }
+
+    // Resting contacts of sleeping bodies stay as they are, they hold the island when it wakes
+    for (const Manifold& manifold : previous) {
+        const bool a_asleep = !bodies[manifold.body_a].awake;
+        const bool b_asleep = manifold.body_b < 0 || !bodies[manifold.body_b].awake;
+        if (a_asleep && b_asleep && !manifold_index.count(PairKey(manifold.body_a, manifold.body_b))) {
+            manifold_index[PairKey(manifold.body_a, manifold.body_b)] = manifolds.size();
+            manifolds.push_back(manifold);
+        }
+    }
+}
+
+void PhysicsWorld::WakeTouched()
+{
+    // Awake bodies wake whatever they touch, repeated until whole islands are awake
+    bool woke = true;
+    while (woke) {
+        woke = false;
+        for (const Manifold& manifold : manifolds) {
+            if (manifold.body_b < 0 || manifold.point_count == 0)
+                continue;
+            RigidBody& a = bodies[manifold.body_a];
+            RigidBody& b = bodies[manifold.body_b];
+            if (a.awake == b.awake)
+                continue;
+            if (!a.awake && a.inverse_mass > 0.0f) {
+                Wake(manifold.body_a);
+                woke = true;
+            }
+            if (!b.awake && b.inverse_mass > 0.0f) {
+                Wake(manifold.body_b);
+                woke = true;
+            }
+        }
+    }
+}
+
+void PhysicsWorld::PrepareContacts(float delta_time)
+{
+    for (Manifold& manifold : manifolds) {
+        RigidBody& a = bodies[manifold.body_a];
+        RigidBody* b = manifold.body_b >= 0 ? &bodies[manifold.body_b] : nullptr;
+        if (!a.awake && (!b || !b->awake))
+            continue;
+        TangentBasis(manifold.normal, manifold.tangent);
+
+        for (int i = 0; i < manifold.point_count; i++) {
+            ContactPoint& point = manifold.points[i];
+            point.offset_a = point.position - a.position;
+            point.offset_b = b ? point.position - b->position : glm::vec3(0.0f);
+            point.normal_mass = EffectiveMass(a, b, point.offset_a, point.offset_b, manifold.normal);
+            point.tangent_mass[0] = EffectiveMass(a, b, point.offset_a, point.offset_b, manifold.tangent[0]);
+            point.tangent_mass[1] = EffectiveMass(a, b, point.offset_a, point.offset_b, manifold.tangent[1]);
+
+            // Separated contacts may close the gap within the step, penetration is pushed out gradually
+            if (point.separation > 0.0f)
+                point.bias = -point.separation / delta_time;
+            else
+                point.bias = PHYSICS_BAUMGARTE / delta_time * std::max(-point.separation - PHYSICS_SLOP, 0.0f);
+
+            // Fast impacts bounce
+            glm::vec3 relative = -a.linear_velocity - glm::cross(a.angular_velocity, point.offset_a);
+            if (b)
+                relative += b->linear_velocity + glm::cross(b->angular_velocity, point.offset_b);
+            const float approach = glm::dot(relative, manifold.normal);
+            if (approach < -PHYSICS_RESTITUTION_VELOCITY)
+                point.bias = std::max(point.bias, -manifold.restitution * approach);
+        }
+    }
+
+    // Warm start, only now so that the approach speeds above are those before any impulse
+    for (Manifold& manifold : manifolds) {
+        RigidBody& a = bodies[manifold.body_a];
+        RigidBody* b = manifold.body_b >= 0 ? &bodies[manifold.body_b] : nullptr;
+        if (!a.awake && (!b || !b->awake))
+            continue;
+        for (int i = 0; i < manifold.point_count; i++) {
+            const ContactPoint& point = manifold.points[i];
+            const glm::vec3 impulse = manifold.normal * point.normal_impulse +
+                manifold.tangent[0] * point.tangent_impulse[0] + manifold.tangent[1] * point.tangent_impulse[1];
+            a.linear_velocity -= impulse * a.inverse_mass;
+            a.angular_velocity -= a.inverse_inertia_world * glm::cross(point.offset_a, impulse);
+            if (b) {
+                b->linear_velocity += impulse * b->inverse_mass;
+                b->angular_velocity += b->inverse_inertia_world * glm::cross(point.offset_b, impulse);
+            }
+        }
+    }
+}
+
+void PhysicsWorld::SolveContacts()
+{
+    for (Manifold& manifold : manifolds) {
+        RigidBody& a = bodies[manifold.body_a];
+        RigidBody* b = manifold.body_b >= 0 ? &bodies[manifold.body_b] : nullptr;
+        if (!a.awake && (!b || !b->awake))
+            continue;
+
+        for (int i = 0; i < manifold.point_count; i++) {
+            ContactPoint& point = manifold.points[i];
+            auto relative_velocity = [&]() {
+                glm::vec3 relative = -a.linear_velocity - glm::cross(a.angular_velocity, point.offset_a);
+                if (b)
+                    relative += b->linear_velocity + glm::cross(b->angular_velocity, point.offset_b);
+                return relative;
+            };
+            auto apply = [&](const glm::vec3& impulse) {
+                a.linear_velocity -= impulse * a.inverse_mass;
+                a.angular_velocity -= a.inverse_inertia_world * glm::cross(point.offset_a, impulse);
+                if (b) {
+                    b->linear_velocity += impulse * b->inverse_mass;
+                    b->angular_velocity += b->inverse_inertia_world * glm::cross(point.offset_b, impulse);
+                }
+            };
+
+            // Friction first, within the cone of the current normal impulse
+            const float friction_limit = manifold.friction * point.normal_impulse;
+            for (int k = 0; k < 2; k++) {
+                const float lambda = -point.tangent_mass[k] * glm::dot(relative_velocity(), manifold.tangent[k]);
+                const float accumulated = std::clamp(point.tangent_impulse[k] + lambda, -friction_limit, friction_limit);
+                apply(manifold.tangent[k] * (accumulated - point.tangent_impulse[k]));
+                point.tangent_impulse[k] = accumulated;
+            }
+
+            // Non-penetration, the accumulated impulse only pushes
+            const float lambda = point.normal_mass * (point.bias - glm::dot(relative_velocity(), manifold.normal));
+            const float accumulated = std::max(point.normal_impulse + lambda, 0.0f);
+            apply(manifold.normal * (accumulated - point.normal_impulse));
+            point.normal_impulse = accumulated;
+        }
+    }
+}
+
+void PhysicsWorld::UpdateSleep(float delta_time)
+{
+    // Islands: awake bodies joined by touching contacts, the ground does not join
+    std::vector<int>& parent = island_parent;
+    parent.resize(bodies.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    for (const Manifold& manifold : manifolds) {
+        if (manifold.body_b < 0 || manifold.point_count == 0)
+            continue;
+        if (!bodies[manifold.body_a].awake || !bodies[manifold.body_b].awake)
+            continue;
+        parent[Root(parent, manifold.body_a)] = Root(parent, manifold.body_b);
+    }
+
+    // Shortest rest of each island
+    island_rest.assign(bodies.size(), PHYSICS_SLEEP_TIME);
+    for (int id = 0; id < static_cast<int>(bodies.size()); id++) {
+        RigidBody& body = bodies[id];
+        if (!body.awake)
+            continue;
+        const bool resting = glm::dot(body.linear_velocity, body.linear_velocity) < PHYSICS_SLEEP_LINEAR * PHYSICS_SLEEP_LINEAR &&
+            glm::dot(body.angular_velocity, body.angular_velocity) < PHYSICS_SLEEP_ANGULAR * PHYSICS_SLEEP_ANGULAR;
+        body.sleep_time = resting ? body.sleep_time + delta_time : 0.0f;
+        float& rest = island_rest[Root(parent, id)];
+        rest = std::min(rest, body.sleep_time);
+    }
+
+    for (int id = 0; id < static_cast<int>(bodies.size()); id++) {
+        RigidBody& body = bodies[id];
+        if (body.awake && island_rest[Root(parent, id)] >= PHYSICS_SLEEP_TIME) {
+            body.awake = false;
+            body.linear_velocity = glm::vec3(0.0f);
+            body.angular_velocity = glm::vec3(0.0f);
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "DynamicAabbTree.hpp"
+
+constexpr float PHYSICS_GRAVITY = 9.81f; // Downwards acceleration, world units per second squared
+constexpr int PHYSICS_ITERATIONS = 20; // Velocity solver iterations per step, fewer let tall stacks creep
+constexpr float PHYSICS_BAUMGARTE = 0.2f; // Fraction of the penetration removed per step
+constexpr float PHYSICS_SLOP = 0.005f; // Penetration left alone, keeps resting contacts from jittering
+constexpr float PHYSICS_CONTACT_MARGIN = 0.02f; // Contacts are kept up to this separation, so they persist while resting
+constexpr float PHYSICS_MATCH_DISTANCE = 0.05f; // Contacts closer than this to one of the last step keep its impulses (warm starting)
+constexpr float PHYSICS_RESTITUTION_VELOCITY = 1.0f; // Slower impacts do not bounce
+constexpr float PHYSICS_DAMPING = 0.05f; // Linear and angular velocity lost per second
+constexpr float PHYSICS_SLEEP_LINEAR = 0.05f; // Bodies slower than this, in units per second ...
+constexpr float PHYSICS_SLEEP_ANGULAR = 0.05f; // ... and radians per second, are resting
+constexpr float PHYSICS_SLEEP_TIME = 0.5f; // Seconds all bodies of an island must rest before it sleeps
+
+struct RigidBody {
+    glm::vec3 half_extents{ 0.5f };
+
+    glm::vec3 position{ 0.0f }; // Center of mass, the center of the box
+    glm::quat orientation{ 1.0f, 0.0f, 0.0f, 0.0f };
+    glm::vec3 linear_velocity{ 0.0f };
+    glm::vec3 angular_velocity{ 0.0f };
+
+    float inverse_mass = 0.0f; // 0 for static bodies
+    glm::vec3 inverse_inertia_local{ 0.0f }; // Diagonal along the box axes
+    glm::mat3 inverse_inertia_world{ 0.0f };
+    float friction = 0.5f;
+    float restitution = 0.1f;
+
+    bool awake = true;
+    float sleep_time = 0.0f; // Seconds at rest
+    int proxy = -1; // Leaf in the broadphase tree
+    void* user_data = nullptr;
+};
+
+// Rigid boxes on a height field ground, solved with sequential impulses
+//
+// Every step finds the touching pairs of awake bodies in a DynamicAabbTree and builds contact
+// manifolds: separating axis test and face clipping between boxes, the box corners against the
+// ground. Contacts that match one of the last step start with its
+// impulses (warm starting), so stacks settle within few iterations. Bodies in contact form
+// islands; an island whose bodies have all rested for PHYSICS_SLEEP_TIME falls asleep and is
+// neither moved nor solved until something awake touches it or an impulse is applied.
+// See PhysicsContacts.cpp for the contact generation.
+class PhysicsWorld
+{
+public:
+    // Height of the ground at (x, z) and its normal, the ground is below the returned height
+    using Ground = std::function<float(float x, float z, glm::vec3& normal)>;
+
+    // mass 0 makes a static body; awake false starts the body asleep until something touches it
+    int AddBox(const glm::vec3& position, const glm::quat& orientation, const glm::vec3& half_extents, float mass, bool awake = true, void* user_data = nullptr);
+    void Clear();
+    void SetGround(Ground ground) { this->ground = std::move(ground); }
+
+    const RigidBody& Body(int id) const { return bodies[id]; }
+    size_t BodyCount() const { return bodies.size(); }
+    void ApplyImpulse(int id, const glm::vec3& impulse, const glm::vec3& point); // At a world point, wakes the body
+    void Wake(int id);
+
+    void Step(float delta_time);
+    const std::vector<int>& MovedBodies() const { return moved; } // Bodies the last step moved
+
+    size_t ContactCount() const; // Contact points of the last step
+    int AwakeCount() const;
+
+private:
+    struct ContactPoint {
+        glm::vec3 position{ 0.0f }; // World, between the two surfaces
+        float separation = 0.0f; // Negative when penetrating
+        glm::vec3 local_position{ 0.0f }; // In body a's frame, for matching the next step's contacts
+
+        glm::vec3 offset_a{ 0.0f }, offset_b{ 0.0f }; // From the centers of mass
+        float normal_mass = 0.0f;
+        float tangent_mass[2]{};
+        float bias = 0.0f; // Target normal velocity
+        float normal_impulse = 0.0f; // Accumulated over the iterations and, warm started, the steps
+        float tangent_impulse[2]{};
+    };
+
+    struct Manifold {
+        int body_a = -1;
+        int body_b = -1; // -1 for the ground
+        glm::vec3 normal{ 0.0f, 1.0f, 0.0f }; // From a towards b
+        glm::vec3 tangent[2]{};
+        float friction = 0.0f;
+        float restitution = 0.0f;
+        int point_count = 0;
+        ContactPoint points[4];
+    };
+
+    std::vector<RigidBody> bodies;
+    std::vector<Manifold> manifolds;
+    std::unordered_map<uint64_t, size_t> manifold_index; // Pair key to the manifolds of the last step
+    // Scratch of Collide() and UpdateSleep(), kept so that steps reuse their memory
+    std::vector<Manifold> previous_manifolds;
+    std::unordered_map<uint64_t, size_t> previous_index;
+    std::vector<int> island_parent;
+    std::vector<float> island_rest;
+    DynamicAabbTree tree;
+    Ground ground;
+    std::vector<int> moved;
+
+    int AddBody(RigidBody body);
+    static uint64_t PairKey(int body_a, int body_b);
+    void UpdateInertia(RigidBody& body) const;
+    void ShapeAabb(const RigidBody& body, glm::vec3& aabb_min, glm::vec3& aabb_max) const;
+
+    void Collide(); // Manifolds of the touching pairs, warm started from the last step
+    bool CollidePair(int body_a, int body_b, Manifold& manifold) const; // PhysicsContacts.cpp
+    bool CollideGround(int body, Manifold& manifold) const; // PhysicsContacts.cpp
+    void WakeTouched();
+    void PrepareContacts(float delta_time);
+    void SolveContacts();
+    void UpdateSleep(float delta_time);
+};
@@ -19,6 +19,19 @@ ShaderProgram::ShaderProgram(const std::filesystem::path& VS_file, const std::fi
     std::cout << "Instantiated shader ID=" << ID << std::endl; // Output shader ID
 }
 
+// Constructor for a program with tessellation control and evaluation shaders
+ShaderProgram::ShaderProgram(const std::filesystem::path& VS_file, const std::filesystem::path& TCS_file, const std::filesystem::path& TES_file, const std::filesystem::path& FS_file) {
+    std::vector<GLuint> shader_ids;
+
+    shader_ids.push_back(CompileShader(VS_file, GL_VERTEX_SHADER));
+    shader_ids.push_back(CompileShader(TCS_file, GL_TESS_CONTROL_SHADER));
+    shader_ids.push_back(CompileShader(TES_file, GL_TESS_EVALUATION_SHADER));
+    shader_ids.push_back(CompileShader(FS_file, GL_FRAGMENT_SHADER));
+
+    ID = LinkShader(shader_ids);
+    std::cout << "Instantiated shader ID=" << ID << std::endl;
+}
+
 // Activate the shader program for rendering
 void ShaderProgram::Activate() {
     std::cout << "Activating shader ID=" << ID << std::endl;
@@ -55,6 +68,15 @@ void ShaderProgram::SetUniform(const std::string& name, int val) {
     glUniform1i(loc, val);
 }
 
+// Set a uniform value in the shader program (glm::vec2 version)
+void ShaderProgram::SetUniform(const std::string& name, const glm::vec2 val) {
+    auto loc = glGetUniformLocation(ID, name.c_str());
+    if (loc == -1) {
+        throw std::runtime_error("no uniform with name: '" + name + "' (ID=" + std::to_string(ID) + ")\n");
+    }
+    glUniform2fv(loc, 1, glm::value_ptr(val));
+}
+
 // Set a uniform value in the shader program (glm::vec3 version)
 void ShaderProgram::SetUniform(const std::string& name, const glm::vec3 val) {
     auto loc = glGetUniformLocation(ID, name.c_str());
@@ -102,6 +124,33 @@ std::string ShaderProgram::TextFileRead(const std::filesystem::path& fn) {
     return ss.str();
 }
 
+// Read a shader source, replacing #include "file" lines with the contents of file (relative to the including shader)
+std::string ShaderProgram::LoadShaderSource(const std::filesystem::path& source_file, int depth) {
+    if (depth > 16) {
+        throw std::runtime_error("Shader includes nested too deeply: " + source_file.string() + "\n");
+    }
+    std::istringstream lines(TextFileRead(source_file));
+    std::string source, line;
+    while (std::getline(lines, line)) {
+        auto first = line.find_first_not_of(" \t");
+        if (first != std::string::npos && line.compare(first, 8, "#include") == 0) {
+            auto open = line.find('"', first), close = line.rfind('"');
+            if (open == std::string::npos || close <= open) {
+                throw std::runtime_error("Invalid #include in " + source_file.string() + ": " + line + "\n");
+            }
+            auto include_file = source_file.parent_path() / line.substr(open + 1, close - open - 1);
+            if (!std::filesystem::exists(include_file)) {
+                throw std::runtime_error("File not found: " + include_file.string() + "\n");
+            }
+            source += LoadShaderSource(include_file, depth + 1);
+            continue;
+        }
+        source += line;
+        source += '\n';
+    }
+    return source;
+}
+
 // Get the information log for a shader
 std::string ShaderProgram::GetShaderInfoLog(GLuint obj) {
     int infologLength = 0;
@@ -136,7 +185,7 @@ GLuint ShaderProgram::CompileShader(const std::filesystem::path& source_file, GL
 
     GLuint shader_h = glCreateShader(type);
 
-    std::string shader_string = TextFileRead(source_file);
+    std::string shader_string = LoadShaderSource(source_file);
     const char* shader_c_str = shader_string.c_str();
 
     glShaderSource(shader_h, 1, &shader_c_str, NULL);
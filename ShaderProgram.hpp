@@ -10,6 +10,7 @@ public:
 	// you can add more constructors for pipeline with GS, TS etc.
 	ShaderProgram(void) = default; // does nothing
 	ShaderProgram(const std::filesystem::path& VS_file, const std::filesystem::path& FS_file); // load, compile, and link shader
+	ShaderProgram(const std::filesystem::path& VS_file, const std::filesystem::path& TCS_file, const std::filesystem::path& TES_file, const std::filesystem::path& FS_file); // same, with tessellation
 
 	void Activate();
 	void Deactivate();
@@ -19,6 +20,7 @@ public:
 	// https://docs.gl/gl4/glUniform
 	void SetUniform(const std::string& name, const float val);
 	void SetUniform(const std::string& name, const int val);
+	void SetUniform(const std::string& name, const glm::vec2 val);
 	void SetUniform(const std::string& name, const glm::vec3 val);
 	void SetUniform(const std::string& name, const glm::vec4 val);
 	void SetUniform(const std::string& name, const glm::mat3 val);
@@ -32,4 +34,5 @@ private:
 	GLuint CompileShader(const std::filesystem::path& source_file, const GLenum type); // try to load and compile shader
 	GLuint LinkShader(const std::vector<GLuint> shader_ids);                           // try to link all shader IDs to final program
 	std::string TextFileRead(const std::filesystem::path& filename);                   // load text file
+	std::string LoadShaderSource(const std::filesystem::path& source_file, int depth = 0); // load shader, expanding #include "file" relative to it
 };
@@ -1,4 +1,5 @@
-﻿#include <iostream>
+﻿#include <algorithm>
+#include <iostream>
 #include <string>
 #include "App.hpp"
 
@@ -9,6 +10,8 @@ void App::Shoot()
 	auto name = "obj_projectile_" + std::to_string(number_of_projectiles);
 	// Set projectile position to camera position
 	opaque_scene.find(name)->second->position = camera.position;
+	// Appears at the camera, not on the way there from where it was hidden
+	opaque_scene.find(name)->second->SaveState();
 	// Set projectile direction
 	projectile_directions[number_of_projectiles] = camera.front;
 	// Set projectile state to moving
@@ -17,28 +20,71 @@ void App::Shoot()
 	number_of_projectiles = (number_of_projectiles + 1) % PROJECTILES_COUNT;
 }
 
-// Function to check collision with objects in the scene
-bool App::CheckCollision(const glm::vec3& position)
+// Function to check collision of a moving sphere with objects in the scene
+bool App::CheckCollision(const glm::vec3& from, const glm::vec3& to, float radius, SweepHit& hit)
 {
-	// Iterate through each model in collisions vector
-	for (const auto model : collisions) {
-		// Check if collision occurs with the model
-		if (model->CheckCollisionWithPoint(position)) {
-			// Get the name of the collided model
-			const auto& hit_name = model->name;
-			// If the collided model is a sphere
-			if (hit_name.substr(0, 10) == "obj_sphere") {
-				// Move the cube downwards to hide it
-				model->position.y -= SPHERE_HIDE_DISTANCE;
-				// Play glass breaking sound
-				audio.PlayShot("sound_glass");
-			}
-			// Return true indicating collision occurred
-			return true;
-		}
-	}
+	// Only the models registered in the grid cells around the swept sphere can be touched, counting the sweep's contact tolerance
+	const glm::vec3 reach(radius + SWEEP_TOLERANCE);
+	const glm::vec3 sweep_min = glm::min(from, to) - reach, sweep_max = glm::max(from, to) + reach;
+	collision_grid.QueryAabb(sweep_min, sweep_max, collision_candidates);
+	// Of those, the SIMD test keeps the ones whose bounds reach into the box of the sweep
+	collision_candidates.resize(collision_shapes.Overlapping(sweep_min, sweep_max, collision_candidates.data(), collision_candidates.size()));
+	// The time, contact point and normal of the hit come from their fitted shapes
+	const int id = FirstSwept(SphereShape{ from, radius }, to - from, collision_exact_shapes.data(), collision_candidates.data(), collision_candidates.size(), hit);
 	// Return false indicating no collision occurred
-	return false;
+	if (id < 0)
+		return false;
+
+	const auto model = collisions[id];
+	// Get the name of the collided model
+	const auto& hit_name = model->name;
+	// If the collided model is a sphere
+	if (hit_name.substr(0, 10) == "obj_sphere") {
+		// Move the cube downwards to hide it
+		model->position.y -= SPHERE_HIDE_DISTANCE;
+		UpdateCollisionBounds(id);
+		// Play glass breaking sound
+		audio.PlayShot("sound_glass");
+	}
+	// A rigid body takes over the projectile's momentum at the contact
+	const glm::vec3 motion = to - from;
+	if (collision_bodies[id] >= 0 && glm::dot(motion, motion) > 0.0f)
+		physics.ApplyImpulse(collision_bodies[id], PROJECTILE_MASS * projectile_speed * glm::normalize(motion), hit.position);
+	// Return true indicating collision occurred
+	return true;
+}
+
+// Function to move a collision object to the grid cells and shape of its current bounds
+void App::UpdateCollisionBounds(int id)
+{
+	const auto model = collisions[id];
+	// collision_exact_shapes keeps the fitted world shape the sweeps test, the grid the box around it
+	if (!model->GetCollisionShape(collision_exact_shapes[id])) {
+		// Not loaded, in no grid cell
+		collision_grid.Remove(id);
+		collision_shapes.SetEmpty(id);
+		return;
+	}
+	glm::vec3 aabb_min, aabb_max;
+	Bounds(collision_exact_shapes[id], aabb_min, aabb_max);
+	// Spheres are filtered by themselves, everything else by its box
+	if (const auto sphere = std::get_if<SphereShape>(&collision_exact_shapes[id]))
+		collision_shapes.SetSphere(id, sphere->center, sphere->radius);
+	else
+		collision_shapes.SetAabb(id, aabb_min, aabb_max);
+	collision_grid.Update(id, aabb_min, aabb_max);
+}
+
+// Function to register the collision objects whose meshes finished loading
+void App::UpdatePendingCollisionBounds()
+{
+	auto loaded = std::remove_if(collisions_without_bounds.begin(), collisions_without_bounds.end(), [this](int id) {
+		if (!collisions[id]->IsReady())
+			return false;
+		UpdateCollisionBounds(id);
+		return true;
+	});
+	collisions_without_bounds.erase(loaded, collisions_without_bounds.end());
 }
 
 // Function to update projectile positions and check for collisions
@@ -58,8 +104,13 @@ void App::UpdateProjectiles(float delta_time)
 			// Update projectile position based on speed and direction
 			projectile->position += projectile_speed * delta_time * projectile_directions[i];
 
-			// Check for collision with updated position
-			bool hit = CheckCollision(position);
+			// Check the whole step, so that fast projectiles cannot pass through anything; objects behind the terrain do not count
+			TerrainHit terrain_hit;
+			bool hit = terrain.Segment(position, projectile->position, terrain_hit);
+			const glm::vec3 step_end = hit ? terrain_hit.position : projectile->position;
+			const MeshBounds bounds = projectile->GetCollisionBounds();
+			SweepHit object_hit;
+			hit = CheckCollision(position + bounds.sphere_center, step_end + bounds.sphere_center, bounds.sphere_radius, object_hit) || hit;
 
 			// If collision occurred
 			if (hit) {
@@ -72,4 +123,37 @@ void App::UpdateProjectiles(float delta_time)
 	}
 }
 
+// Function to turn the loaded pyramid boxes into rigid bodies and advance the simulation
+void App::UpdatePhysics(float delta_time)
+{
+	// Bodies start where the models stand, on a terrain whose heights are known
+	if (terrain.IsReady()) {
+		auto created = std::remove_if(bodies_pending.begin(), bodies_pending.end(), [this](int id) {
+			const auto model = collisions[id];
+			if (!model->IsReady())
+				return false;
+			const MeshBounds bounds = model->GetCollisionBounds();
+			// The body starts turned like the model, the pose written back below keeps the rotation
+			const glm::vec3 axis(model->rotation);
+			const glm::quat orientation = glm::dot(axis, axis) > 0.0f ? glm::angleAxis(glm::radians(model->rotation.w), glm::normalize(axis)) : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			const glm::vec3 center = model->position + orientation * ((bounds.aabb_min + bounds.aabb_max) * 0.5f);
+			collision_bodies[id] = physics.AddBox(center, orientation, (bounds.aabb_max - bounds.aabb_min) * 0.5f, BOX_MASS);
+			body_collisions.push_back(id);
+			return true;
+		});
+		bodies_pending.erase(created, bodies_pending.end());
+	}
+
+	physics.Step(delta_time);
 
+	// The body sits at the center of the mesh box, the model origin is where the mesh has its own
+	for (int body_id : physics.MovedBodies()) {
+		const RigidBody& body = physics.Body(body_id);
+		const int id = body_collisions[body_id];
+		const auto model = collisions[id];
+		const MeshBounds bounds = model->GetCollisionBounds();
+		model->position = body.position - body.orientation * ((bounds.aabb_min + bounds.aabb_max) * 0.5f);
+		model->rotation = glm::vec4(glm::axis(body.orientation), glm::degrees(glm::angle(body.orientation)));
+		UpdateCollisionBounds(id);
+	}
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+
+#include "SpatialHashGrid.hpp"
+
+SpatialHashGrid::SpatialHashGrid(float cell_size) :
+    cell_size(cell_size),
+    inverse_cell_size(1.0f / cell_size)
+{
+}
+
+glm::ivec3 SpatialHashGrid::CellOf(const glm::vec3& point) const
+{
+    return glm::ivec3(glm::floor(point * inverse_cell_size));
+}
+
+uint64_t SpatialHashGrid::CellKey(const glm::ivec3& cell)
+{
+    constexpr uint64_t mask = (1u << 21) - 1;
+    return ((static_cast<uint64_t>(cell.x) & mask) << 42) | ((static_cast<uint64_t>(cell.y) & mask) << 21) | (static_cast<uint64_t>(cell.z) & mask);
+}
+
+void SpatialHashGrid::AddToCells(int id)
+{
+    Entry& entry = entries[id];
+    entry.in_cells = true;
+    for (int z = entry.cell_min.z; z <= entry.cell_max.z; z++)
+        for (int y = entry.cell_min.y; y <= entry.cell_max.y; y++)
+            for (int x = entry.cell_min.x; x <= entry.cell_max.x; x++)
+                cells[CellKey(glm::ivec3(x, y, z))].push_back(id);
+}
+
+void SpatialHashGrid::RemoveFromCells(int id)
+{
+    Entry& entry = entries[id];
+    if (!entry.in_cells)
+        return;
+    entry.in_cells = false;
+    for (int z = entry.cell_min.z; z <= entry.cell_max.z; z++) {
+        for (int y = entry.cell_min.y; y <= entry.cell_max.y; y++) {
+            for (int x = entry.cell_min.x; x <= entry.cell_max.x; x++) {
+                auto cell = cells.find(CellKey(glm::ivec3(x, y, z)));
+                if (cell == cells.end())
+                    continue;
+                // Order within a cell does not matter
+                auto& ids = cell->second;
+                auto position = std::find(ids.begin(), ids.end(), id);
+                if (position != ids.end()) {
+                    *position = ids.back();
+                    ids.pop_back();
+                }
+                if (ids.empty())
+                    cells.erase(cell);
+            }
+        }
+    }
+}
+
+int SpatialHashGrid::Insert(const glm::vec3& aabb_min, const glm::vec3& aabb_max)
+{
+    const int id = static_cast<int>(entries.size());
+    entries.push_back({ CellOf(aabb_min), CellOf(aabb_max) });
+    AddToCells(id);
+    return id;
+}
+
+int SpatialHashGrid::Insert()
+{
+    entries.push_back({ glm::ivec3(0), glm::ivec3(0) });
+    return static_cast<int>(entries.size()) - 1;
+}
+
+void SpatialHashGrid::Update(int id, const glm::vec3& aabb_min, const glm::vec3& aabb_max)
+{
+    const glm::ivec3 cell_min = CellOf(aabb_min), cell_max = CellOf(aabb_max);
+    Entry& entry = entries[id];
+    if (entry.in_cells && cell_min == entry.cell_min && cell_max == entry.cell_max)
+        return;
+
+    RemoveFromCells(id);
+    entry.cell_min = cell_min;
+    entry.cell_max = cell_max;
+    AddToCells(id);
+}
+
+void SpatialHashGrid::Remove(int id)
+{
+    RemoveFromCells(id);
+}
+
+void SpatialHashGrid::Clear()
+{
+    entries.clear();
+    cells.clear();
+}
+
+void SpatialHashGrid::QueryAabb(const glm::vec3& aabb_min, const glm::vec3& aabb_max, std::vector<int>& candidates)
+{
+    candidates.clear();
+    stats.queries++;
+    query_stamp++;
+
+    const glm::ivec3 cell_min = CellOf(aabb_min), cell_max = CellOf(aabb_max);
+    for (int z = cell_min.z; z <= cell_max.z; z++)
+        for (int y = cell_min.y; y <= cell_max.y; y++)
+            for (int x = cell_min.x; x <= cell_max.x; x++)
+                CollectCell(glm::ivec3(x, y, z), candidates);
+    stats.candidates += candidates.size();
+}
+
+void SpatialHashGrid::CollectCell(const glm::ivec3& cell, std::vector<int>& candidates)
+{
+    stats.cells_visited++;
+    auto found = cells.find(CellKey(cell));
+    if (found == cells.end())
+        return;
+    for (int id : found->second) {
+        if (entries[id].query_stamp != query_stamp) {
+            entries[id].query_stamp = query_stamp;
+            candidates.push_back(id);
+        }
+    }
+}
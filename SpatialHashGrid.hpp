@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Query counters of a SpatialHashGrid, for tuning the cell size
+struct SpatialHashStats {
+    size_t queries = 0;
+    size_t cells_visited = 0;
+    size_t candidates = 0; // Entries returned, before any exact test
+};
+
+// Uniform grid of cubic cells stored in a hash map, broadphase for box queries
+//
+// Entries are registered with a world space box and listed in every cell the box touches; only
+// cells holding entries are stored, so the world is unbounded. Update() moves an entry only when
+// its box covers different cells. Queries return entry ids whose cells the box touches, the
+// caller runs the exact tests. Entry ids are indices in insertion order. A removed entry is in no
+// cell and keeps its id, the next Update() places it again.
+class SpatialHashGrid
+{
+public:
+    explicit SpatialHashGrid(float cell_size);
+
+    int Insert(const glm::vec3& aabb_min, const glm::vec3& aabb_max); // Returns the new entry's id
+    int Insert(); // New entry in no cell, placed by its first Update()
+    void Update(int id, const glm::vec3& aabb_min, const glm::vec3& aabb_max);
+    void Remove(int id); // Takes the entry out of its cells until the next Update()
+    void Clear();
+
+    // Replace candidates with the entries of every cell the box touches, each once
+    void QueryAabb(const glm::vec3& aabb_min, const glm::vec3& aabb_max, std::vector<int>& candidates);
+
+    float CellSize() const { return cell_size; }
+    size_t EntryCount() const { return entries.size(); }
+    size_t CellCount() const { return cells.size(); }
+    const SpatialHashStats& Stats() const { return stats; }
+    void ResetStats() { stats = SpatialHashStats(); }
+
+private:
+    struct Entry {
+        glm::ivec3 cell_min, cell_max; // Covered cells, inclusive
+        bool in_cells = false; // False for removed entries, cell_min and cell_max are stale then
+        uint32_t query_stamp = 0; // Last query that returned the entry
+    };
+
+    float cell_size;
+    float inverse_cell_size;
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, std::vector<int>> cells; // Entries per non-empty cell
+    uint32_t query_stamp = 0;
+    SpatialHashStats stats;
+
+    glm::ivec3 CellOf(const glm::vec3& point) const;
+    static uint64_t CellKey(const glm::ivec3& cell); // 21 bits per axis, wraps around beyond +-2^20 cells
+    void AddToCells(int id);
+    void RemoveFromCells(int id);
+    void CollectCell(const glm::ivec3& cell, std::vector<int>& candidates); // Appends the cell's entries not yet returned by this query
+};
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "SweptCollision.hpp"
+
+namespace {
+
+constexpr float NO_HIT = std::numeric_limits<float>::max();
+
+// Smallest t >= 0 with |origin + t * direction - center| = radius, NO_HIT if none; origin outside the sphere
+float RaySphere(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& center, float radius)
+{
+    const glm::vec3 offset = origin - center;
+    const float a = glm::dot(direction, direction);
+    const float b = glm::dot(offset, direction);
+    const float c = glm::dot(offset, offset) - radius * radius;
+    if (a == 0.0f || b >= 0.0f)
+        return NO_HIT;
+    const float discriminant = b * b - a * c;
+    if (discriminant < 0.0f)
+        return NO_HIT;
+    return std::max((-b - std::sqrt(discriminant)) / a, 0.0f);
+}
+
+// Same for the capsule of radius around segment [a, b]
+float RayCapsule(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, float radius)
+{
+    // Side of the capsule: infinite cylinder, accepted between the end caps
+    const glm::vec3 axis = b - a, offset = origin - a;
+    const float axis_axis = glm::dot(axis, axis), axis_direction = glm::dot(axis, direction), axis_offset = glm::dot(axis, offset);
+    const float qa = axis_axis * glm::dot(direction, direction) - axis_direction * axis_direction;
+    const float qb = axis_axis * glm::dot(offset, direction) - axis_offset * axis_direction;
+    const float qc = axis_axis * glm::dot(offset, offset) - axis_offset * axis_offset - radius * radius * axis_axis;
+    float t = NO_HIT;
+    const float discriminant = qb * qb - qa * qc;
+    if (qa > 0.0f && qb < 0.0f && discriminant >= 0.0f) {
+        const float t_side = std::max((-qb - std::sqrt(discriminant)) / qa, 0.0f);
+        const float along = axis_offset + t_side * axis_direction;
+        if (along >= 0.0f && along <= axis_axis)
+            t = t_side;
+    }
+    // End caps
+    return std::min({ t, RaySphere(origin, direction, a, radius), RaySphere(origin, direction, b, radius) });
+}
+
+// Box corner n: bit i of n selects the maximum on axis i
+glm::vec3 Corner(const glm::vec3& aabb_min, const glm::vec3& aabb_max, int n)
+{
+    return glm::vec3((n & 1) ? aabb_max.x : aabb_min.x, (n & 2) ? aabb_max.y : aabb_min.y, (n & 4) ? aabb_max.z : aabb_min.z);
+}
+
+} // namespace
+
+bool SweepSphereSphere(const glm::vec3& center, float radius, const glm::vec3& motion,
+    const glm::vec3& other_center, float other_radius, SweepHit& hit)
+{
+    // The other sphere grown by radius against the path of the center
+    const float combined_radius = radius + other_radius;
+    const glm::vec3 offset = center - other_center;
+    float time;
+    if (glm::dot(offset, offset) <= combined_radius * combined_radius)
+        time = 0.0f;
+    else if ((time = RaySphere(center, motion, other_center, combined_radius)) > 1.0f)
+        return false;
+
+    const glm::vec3 contact_center = center + motion * time;
+    const glm::vec3 away = contact_center - other_center;
+    const float distance = glm::length(away);
+    hit.time = time;
+    // Concentric at the start, against the motion then
+    hit.normal = distance > 0.0f ? away / distance : glm::dot(motion, motion) > 0.0f ? -glm::normalize(motion) : glm::vec3(0.0f, 1.0f, 0.0f);
+    hit.position = other_center + hit.normal * other_radius;
+    return true;
+}
+
+bool SweepSphereAabb(const glm::vec3& center, float radius, const glm::vec3& motion,
+    const glm::vec3& aabb_min, const glm::vec3& aabb_max, SweepHit& hit)
+{
+    float time = NO_HIT;
+    const glm::vec3 closest = glm::clamp(center, aabb_min, aabb_max);
+    if (glm::dot(center - closest, center - closest) <= radius * radius) {
+        time = 0.0f;
+    }
+    else {
+        // Segment against the box grown by radius
+        const glm::vec3 grown_min = aabb_min - glm::vec3(radius), grown_max = aabb_max + glm::vec3(radius);
+        float t_begin = 0.0f, t_end = 1.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            if (motion[axis] == 0.0f) {
+                if (center[axis] < grown_min[axis] || center[axis] > grown_max[axis])
+                    return false;
+                continue;
+            }
+            const float t0 = (grown_min[axis] - center[axis]) / motion[axis];
+            const float t1 = (grown_max[axis] - center[axis]) / motion[axis];
+            t_begin = std::max(t_begin, std::min(t0, t1));
+            t_end = std::min(t_end, std::max(t0, t1));
+        }
+        if (t_begin > t_end)
+            return false;
+
+        // Axes on which the entry point lies below (below_mask) or above (above_mask) the box
+        const glm::vec3 entry = center + motion * t_begin;
+        int below_mask = 0, above_mask = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            if (entry[axis] < aabb_min[axis])
+                below_mask |= 1 << axis;
+            if (entry[axis] > aabb_max[axis])
+                above_mask |= 1 << axis;
+        }
+        const int outside_mask = below_mask | above_mask;
+
+        if ((outside_mask & (outside_mask - 1)) == 0) {
+            // Face region, the grown box is exact there
+            time = t_begin;
+        }
+        else if (outside_mask == 7) {
+            // Corner region, first contact with one of the three edges meeting at the corner
+            const glm::vec3 corner = Corner(aabb_min, aabb_max, above_mask);
+            for (int axis = 0; axis < 3; axis++)
+                time = std::min(time, RayCapsule(center, motion, corner, Corner(aabb_min, aabb_max, above_mask ^ (1 << axis)), radius));
+        }
+        else {
+            // Edge region, along the axis the entry point lies within
+            time = RayCapsule(center, motion, Corner(aabb_min, aabb_max, below_mask ^ 7), Corner(aabb_min, aabb_max, above_mask), radius);
+        }
+        if (time > 1.0f)
+            return false;
+    }
+
+    // The closest box point to the center at contact, a center inside the box leaves by the nearest face
+    const glm::vec3 contact_center = center + motion * time;
+    hit.time = time;
+    hit.position = glm::clamp(contact_center, aabb_min, aabb_max);
+    const glm::vec3 away = contact_center - hit.position;
+    const float distance = glm::length(away);
+    if (distance > 0.0f) {
+        hit.normal = away / distance;
+        return true;
+    }
+    float nearest = NO_HIT;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            const float depth = side ? aabb_max[axis] - contact_center[axis] : contact_center[axis] - aabb_min[axis];
+            if (depth < nearest) {
+                nearest = depth;
+                hit.normal = glm::vec3(0.0f);
+                hit.normal[axis] = side ? 1.0f : -1.0f;
+            }
+        }
+    }
+    return true;
+}
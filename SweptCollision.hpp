@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// First contact of a moving sphere
+struct SweepHit {
+    float time = 1.0f; // Fraction of the motion until contact, 0 when touching at the start
+    glm::vec3 position{ 0.0f }; // Contact point on the obstacle
+    glm::vec3 normal{ 0.0f, 1.0f, 0.0f }; // Obstacle surface normal at the contact, towards the moving sphere
+};
+
+// Continuous collision tests of a sphere moving from center to center + motion
+//
+// Both return false when the sphere does not touch the obstacle during the motion. A sphere
+// touching or overlapping the obstacle at the start hits at time 0. The box test follows
+// Ericson, Real-Time Collision Detection 5.5.7: the segment of the sphere center is clipped
+// against the box grown by the radius, contacts in the rounded edge and corner regions are
+// then resolved against the capsules around the box edges.
+bool SweepSphereSphere(const glm::vec3& center, float radius, const glm::vec3& motion,
+    const glm::vec3& other_center, float other_radius, SweepHit& hit);
+bool SweepSphereAabb(const glm::vec3& center, float radius, const glm::vec3& motion,
+    const glm::vec3& aabb_min, const glm::vec3& aabb_max, SweepHit& hit);
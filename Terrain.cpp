@@ -0,0 +1,425 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+#include <glm/ext.hpp>
+
+#include "Terrain.hpp"
+#include "TiledHeightmap.hpp"
+
+static_assert(TERRAIN_PATCH_SIZE == TILED_HEIGHTMAP_BLOCK_SIZE, "Leaf nodes take their height ranges from the heightmap blocks");
+
+void Terrain::Load(AssetManager& assets, const std::filesystem::path& heights_path, const std::filesystem::path& texture_path, const glm::vec3& origin, float scale)
+{
+    height_field.SetTransform(origin, scale, scale);
+    texture = assets.GetTexture(texture_path);
+
+    // The pager, height_field and the levels are filled by the worker and must not be read before IsReady()
+    assets.Load([this, heights_path]() -> std::function<void()> {
+        auto load_start = std::chrono::steady_clock::now();
+        auto map = std::make_shared<TiledHeightmap>();
+        if (!map->Open(heights_path)) {
+            std::cerr << "Terrain: No heightmap: " << heights_path << "\n";
+            return nullptr;
+        }
+
+        // Every sample is a vertex of the finest level
+        pager.Open(map);
+        height_field.Attach(&pager);
+        BuildLevels();
+
+        std::chrono::duration<double> load_seconds = std::chrono::steady_clock::now() - load_start;
+        std::cout << "Terrain: Loaded " << heights_path << " (" << map->Width() << "x" << map->Depth() << " samples, "
+            << map->TilesX() * map->TilesZ() << " tiles, " << pager.SlotCount() << " resident at most, "
+            << levels.size() << " levels in " << load_seconds.count() * 1000.0 << " ms)\n";
+        return [this]() { Upload(); };
+    });
+}
+
+bool Terrain::IsReady() const
+{
+    return heights_ready && texture && texture->ready;
+}
+
+void Terrain::BuildLevels()
+{
+    const int quads_x = height_field.Width() - 1, quads_z = height_field.Depth() - 1;
+
+    // Enough levels for a single root node to cover the whole map
+    int level_count = 1;
+    while ((TERRAIN_PATCH_SIZE << (level_count - 1)) < std::max(quads_x, quads_z))
+        level_count++;
+
+    levels.assign(level_count, Level());
+    for (int level = 0; level < level_count; level++) {
+        const int node_size = TERRAIN_PATCH_SIZE << level;
+        levels[level].nodes_x = (quads_x + node_size - 1) / node_size;
+        levels[level].nodes_z = (quads_z + node_size - 1) / node_size;
+        levels[level].height_range.resize(static_cast<size_t>(levels[level].nodes_x) * levels[level].nodes_z);
+    }
+
+    // Leaves are the heightmap blocks, their ranges are stored with the map and include the shared edge
+    Level& leaves = levels[0];
+    const TiledHeightmap& map = pager.Map();
+    for (int z = 0; z < leaves.nodes_z; z++) {
+        for (int x = 0; x < leaves.nodes_x; x++) {
+            const uint16_t* range = map.BlockRange(x, z);
+            leaves.height_range[static_cast<size_t>(z) * leaves.nodes_x + x] = glm::vec2(range[0], range[1]) * TILED_HEIGHTMAP_UNIT;
+        }
+    }
+
+    // Parents from their children, nodes past the map edge have no children there
+    for (int level = 1; level < level_count; level++) {
+        const Level& children = levels[level - 1];
+        Level& parents = levels[level];
+        for (int z = 0; z < parents.nodes_z; z++) {
+            for (int x = 0; x < parents.nodes_x; x++) {
+                glm::vec2 range(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+                for (int quadrant = 0; quadrant < 4; quadrant++) {
+                    int child_x = 2 * x + (quadrant & 1), child_z = 2 * z + (quadrant >> 1);
+                    if (child_x >= children.nodes_x || child_z >= children.nodes_z)
+                        continue;
+                    const glm::vec2& child = children.height_range[static_cast<size_t>(child_z) * children.nodes_x + child_x];
+                    range.x = std::min(range.x, child.x);
+                    range.y = std::max(range.y, child.y);
+                }
+                parents.height_range[static_cast<size_t>(z) * parents.nodes_x + x] = range;
+            }
+        }
+    }
+
+    // Each level reaches twice as far as the finer one, the top level is drawn at any distance
+    ranges.resize(level_count);
+    const float leaf_size = TERRAIN_PATCH_SIZE * height_field.Spacing();
+    for (int level = 0; level < level_count; level++)
+        ranges[level] = TERRAIN_LOD_RANGE * leaf_size * static_cast<float>(1 << level);
+    ranges.back() = std::numeric_limits<float>::max();
+}
+
+void Terrain::Upload()
+{
+    const TiledHeightmap& map = pager.Map();
+    const int tile_side = map.TileSize() + 1;
+
+    // Heights are filtered so that vertices between samples follow the surface
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glGenTextures(1, &overview_texture);
+    glBindTexture(GL_TEXTURE_2D, overview_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, map.OverviewWidth(), map.OverviewDepth(), 0, GL_RED, GL_UNSIGNED_SHORT, map.Overview());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Layers are filled by Stream() as tiles arrive
+    glGenTextures(1, &tiles_texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tiles_texture);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R16, tile_side, tile_side, pager.SlotCount());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // No tile is resident yet
+    std::vector<GLshort> no_slots(static_cast<size_t>(map.TilesX()) * map.TilesZ(), -1);
+    glGenTextures(1, &tile_slots_texture);
+    glBindTexture(GL_TEXTURE_2D, tile_slots_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16I, map.TilesX(), map.TilesZ(), 0, GL_RED_INTEGER, GL_SHORT, no_slots.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Patch grid in quads, one index range per quadrant so that a node can draw part of itself
+    //   3-----2
+    //   |    /|
+    //   |  /  |
+    //   |/    |
+    //   0-----1   021, 032, the same diagonal as HeightField
+    const int side = TERRAIN_PATCH_SIZE + 1, half = TERRAIN_PATCH_SIZE / 2;
+    std::vector<glm::vec2> grid;
+    grid.reserve(static_cast<size_t>(side) * side);
+    for (int j = 0; j < side; j++)
+        for (int i = 0; i < side; i++)
+            grid.emplace_back(static_cast<float>(i), static_cast<float>(j));
+
+    std::vector<GLushort> indices;
+    indices.reserve(static_cast<size_t>(TERRAIN_PATCH_SIZE) * TERRAIN_PATCH_SIZE * 6);
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+        for (int j = 0; j < half; j++) {
+            for (int i = 0; i < half; i++) {
+                int column = (quadrant & 1) * half + i, row = (quadrant >> 1) * half + j;
+                GLushort v0 = static_cast<GLushort>(row * side + column);
+                GLushort v1 = static_cast<GLushort>(v0 + 1);
+                GLushort v2 = static_cast<GLushort>(v0 + side + 1);
+                GLushort v3 = static_cast<GLushort>(v0 + side);
+                indices.insert(indices.end(), { v0, v2, v1, v0, v3, v2 });
+            }
+        }
+    }
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, grid.size() * sizeof(glm::vec2), grid.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), reinterpret_cast<void*>(0));
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    // Tessellation patches in samples, corners (x0, z0), (x1, z0), (x1, z1), (x0, z1); the last row and column end at the map edge
+    const int quads_x = height_field.Width() - 1, quads_z = height_field.Depth() - 1;
+    std::vector<glm::vec2> patches;
+    for (int z0 = 0; z0 < quads_z; z0 += TERRAIN_TESSELLATION_PATCH_SIZE) {
+        for (int x0 = 0; x0 < quads_x; x0 += TERRAIN_TESSELLATION_PATCH_SIZE) {
+            float x1 = static_cast<float>(std::min(x0 + TERRAIN_TESSELLATION_PATCH_SIZE, quads_x));
+            float z1 = static_cast<float>(std::min(z0 + TERRAIN_TESSELLATION_PATCH_SIZE, quads_z));
+            patches.emplace_back(static_cast<float>(x0), static_cast<float>(z0));
+            patches.emplace_back(x1, static_cast<float>(z0));
+            patches.emplace_back(x1, z1);
+            patches.emplace_back(static_cast<float>(x0), z1);
+        }
+    }
+    patch_vertex_count = static_cast<GLsizei>(patches.size());
+
+    glGenVertexArrays(1, &patch_VAO);
+    glGenBuffers(1, &patch_VBO);
+    glBindVertexArray(patch_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, patch_VBO);
+    glBufferData(GL_ARRAY_BUFFER, patches.size() * sizeof(glm::vec2), patches.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), reinterpret_cast<void*>(0));
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    heights_ready = true;
+}
+
+void Terrain::NodeBounds(int level, int x, int z, glm::vec3& aabb_min, glm::vec3& aabb_max) const
+{
+    const Level& nodes = levels[level];
+    const glm::vec2& height_range = nodes.height_range[static_cast<size_t>(z) * nodes.nodes_x + x];
+    const int node_size = TERRAIN_PATCH_SIZE << level;
+    const int column_end = std::min((x + 1) * node_size, height_field.Width() - 1);
+    const int row_end = std::min((z + 1) * node_size, height_field.Depth() - 1);
+
+    const glm::vec3 origin = height_field.Origin();
+    const float spacing = height_field.Spacing(), height_scale = height_field.HeightScale();
+    aabb_min = origin + glm::vec3(x * node_size * spacing, height_range.x * height_scale, z * node_size * spacing);
+    aabb_max = origin + glm::vec3(column_end * spacing, height_range.y * height_scale, row_end * spacing);
+}
+
+bool Terrain::IntersectsRange(const glm::vec3& aabb_min, const glm::vec3& aabb_max, float range) const
+{
+    glm::vec3 closest = glm::clamp(camera_position, aabb_min, aabb_max);
+    glm::vec3 offset = closest - camera_position;
+    return glm::dot(offset, offset) <= range * range;
+}
+
+bool Terrain::SelectNode(int level, int x, int z)
+{
+    glm::vec3 aabb_min, aabb_max;
+    NodeBounds(level, x, z, aabb_min, aabb_max);
+    if (!IntersectsRange(aabb_min, aabb_max, ranges[level]))
+        return false;
+    // Culled nodes count as handled, the parent must not draw them either
+    if (!frustum.IntersectsAabb(aabb_min, aabb_max))
+        return true;
+
+    // Quadrants over the map, a node at the edge may stick out on one side
+    unsigned existing = 0xF;
+    if (level > 0) {
+        const Level& children = levels[level - 1];
+        existing = 0;
+        for (int quadrant = 0; quadrant < 4; quadrant++) {
+            if (2 * x + (quadrant & 1) < children.nodes_x && 2 * z + (quadrant >> 1) < children.nodes_z)
+                existing |= 1u << quadrant;
+        }
+    }
+
+    // Entirely beyond the finer level's range, the whole node is drawn at this level
+    if (level == 0 || !IntersectsRange(aabb_min, aabb_max, ranges[level - 1])) {
+        selection.push_back({ level, x, z, existing });
+        return true;
+    }
+
+    // Otherwise children within their range are refined, this node draws the quarters of the others
+    unsigned quadrants = 0;
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+        if (!(existing & (1u << quadrant)))
+            continue;
+        int child_x = 2 * x + (quadrant & 1), child_z = 2 * z + (quadrant >> 1);
+        if (!SelectNode(level - 1, child_x, child_z)) {
+            glm::vec3 child_min, child_max;
+            NodeBounds(level - 1, child_x, child_z, child_min, child_max);
+            if (frustum.IntersectsAabb(child_min, child_max))
+                quadrants |= 1u << quadrant;
+        }
+    }
+    if (quadrants)
+        selection.push_back({ level, x, z, quadrants });
+    return true;
+}
+
+void Terrain::Stream(const glm::vec3& camera_position)
+{
+    if (!IsReady())
+        return;
+
+    tile_events.clear();
+    const glm::vec3 origin = height_field.Origin();
+    pager.Update((camera_position.x - origin.x) / height_field.Spacing(), (camera_position.z - origin.z) / height_field.Spacing(), tile_events);
+    if (tile_events.empty())
+        return;
+
+    // A few tiles per frame at most, bounded by the pager's loads in flight
+    const int side = pager.Map().TileSize() + 1;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    for (const auto& event : tile_events) {
+        GLshort slot = -1;
+        if (event.samples) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, tiles_texture);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, event.slot, side, side, 1, GL_RED, GL_UNSIGNED_SHORT, event.samples);
+            slot = static_cast<GLshort>(event.slot);
+        }
+        glBindTexture(GL_TEXTURE_2D, tile_slots_texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, event.tile_x, event.tile_z, 1, 1, GL_RED_INTEGER, GL_SHORT, &slot);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Terrain::Update(const glm::vec3& camera_position, const glm::mat4& view_projection)
+{
+    selection.clear();
+    if (!IsReady() || levels.empty())
+        return;
+
+    this->camera_position = camera_position;
+    frustum = Frustum(view_projection);
+    const int top = static_cast<int>(levels.size()) - 1;
+    SelectNode(top, 0, 0);
+}
+
+size_t Terrain::DrawnTriangles() const
+{
+    size_t quadrant_count = 0;
+    for (const auto& node : selection) {
+        for (int quadrant = 0; quadrant < 4; quadrant++)
+            quadrant_count += (node.quadrants >> quadrant) & 1;
+    }
+    return quadrant_count * quadrant_index_count / 3;
+}
+
+const char* TerrainRendererName(TerrainRenderer renderer)
+{
+    switch (renderer) {
+    case TerrainRenderer::Cdlod: return "CDLOD";
+    case TerrainRenderer::Tessellation: return "tessellation";
+    }
+    return "unknown";
+}
+
+void Terrain::BindHeightMap(ShaderProgram& shader)
+{
+    // Atlas on unit 0 as for the other objects, heights on units 1 to 3
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, overview_texture);
+    shader.SetUniform("u_height_overview", 1);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tiles_texture);
+    shader.SetUniform("u_height_tiles", 2);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, tile_slots_texture);
+    shader.SetUniform("u_tile_slots", 3);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    shader.SetUniform("u_material.textura", 0);
+
+    // Model space is in samples, x and z along the image and y the sample value
+    glm::mat4 mx_model = glm::translate(glm::mat4(1.0f), height_field.Origin());
+    mx_model = glm::scale(mx_model, glm::vec3(height_field.Spacing(), height_field.HeightScale(), height_field.Spacing()));
+    shader.SetUniform("u_mx_model", mx_model);
+    shader.SetUniform("u_terrain", 1);
+    shader.SetUniform("u_height_map_size", glm::vec2(static_cast<float>(height_field.Width()), static_cast<float>(height_field.Depth())));
+    shader.SetUniform("u_tile_size", static_cast<float>(pager.Map().TileSize()));
+    shader.SetUniform("u_overview_step", static_cast<float>(pager.Map().OverviewStep()));
+}
+
+void Terrain::Draw(ShaderProgram& shader)
+{
+    if (!IsReady() || selection.empty())
+        return;
+
+    BindHeightMap(shader);
+    glBindVertexArray(VAO);
+    for (const auto& node : selection) {
+        // Vertices morph into the coarser grid between the start of the morph zone and the end of the level's range
+        const float range_end = ranges[node.level];
+        const float range_begin = node.level > 0 ? ranges[node.level - 1] : 0.0f;
+        const float morph_start = range_begin + (range_end - range_begin) * TERRAIN_MORPH_START;
+
+        const float quad_size = static_cast<float>(1 << node.level);
+        shader.SetUniform("u_node_origin", glm::vec2(static_cast<float>(node.x), static_cast<float>(node.z)) * (TERRAIN_PATCH_SIZE * quad_size));
+        shader.SetUniform("u_node_scale", quad_size);
+        shader.SetUniform("u_morph_range", glm::vec2(morph_start, range_end));
+
+        if (node.quadrants == 0xF) {
+            glDrawElements(GL_TRIANGLES, 4 * quadrant_index_count, GL_UNSIGNED_SHORT, reinterpret_cast<void*>(0));
+            continue;
+        }
+        for (int quadrant = 0; quadrant < 4; quadrant++) {
+            if (node.quadrants & (1u << quadrant)) {
+                glDrawElements(GL_TRIANGLES, quadrant_index_count, GL_UNSIGNED_SHORT,
+                    reinterpret_cast<void*>(quadrant * quadrant_index_count * sizeof(GLushort)));
+            }
+        }
+    }
+    glBindVertexArray(0);
+}
+
+void Terrain::DrawTessellated(ShaderProgram& shader, float projection_scale)
+{
+    if (!IsReady() || patch_vertex_count == 0)
+        return;
+
+    BindHeightMap(shader);
+    // Patches are culled against the whole terrain's height range
+    shader.SetUniform("u_height_range", levels.back().height_range[0]);
+    shader.SetUniform("u_tessellation_scale", projection_scale / TERRAIN_TESSELLATION_EDGE_PIXELS);
+
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+    glBindVertexArray(patch_VAO);
+    glDrawArrays(GL_PATCHES, 0, patch_vertex_count);
+    glBindVertexArray(0);
+}
+
+void Terrain::Clear()
+{
+    selection.clear();
+    texture.reset();
+    heights_ready = false;
+
+    glDeleteTextures(1, &overview_texture);
+    glDeleteTextures(1, &tiles_texture);
+    glDeleteTextures(1, &tile_slots_texture);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &patch_VBO);
+    glDeleteVertexArrays(1, &patch_VAO);
+    overview_texture = 0;
+    tiles_texture = 0;
+    tile_slots_texture = 0;
+    patch_VBO = 0;
+    patch_VAO = 0;
+    patch_vertex_count = 0;
+    VBO = 0;
+    EBO = 0;
+    VAO = 0;
+}
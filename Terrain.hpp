@@ -0,0 +1,123 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "AssetManager.hpp"
+#include "Frustum.hpp"
+#include "HeightField.hpp"
+#include "HeightmapPager.hpp"
+#include "ShaderProgram.hpp"
+
+constexpr int TERRAIN_PATCH_SIZE = 32; // Grid quads along a node side, every node draws the same patch
+constexpr float TERRAIN_LOD_RANGE = 4.0f; // View range of the finest level in leaf node sizes, doubles per level
+constexpr float TERRAIN_MORPH_START = 0.66f; // Part of a level's range (beyond the finer one) before vertices start morphing
+constexpr int TERRAIN_TESSELLATION_PATCH_SIZE = 64; // Samples along a tessellation patch side, the largest level gives one per quad
+constexpr float TERRAIN_TESSELLATION_EDGE_PIXELS = 8.0f; // Projected length of a tessellated edge on screen
+
+// Terrain renderers, see Terrain
+enum class TerrainRenderer {
+    Cdlod,          // Quadtree of grid patches, terrain.vert
+    Tessellation    // Coarse patches refined on the GPU, terrain_tess.vert, terrain.tesc and terrain.tese
+};
+const char* TerrainRendererName(TerrainRenderer renderer);
+
+// Where a ray first meets the terrain surface, see Terrain::Raycast()
+struct TerrainHit {
+    glm::vec3 position{ 0.0f };
+    glm::vec3 normal{ 0.0f, 1.0f, 0.0f }; // Of the hit triangle, facing up
+    float distance = 0.0f; // From the ray origin
+};
+
+// Heightmap terrain at full resolution with continuous distance-dependent LOD (CDLOD)
+//
+// Heights come from a TiledHeightmap: the tiles around the camera are paged in by a HeightmapPager
+// and copied into a texture array as they arrive, the rest of the map is drawn from a coarse
+// overview. Collision samples go through the same pager.
+//
+// The height field is split into a quadtree of square nodes with their height ranges. Every frame
+// nodes are selected by distance to the camera and culled against the view frustum. Each selected
+// node draws the same grid patch scaled to its size, heights are read from a texture in
+// terrain.vert. Over the outer part of a level's range its vertices morph into the next coarser
+// grid, so neighboring levels meet without cracks and switching levels does not pop.
+//
+// Alternatively DrawTessellated() draws one quad patch per TERRAIN_TESSELLATION_PATCH_SIZE samples
+// and lets the tessellator refine it by projected edge length. Both read the heights through
+// terrain_height.glsl.
+class Terrain
+{
+public:
+    Terrain() = default;
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+
+    // Opens the heightmap in the background, converting it to a TiledHeightmap when needed
+    // Sample (column, row) is placed at origin + (column, height, row) * scale, the terrain must outlive the load
+    void Load(AssetManager& assets, const std::filesystem::path& heights_path, const std::filesystem::path& texture_path, const glm::vec3& origin, float scale);
+    bool IsReady() const; // Heights and texture have been uploaded
+    void Clear(); // Releases the GL objects
+
+    // Pages tiles in and out around the camera and uploads the ones that arrived, once per frame with either renderer
+    void Stream(const glm::vec3& camera_position);
+    // Selects the nodes drawn next, view_projection is used for culling
+    void Update(const glm::vec3& camera_position, const glm::mat4& view_projection);
+    void Draw(ShaderProgram& shader); // terrain.vert with shader.frag, camera and light uniforms already set
+    // Same with the tessellation shaders, projection_scale = viewport height / (2 * tan(fov / 2))
+    void DrawTessellated(ShaderProgram& shader, float projection_scale);
+
+    // First hit of the ray within max_distance on the triangles of the full detail mesh, false when none or not ready
+    // Walks the node height ranges as a min/max pyramid, see TerrainRaycast.cpp
+    bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, TerrainHit& hit) const;
+    bool Segment(const glm::vec3& from, const glm::vec3& to, TerrainHit& hit) const; // Same between two points
+
+    size_t DrawnNodes() const { return selection.size(); }
+    size_t DrawnTriangles() const; // Of the current selection
+    int ResidentTiles() const { return pager.ResidentCount(); }
+    int TileSlots() const { return pager.SlotCount(); }
+
+    HeightField height_field; // Full resolution heights through the pager, valid once ready
+
+private:
+    // Node rectangle drawn at a level, all of it or some of its quadrants
+    struct SelectedNode {
+        int level;
+        int x, z; // Node index within the level
+        unsigned quadrants; // Bit 0..3: (0,0), (1,0), (0,1), (1,1) quarter
+    };
+
+    // Height range of the nodes per level, level 0 holds the leaves; also the min/max pyramid of the raycasts
+    struct Level {
+        int nodes_x = 0, nodes_z = 0;
+        std::vector<glm::vec2> height_range; // Minimum and maximum sample, nodes_z rows of nodes_x
+    };
+    std::vector<Level> levels;
+    std::vector<float> ranges; // Selection range per level in world units, the top level reaches everything
+
+    std::vector<SelectedNode> selection;
+    glm::vec3 camera_position{ 0.0f };
+    Frustum frustum;
+
+    HeightmapPager pager; // Opened by the loader
+    std::vector<HeightmapPager::Event> tile_events;
+
+    std::shared_ptr<TextureAsset> texture;
+    bool heights_ready = false; // Set on the GL thread once the height textures are created
+    GLuint overview_texture{ 0 }; // R16, the TiledHeightmap overview
+    GLuint tiles_texture{ 0 }; // R16 array, one layer per pager slot
+    GLuint tile_slots_texture{ 0 }; // R16I, layer of each tile or -1
+    GLuint VAO{ 0 }, VBO{ 0 }, EBO{ 0 }; // Patch grid, indices ordered by quadrant
+    GLuint patch_VAO{ 0 }, patch_VBO{ 0 }; // Tessellation patches, four corners each
+    GLsizei patch_vertex_count{ 0 };
+    static constexpr GLsizei quadrant_index_count = TERRAIN_PATCH_SIZE * TERRAIN_PATCH_SIZE / 4 * 6; // Indices of one patch quadrant
+
+    void BuildLevels(); // Worker, after the pager is opened
+    void Upload(); // GL thread
+    void BindHeightMap(ShaderProgram& shader); // Textures and uniforms common to both renderers
+    void NodeBounds(int level, int x, int z, glm::vec3& aabb_min, glm::vec3& aabb_max) const; // World space
+    bool IntersectsRange(const glm::vec3& aabb_min, const glm::vec3& aabb_max, float range) const;
+    bool SelectNode(int level, int x, int z); // false when the node is beyond its level's range
+};
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Terrain.hpp"
+
+// Terrain ray queries
+//
+// The ray is traced in sample space (x and z in quads, y in sample values) through the node
+// height ranges, which form a min/max pyramid: level 0 cells are leaf nodes, every level above
+// doubles the cell size up to the single root. Starting at the root, the ray steps from cell to
+// cell of the current level with a 2D DDA. A cell whose height range the ray passes above or below
+// is skipped whole and the walk continues one level up, otherwise it descends into the cell. In a
+// leaf the ray walks the quads and intersects their two triangles, so the hit is exact.
+
+namespace {
+
+constexpr float NO_HIT = std::numeric_limits<float>::max();
+constexpr float HEIGHT_EPSILON = 1e-4f; // Sample values, pads the height range tests against rounding
+
+// Ray parameter of the hit with triangle (a, b, c) from either side, NO_HIT when missed (Moller-Trumbore)
+float IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    // Slightly widened, rays through a shared edge must not slip between the triangles
+    constexpr float edge_tolerance = 1e-6f;
+    const glm::vec3 edge1 = b - a, edge2 = c - a;
+    const glm::vec3 p = glm::cross(direction, edge2);
+    const float determinant = glm::dot(edge1, p);
+    if (std::fabs(determinant) < 1e-12f)
+        return NO_HIT;
+
+    const float inverse = 1.0f / determinant;
+    const glm::vec3 s = origin - a;
+    const float u = glm::dot(s, p) * inverse;
+    if (u < -edge_tolerance || u > 1.0f + edge_tolerance)
+        return NO_HIT;
+    const glm::vec3 q = glm::cross(s, edge1);
+    const float v = glm::dot(direction, q) * inverse;
+    if (v < -edge_tolerance || u + v > 1.0f + edge_tolerance)
+        return NO_HIT;
+    return glm::dot(edge2, q) * inverse;
+}
+
+// Closest hit with the triangles of quad (column, row) while the ray is over it, [t_begin, t_end]
+float IntersectQuad(const HeightField& field, int column, int row, const glm::vec3& origin, const glm::vec3& direction,
+    float t_begin, float t_end, float t_tolerance, glm::vec3& normal)
+{
+    float corners[4];
+    field.QuadCorners(column, row, corners);
+    const float h00 = corners[0], h10 = corners[1], h01 = corners[2], h11 = corners[3];
+
+    // Most quads are passed above or below
+    const float y_begin = origin.y + direction.y * t_begin, y_end = origin.y + direction.y * t_end;
+    if (std::min(y_begin, y_end) > std::max(std::max(h00, h10), std::max(h01, h11)) + HEIGHT_EPSILON ||
+        std::max(y_begin, y_end) < std::min(std::min(h00, h10), std::min(h01, h11)) - HEIGHT_EPSILON)
+        return NO_HIT;
+
+    // Split along the same diagonal as the mesh, see HeightField
+    const float x = static_cast<float>(column), z = static_cast<float>(row);
+    const glm::vec3 p00(x, h00, z), p10(x + 1.0f, h10, z), p01(x, h01, z + 1.0f), p11(x + 1.0f, h11, z + 1.0f);
+    // Only hits while over the quad count, a triangle's plane may well be hit behind the ray origin
+    auto within = [&](float t) { return t >= t_begin - t_tolerance && t <= t_end + t_tolerance ? t : NO_HIT; };
+    const float t_lower = within(IntersectTriangle(origin, direction, p00, p10, p11));
+    const float t_upper = within(IntersectTriangle(origin, direction, p00, p11, p01));
+    const float t = std::min(t_lower, t_upper);
+    if (t == NO_HIT)
+        return NO_HIT;
+
+    normal = t_lower <= t_upper ? glm::cross(p11 - p00, p10 - p00) : glm::cross(p01 - p00, p11 - p00);
+    return t;
+}
+
+// Ray parameter where the ray leaves the cell [low, high] along one axis, infinite when parallel to it
+float AxisExit(float origin, float direction, float low, float high)
+{
+    if (direction > 0.0f)
+        return (high - origin) / direction;
+    if (direction < 0.0f)
+        return (low - origin) / direction;
+    return NO_HIT;
+}
+
+} // namespace
+
+bool Terrain::Raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, TerrainHit& hit) const
+{
+    const float length = glm::length(direction);
+    if (!IsReady() || levels.empty() || !(max_distance > 0.0f) || length == 0.0f)
+        return false;
+
+    // The ray parameter stays the world distance, only the direction is scaled
+    const glm::vec3 scale(height_field.Spacing(), height_field.HeightScale(), height_field.Spacing());
+    const glm::vec3 ray_origin = (origin - height_field.Origin()) / scale;
+    const glm::vec3 ray_direction = direction / length / scale;
+
+    // Clip to the box of the whole map
+    const int quads_x = height_field.Width() - 1, quads_z = height_field.Depth() - 1;
+    const glm::vec2 root_range = levels.back().height_range[0];
+    const glm::vec3 box_min(0.0f, root_range.x - HEIGHT_EPSILON, 0.0f);
+    const glm::vec3 box_max(static_cast<float>(quads_x), root_range.y + HEIGHT_EPSILON, static_cast<float>(quads_z));
+    float t_begin = 0.0f, t_end = max_distance;
+    for (int axis = 0; axis < 3; axis++) {
+        if (ray_direction[axis] == 0.0f) {
+            if (ray_origin[axis] < box_min[axis] || ray_origin[axis] > box_max[axis])
+                return false;
+            continue;
+        }
+        float t0 = (box_min[axis] - ray_origin[axis]) / ray_direction[axis];
+        float t1 = (box_max[axis] - ray_origin[axis]) / ray_direction[axis];
+        t_begin = std::max(t_begin, std::min(t0, t1));
+        t_end = std::min(t_end, std::max(t0, t1));
+    }
+    if (t_begin > t_end)
+        return false;
+
+    // Cells are looked up a little past the current position, so that a boundary belongs to the cell ahead
+    const float horizontal = std::max(std::fabs(ray_direction.x), std::fabs(ray_direction.z));
+    const float t_nudge = horizontal > 0.0f ? 1e-4f / horizontal : 0.0f;
+
+    const int top = static_cast<int>(levels.size()) - 1;
+    int level = top;
+    float t = t_begin;
+    while (true) {
+        const Level& nodes = levels[level];
+        const int cell_size = TERRAIN_PATCH_SIZE << level;
+        const glm::vec3 probe = ray_origin + ray_direction * std::min(t + t_nudge, t_end);
+        const int x = std::clamp(static_cast<int>(std::floor(probe.x / cell_size)), 0, nodes.nodes_x - 1);
+        const int z = std::clamp(static_cast<int>(std::floor(probe.z / cell_size)), 0, nodes.nodes_z - 1);
+
+        float t_exit = std::min({ t_end,
+            AxisExit(ray_origin.x, ray_direction.x, static_cast<float>(x * cell_size), static_cast<float>((x + 1) * cell_size)),
+            AxisExit(ray_origin.z, ray_direction.z, static_cast<float>(z * cell_size), static_cast<float>((z + 1) * cell_size)) });
+        t_exit = std::max(t_exit, std::min(t + t_nudge, t_end));
+
+        const glm::vec2& range = nodes.height_range[static_cast<size_t>(z) * nodes.nodes_x + x];
+        const float y_enter = ray_origin.y + ray_direction.y * t, y_exit = ray_origin.y + ray_direction.y * t_exit;
+        const bool passes = std::min(y_enter, y_exit) > range.y + HEIGHT_EPSILON || std::max(y_enter, y_exit) < range.x - HEIGHT_EPSILON;
+
+        if (!passes && level > 0) {
+            level--;
+            continue;
+        }
+
+        if (!passes) {
+            // Leaf, walk its quads front to back
+            const int column_begin = x * TERRAIN_PATCH_SIZE, column_end = std::min(column_begin + TERRAIN_PATCH_SIZE, quads_x);
+            const int row_begin = z * TERRAIN_PATCH_SIZE, row_end = std::min(row_begin + TERRAIN_PATCH_SIZE, quads_z);
+            int column = std::clamp(static_cast<int>(std::floor(probe.x)), column_begin, column_end - 1);
+            int row = std::clamp(static_cast<int>(std::floor(probe.z)), row_begin, row_end - 1);
+            const int step_x = ray_direction.x > 0.0f ? 1 : -1, step_z = ray_direction.z > 0.0f ? 1 : -1;
+            float t_next_x = AxisExit(ray_origin.x, ray_direction.x, static_cast<float>(column), static_cast<float>(column + 1));
+            float t_next_z = AxisExit(ray_origin.z, ray_direction.z, static_cast<float>(row), static_cast<float>(row + 1));
+            const float t_delta_x = ray_direction.x != 0.0f ? 1.0f / std::fabs(ray_direction.x) : NO_HIT;
+            const float t_delta_z = ray_direction.z != 0.0f ? 1.0f / std::fabs(ray_direction.z) : NO_HIT;
+
+            float t_quad = t;
+            while (true) {
+                const float t_quad_end = std::min({ t_next_x, t_next_z, t_exit });
+                glm::vec3 normal;
+                const float t_hit = IntersectQuad(height_field, column, row, ray_origin, ray_direction, t_quad, t_quad_end, t_nudge, normal);
+                if (t_hit != NO_HIT && t_hit >= 0.0f && t_hit <= max_distance) {
+                    // Back to world space, normals transform with the inverse scale
+                    hit.distance = t_hit;
+                    hit.position = origin + direction / length * t_hit;
+                    hit.normal = glm::normalize(normal / scale);
+                    if (hit.normal.y < 0.0f)
+                        hit.normal = -hit.normal;
+                    return true;
+                }
+                if (t_quad_end >= t_exit)
+                    break;
+                if (t_next_x < t_next_z) {
+                    column += step_x;
+                    t_next_x += t_delta_x;
+                }
+                else {
+                    row += step_z;
+                    t_next_z += t_delta_z;
+                }
+                if (column < column_begin || column >= column_end || row < row_begin || row >= row_end)
+                    break;
+                t_quad = t_quad_end;
+            }
+        }
+
+        // Nothing hit in this cell, continue behind it a level up
+        if (t_exit >= t_end)
+            return false;
+        t = t_exit;
+        level = std::min(level + 1, top);
+    }
+}
+
+bool Terrain::Segment(const glm::vec3& from, const glm::vec3& to, TerrainHit& hit) const
+{
+    return Raycast(from, to - from, glm::length(to - from), hit);
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned int thread_count)
+{
+    thread_count = std::max(thread_count, 1u);
+    workers.reserve(thread_count);
+    for (unsigned int i = 0; i < thread_count; i++) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        stopping = true;
+    }
+    tasks_condition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        tasks.push(std::move(packaged));
+    }
+    tasks_condition.notify_one();
+    return result;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex);
+            tasks_condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+    if (count == 0)
+        return;
+    if (count == 1) {
+        body(0);
+        return;
+    }
+
+    // Shared by the helper tasks, which may still be queued after this call has returned
+    struct State {
+        std::function<void(size_t)> body;
+        size_t count = 0;
+        std::atomic<size_t> next_index{ 0 };
+        std::atomic<size_t> finished{ 0 };
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<State>();
+    state->body = body;
+    state->count = count;
+
+    auto run_indices = [](State& s) {
+        size_t i;
+        while ((i = s.next_index.fetch_add(1)) < s.count) {
+            try {
+                s.body(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                if (!s.error)
+                    s.error = std::current_exception();
+            }
+            if (s.finished.fetch_add(1) + 1 == s.count) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.done.notify_all();
+            }
+        }
+    };
+
+    size_t helper_count = std::min<size_t>(workers.size(), count - 1);
+    for (size_t h = 0; h < helper_count; h++) {
+        Submit([state, run_indices] { run_indices(*state); });
+    }
+
+    run_indices(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&] { return state->finished.load() == state->count; });
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
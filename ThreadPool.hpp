@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads executing queued tasks
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int thread_count = std::thread::hardware_concurrency()); // Constructor, at least one worker
+    ~ThreadPool(); // Finishes queued tasks and joins the workers
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::future<void> Submit(std::function<void()> task); // Queues a task, the future reports completion and exceptions
+
+    // Runs body(i) for i in [0, count) on the workers and the calling thread, returns when all are done
+    // Safe to call from inside a worker task: the caller keeps claiming indices itself instead of only waiting
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    unsigned int ThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+
+    static ThreadPool& Shared(); // Pool shared by the loaders, sized to the hardware
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::packaged_task<void()>> tasks;
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_condition;
+    bool stopping = false;
+
+    void WorkerLoop();
+};
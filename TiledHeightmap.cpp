@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "TiledHeightmap.hpp"
+
+namespace {
+
+int64_t SourceModificationTime(const std::filesystem::path& source_path, std::error_code& error)
+{
+    auto time = std::filesystem::last_write_time(source_path, error);
+    return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+// Cells of size samples - 1 quads, the last one may be partial
+int CellCount(int samples, int size)
+{
+    return (samples - 1 + size - 1) / size;
+}
+
+bool IsRawSource(const std::filesystem::path& path)
+{
+    const auto extension = path.extension();
+    return extension == ".r16" || extension == ".raw";
+}
+
+// Writes the tiled file for a source of width x depth samples, fetch(column, row) returns a raw sample
+template <typename Fetch>
+bool WriteTiledFile(const std::filesystem::path& tiled_path, TiledHeightmapHeader header, const Fetch& fetch)
+{
+    const int width = static_cast<int>(header.width), depth = static_cast<int>(header.depth);
+    const int tile_size = TILED_HEIGHTMAP_TILE_SIZE, block_size = TILED_HEIGHTMAP_BLOCK_SIZE, step = TILED_HEIGHTMAP_OVERVIEW_STEP;
+    const int tiles_x = CellCount(width, tile_size), tiles_z = CellCount(depth, tile_size);
+    const int blocks_x = CellCount(width, block_size), blocks_z = CellCount(depth, block_size);
+    const int overview_width = CellCount(width, step) + 1, overview_depth = CellCount(depth, step) + 1;
+
+    std::vector<uint16_t> ranges(static_cast<size_t>(blocks_x) * blocks_z * 2);
+    for (int block_z = 0; block_z < blocks_z; block_z++) {
+        const int row_end = std::min((block_z + 1) * block_size, depth - 1);
+        for (int block_x = 0; block_x < blocks_x; block_x++) {
+            const int column_end = std::min((block_x + 1) * block_size, width - 1);
+            uint16_t low = 0xFFFF, high = 0;
+            for (int row = block_z * block_size; row <= row_end; row++) {
+                for (int column = block_x * block_size; column <= column_end; column++) {
+                    uint16_t sample = fetch(column, row);
+                    low = std::min(low, sample);
+                    high = std::max(high, sample);
+                }
+            }
+            uint16_t* range = &ranges[(static_cast<size_t>(block_z) * blocks_x + block_x) * 2];
+            range[0] = low;
+            range[1] = high;
+        }
+    }
+
+    std::vector<uint16_t> overview(static_cast<size_t>(overview_width) * overview_depth);
+    for (int z = 0; z < overview_depth; z++)
+        for (int x = 0; x < overview_width; x++)
+            overview[static_cast<size_t>(z) * overview_width + x] = fetch(std::min(x * step, width - 1), std::min(z * step, depth - 1));
+
+    const auto temp_path = std::filesystem::path(tiled_path).concat(".tmp");
+    {
+        std::ofstream tiled_file(temp_path, std::ios::binary | std::ios::trunc);
+        tiled_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        tiled_file.write(reinterpret_cast<const char*>(ranges.data()), ranges.size() * sizeof(uint16_t));
+        tiled_file.write(reinterpret_cast<const char*>(overview.data()), overview.size() * sizeof(uint16_t));
+
+        // One tile in memory at a time
+        const int side = tile_size + 1;
+        std::vector<uint16_t> tile(static_cast<size_t>(side) * side);
+        for (int tile_z = 0; tile_z < tiles_z && tiled_file; tile_z++) {
+            for (int tile_x = 0; tile_x < tiles_x; tile_x++) {
+                for (int j = 0; j < side; j++) {
+                    const int row = std::min(tile_z * tile_size + j, depth - 1);
+                    for (int i = 0; i < side; i++)
+                        tile[static_cast<size_t>(j) * side + i] = fetch(std::min(tile_x * tile_size + i, width - 1), row);
+                }
+                tiled_file.write(reinterpret_cast<const char*>(tile.data()), tile.size() * sizeof(uint16_t));
+            }
+        }
+        if (!tiled_file) {
+            std::cerr << "TiledHeightmap: Cannot write: " << temp_path << "\n";
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, tiled_path, error);
+    if (error) {
+        std::cerr << "TiledHeightmap: Cannot replace: " << tiled_path << "\n";
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::filesystem::path TiledHeightmap::TiledPath(const std::filesystem::path& source_path)
+{
+    std::filesystem::path tiled_path = source_path;
+    tiled_path += ".pg2terrain";
+    return tiled_path;
+}
+
+bool TiledHeightmap::Convert(const std::filesystem::path& source_path)
+{
+    auto convert_start = std::chrono::steady_clock::now();
+
+    std::error_code error;
+    TiledHeightmapHeader header{};
+    std::memcpy(header.magic, TILED_HEIGHTMAP_MAGIC, sizeof(header.magic));
+    header.version = TILED_HEIGHTMAP_VERSION;
+    header.tile_size = TILED_HEIGHTMAP_TILE_SIZE;
+    header.block_size = TILED_HEIGHTMAP_BLOCK_SIZE;
+    header.overview_step = TILED_HEIGHTMAP_OVERVIEW_STEP;
+    header.source_size = std::filesystem::file_size(source_path, error);
+    if (!error)
+        header.source_mtime = SourceModificationTime(source_path, error);
+    if (error) {
+        std::cerr << "TiledHeightmap: Cannot stat source: " << source_path << "\n";
+        return false;
+    }
+
+    bool written = false;
+    if (IsRawSource(source_path)) {
+        // Square, the side follows from the size
+        MappedFile source(source_path);
+        const size_t samples = source.Size() / sizeof(uint16_t);
+        const auto side = static_cast<uint32_t>(std::llround(std::sqrt(static_cast<double>(samples))));
+        if (!source.IsOpen() || side < 2 || static_cast<size_t>(side) * side * sizeof(uint16_t) != source.Size()) {
+            std::cerr << "TiledHeightmap: Not a square 16 bit raw heightmap: " << source_path << "\n";
+            return false;
+        }
+        header.width = side;
+        header.depth = side;
+        const auto* bytes = reinterpret_cast<const unsigned char*>(source.Data());
+        written = WriteTiledFile(TiledPath(source_path), header, [bytes, side](int column, int row) {
+            const unsigned char* sample = bytes + (static_cast<size_t>(row) * side + column) * sizeof(uint16_t);
+            return static_cast<uint16_t>(sample[0] | (sample[1] << 8));
+        });
+    }
+    else {
+        cv::Mat image = cv::imread(source_path.u8string(), cv::IMREAD_ANYDEPTH);
+        if (image.empty() || image.cols < 2 || image.rows < 2 || (image.depth() != CV_8U && image.depth() != CV_16U)) {
+            std::cerr << "TiledHeightmap: No 8 or 16 bit grayscale heightmap: " << source_path << "\n";
+            return false;
+        }
+        header.width = static_cast<uint32_t>(image.cols);
+        header.depth = static_cast<uint32_t>(image.rows);
+        if (image.depth() == CV_8U) {
+            written = WriteTiledFile(TiledPath(source_path), header, [&image](int column, int row) {
+                return static_cast<uint16_t>(image.ptr<uchar>(row)[column] << 8);
+            });
+        }
+        else {
+            written = WriteTiledFile(TiledPath(source_path), header, [&image](int column, int row) {
+                return image.ptr<uint16_t>(row)[column];
+            });
+        }
+    }
+
+    if (written) {
+        std::chrono::duration<double> convert_seconds = std::chrono::steady_clock::now() - convert_start;
+        std::cout << "TiledHeightmap: Converted " << source_path << " (" << header.width << "x" << header.depth << " samples in "
+            << convert_seconds.count() * 1000.0 << " ms)\n";
+    }
+    return written;
+}
+
+bool TiledHeightmap::Open(const std::filesystem::path& path)
+{
+    Close();
+    if (path.extension() == ".pg2terrain")
+        return Map(path, nullptr);
+
+    const auto tiled_path = TiledPath(path);
+    if (Map(tiled_path, &path))
+        return true;
+    return Convert(path) && Map(tiled_path, &path);
+}
+
+bool TiledHeightmap::Map(const std::filesystem::path& tiled_path, const std::filesystem::path* source_path)
+{
+    std::error_code error;
+    if (!std::filesystem::exists(tiled_path, error)) {
+        if (!source_path)
+            std::cerr << "TiledHeightmap: No file: " << tiled_path << "\n";
+        return false;
+    }
+
+    MappedFile mapped(tiled_path);
+    if (!mapped.IsOpen() || mapped.Size() < sizeof(TiledHeightmapHeader))
+        return false;
+
+    TiledHeightmapHeader header;
+    std::memcpy(&header, mapped.Data(), sizeof(header));
+    if (std::memcmp(header.magic, TILED_HEIGHTMAP_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TILED_HEIGHTMAP_VERSION ||
+        header.width < 2 || header.depth < 2 || header.width > 0x100000 || header.depth > 0x100000 ||
+        header.block_size != TILED_HEIGHTMAP_BLOCK_SIZE || header.tile_size == 0 || header.tile_size > 0x4000 || header.tile_size % header.block_size != 0 ||
+        header.overview_step == 0) {
+        std::cout << "TiledHeightmap: Rebuilding outdated file: " << tiled_path << "\n";
+        return false;
+    }
+
+    if (source_path) {
+        const uint64_t source_size = std::filesystem::file_size(*source_path, error);
+        const int64_t source_mtime = error ? 0 : SourceModificationTime(*source_path, error);
+        if (error || header.source_size != source_size || header.source_mtime != source_mtime) {
+            std::cout << "TiledHeightmap: Rebuilding stale file: " << tiled_path << "\n";
+            return false;
+        }
+    }
+
+    width = static_cast<int>(header.width);
+    depth = static_cast<int>(header.depth);
+    tile_size = static_cast<int>(header.tile_size);
+    tiles_x = CellCount(width, tile_size);
+    tiles_z = CellCount(depth, tile_size);
+    block_size = static_cast<int>(header.block_size);
+    blocks_x = CellCount(width, block_size);
+    blocks_z = CellCount(depth, block_size);
+    overview_step = static_cast<int>(header.overview_step);
+    overview_width = CellCount(width, overview_step) + 1;
+    overview_depth = CellCount(depth, overview_step) + 1;
+
+    ranges_offset = sizeof(header);
+    overview_offset = ranges_offset + static_cast<size_t>(blocks_x) * blocks_z * 2 * sizeof(uint16_t);
+    tiles_offset = overview_offset + static_cast<size_t>(overview_width) * overview_depth * sizeof(uint16_t);
+    if (mapped.Size() != tiles_offset + static_cast<size_t>(tiles_x) * tiles_z * TileSamples() * sizeof(uint16_t)) {
+        std::cout << "TiledHeightmap: Rebuilding truncated file: " << tiled_path << "\n";
+        width = depth = 0;
+        return false;
+    }
+
+    file = std::move(mapped);
+    return true;
+}
+
+void TiledHeightmap::Close()
+{
+    file.Close();
+    width = depth = 0;
+    tiles_x = tiles_z = blocks_x = blocks_z = 0;
+}
+
+const uint16_t* TiledHeightmap::Tile(int tile_x, int tile_z) const
+{
+    const size_t tile = static_cast<size_t>(tile_z) * tiles_x + tile_x;
+    return reinterpret_cast<const uint16_t*>(file.Data() + tiles_offset) + tile * TileSamples();
+}
+
+const uint16_t* TiledHeightmap::BlockRange(int block_x, int block_z) const
+{
+    return reinterpret_cast<const uint16_t*>(file.Data() + ranges_offset) + (static_cast<size_t>(block_z) * blocks_x + block_x) * 2;
+}
+
+const uint16_t* TiledHeightmap::Overview() const
+{
+    return reinterpret_cast<const uint16_t*>(file.Data() + overview_offset);
+}
+
+uint16_t TiledHeightmap::Sample(int column, int row) const
+{
+    column = std::clamp(column, 0, width - 1);
+    row = std::clamp(row, 0, depth - 1);
+    const int tile_x = std::min(column / tile_size, tiles_x - 1), tile_z = std::min(row / tile_size, tiles_z - 1);
+    const int local_x = column - tile_x * tile_size, local_z = row - tile_z * tile_size;
+    return Tile(tile_x, tile_z)[static_cast<size_t>(local_z) * (tile_size + 1) + local_x];
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "MappedFile.hpp"
+
+// Tiled 16 bit heightmap (.pg2terrain), read through a memory mapping
+//
+// Layout: TiledHeightmapHeader, block ranges, overview, tiles
+// - Samples are unsigned 16 bit, sample value = raw * TILED_HEIGHTMAP_UNIT, so 8 bit images keep their 0..255 range
+// - Block ranges: lowest and highest raw sample of every block of TILED_HEIGHTMAP_BLOCK_SIZE quads, edges included
+// - Overview: every overview_step-th sample in both directions, the last one clamped to the map edge
+// - Tiles: (tile_size + 1)^2 samples each, neighbors share their edge samples, samples past the map edge repeat it
+// All grids are row-major, z rows of x entries.
+//
+// Sources are an image (8 or 16 bit grayscale) or a headerless square .r16/.raw file of little-endian 16 bit
+// samples. Raw sources are read through a mapping too, so maps far larger than memory can be converted.
+// The converted file is stored next to the source and rebuilt when the source size or time changes.
+
+constexpr char TILED_HEIGHTMAP_MAGIC[8] = { 'P', 'G', '2', 'T', 'E', 'R', 'R', '\0' };
+constexpr uint32_t TILED_HEIGHTMAP_VERSION = 1; // Bump whenever the stored data changes
+constexpr int TILED_HEIGHTMAP_TILE_SIZE = 256; // Quads along a tile side
+constexpr int TILED_HEIGHTMAP_BLOCK_SIZE = 32; // Quads along a height range block side, divides the tile size
+constexpr int TILED_HEIGHTMAP_OVERVIEW_STEP = 16; // Samples between two overview samples
+constexpr float TILED_HEIGHTMAP_UNIT = 1.0f / 256.0f; // Sample value of one raw step
+
+struct TiledHeightmapHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width; // Samples along x
+    uint32_t depth; // Samples along z
+    uint32_t tile_size;
+    uint32_t block_size;
+    uint32_t overview_step;
+    uint64_t source_size; // Size of the source file in bytes, 0 for files without a source
+    int64_t source_mtime; // Last write time of the source file, in file clock ticks
+};
+
+class TiledHeightmap
+{
+public:
+    TiledHeightmap() = default;
+    TiledHeightmap(const TiledHeightmap&) = delete;
+    TiledHeightmap& operator=(const TiledHeightmap&) = delete;
+
+    // Maps path when it is a .pg2terrain file, otherwise the converted file of path, converting it first when missing or stale
+    bool Open(const std::filesystem::path& path);
+    void Close();
+
+    static std::filesystem::path TiledPath(const std::filesystem::path& source_path); // e.g. heights.png -> heights.png.pg2terrain
+    static bool Convert(const std::filesystem::path& source_path); // Writes TiledPath(source_path), returns false on errors
+
+    bool IsOpen() const { return file.IsOpen(); }
+    int Width() const { return width; }
+    int Depth() const { return depth; }
+    int TileSize() const { return tile_size; }
+    int TilesX() const { return tiles_x; }
+    int TilesZ() const { return tiles_z; }
+    size_t TileSamples() const { return static_cast<size_t>(tile_size + 1) * (tile_size + 1); }
+    int BlockSize() const { return block_size; }
+    int BlocksX() const { return blocks_x; }
+    int BlocksZ() const { return blocks_z; }
+    int OverviewStep() const { return overview_step; }
+    int OverviewWidth() const { return overview_width; }
+    int OverviewDepth() const { return overview_depth; }
+
+    // Pointers into the mapping, valid while open; safe to read from any thread
+    const uint16_t* Tile(int tile_x, int tile_z) const; // TileSamples() samples, (tile_size + 1) per row
+    const uint16_t* BlockRange(int block_x, int block_z) const; // Lowest and highest raw sample
+    const uint16_t* Overview() const; // OverviewWidth() * OverviewDepth() samples
+
+    // Raw sample straight from the mapped tiles, coordinates clamped to the map
+    uint16_t Sample(int column, int row) const;
+
+private:
+    MappedFile file;
+    int width = 0, depth = 0;
+    int tile_size = 0, tiles_x = 0, tiles_z = 0;
+    int block_size = 0, blocks_x = 0, blocks_z = 0;
+    int overview_step = 0, overview_width = 0, overview_depth = 0;
+    size_t ranges_offset = 0, overview_offset = 0, tiles_offset = 0; // Bytes from the start of the file
+
+    bool Map(const std::filesystem::path& tiled_path, const std::filesystem::path* source_path); // Checks the source when given
+};
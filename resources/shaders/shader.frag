@@ -1,14 +1,16 @@
-#version 460 core
+#version 450 core
 
 // VS -> FS
 in vec3 o_fragment_position;
 in vec3 o_normal;
 in vec2 o_texture_coordinate;
+in float o_local_height;
 
 // CPP -> FS
 uniform vec3 u_camera_position;
 uniform float u_ambient_alpha;
 uniform float u_diffuse_alpha;
+uniform bool u_terrain;          // Heightmap mesh, texture coordinates count grid cells
 
 // FS ->
 out vec4 frag_color;
@@ -23,6 +25,28 @@ struct Material
 };
 uniform Material u_material;
 
+// Surface color, sampled once in main
+vec4 albedo;
+
+// === Terrain ===
+// Every cell repeats one 1/16 atlas tile, chosen by the heightmap value (0..255)
+vec4 terrainAlbedo()
+{
+	float height = o_local_height / 256.0f;
+	vec2 tile;
+	if (height > 0.8f)
+		tile = vec2(1.0f, 4.0f) / 16.0f;
+	else if (height > 0.5f)
+		tile = vec2(7.0f, 1.0f) / 16.0f;
+	else if (height > 0.3f)
+		tile = vec2(4.0f, 1.0f) / 16.0f;
+	else
+		tile = vec2(1.0f, 1.0f) / 16.0f;
+	// fract() jumps at cell borders, explicit gradients keep the mip level continuous
+	vec2 cell_coordinate = o_texture_coordinate / 16.0f;
+	return textureGrad(u_material.textura, tile + fract(o_texture_coordinate) / 16.0f, dFdx(cell_coordinate), dFdy(cell_coordinate));
+}
+
 // === Directional light ===
 struct DirectionalLight
 {
@@ -34,7 +58,7 @@ uniform DirectionalLight u_directional_light;
 vec4 calcDirectionalLightColor(DirectionalLight directional_light, vec3 normal, vec3 frag2camera)
 {
 	vec3 frag2light = normalize(-directional_light.direction);
-    vec4 diffuse = vec4(directional_light.diffuse * max(dot(normal, frag2light), 0.0f), u_diffuse_alpha) * texture(u_material.textura, o_texture_coordinate);
+    vec4 diffuse = vec4(directional_light.diffuse * max(dot(normal, frag2light), 0.0f), u_diffuse_alpha) * albedo;
 	vec3 specular = directional_light.specular * u_material.specular * pow(max(dot(normal, normalize(frag2light + frag2camera)), 0.0f), u_material.shininess);
 	return (diffuse + vec4(specular, 0.0f));
 }
@@ -56,7 +80,7 @@ uniform PointLight u_point_lights[MAX_POINT_LIGHTS];
 vec4 calcPointLightColor(PointLight point_light, vec3 normal, vec3 fragment_position, vec3 frag2camera)
 {
 	vec3 frag2light = normalize(point_light.position - fragment_position);
-    vec4 diffuse = vec4(point_light.diffuse * max(dot(normal, frag2light), 0.0f), u_diffuse_alpha) * texture(u_material.textura, o_texture_coordinate);
+    vec4 diffuse = vec4(point_light.diffuse * max(dot(normal, frag2light), 0.0f), u_diffuse_alpha) * albedo;
 	vec3 specular = point_light.specular * u_material.specular * pow(max(dot(normal, normalize(frag2light + frag2camera)), 0.0f), u_material.shininess);
 	float d = length(point_light.position - fragment_position);
 	float attenuation = 1.0f / (point_light.constant + point_light.linear * d + point_light.exponent * (d * d));
@@ -84,7 +108,7 @@ uniform Spotlight u_spotlight;
 vec4 calcSpotLightColor(Spotlight spotlight, vec3 normal, vec3 fragment_position, vec3 frag2camera)
 {
 	vec3 frag2light = normalize(spotlight.position - fragment_position);
-    vec4 diffuse = vec4(u_spotlight.diffuse * max(dot(normal, frag2light), 0.0f), u_diffuse_alpha) * texture(u_material.textura, o_texture_coordinate);
+    vec4 diffuse = vec4(u_spotlight.diffuse * max(dot(normal, frag2light), 0.0f), u_diffuse_alpha) * albedo;
 	vec3 specular = u_spotlight.specular * u_material.specular * pow(max(dot(normal, normalize(frag2light + frag2camera)), 0.0f), u_material.shininess);
 	float d = length(spotlight.position - fragment_position);
 	float attenuation = 1.0f / (spotlight.constant + spotlight.linear * d + spotlight.exponent * (d * d));
@@ -100,9 +124,10 @@ void main()
 	vec3 normal = normalize(o_normal);
 	vec3 frag2camera = normalize(u_camera_position - o_fragment_position);
 	vec4 out_color = vec4(0.0f);
+	albedo = u_terrain ? terrainAlbedo() : texture(u_material.textura, o_texture_coordinate);
 
 	// Ambient light
-	vec4 ambient = vec4(u_material.ambient, u_ambient_alpha) * texture(u_material.textura, o_texture_coordinate);
+	vec4 ambient = vec4(u_material.ambient, u_ambient_alpha) * albedo;
 
 	// Directional light
 	out_color += calcDirectionalLightColor(u_directional_light, normal, frag2camera);
@@ -1,6 +1,7 @@
-#version 460 core
+#version 450 core
 
 // Vertex attributes
+// Packed layout (Mesh, PackedVertex): position is unorm inside the mesh AABB, normal is octahedral encoded in xy
 layout (location = 0) in vec4 a_position;
 layout (location = 1) in vec3 a_normal;
 layout (location = 2) in vec2 a_texture_coordinate;
@@ -10,19 +11,41 @@ uniform mat4 u_mx_model;         // Object local coor space -> World space
 uniform mat4 u_mx_view;          // World space -> Camera space
 uniform mat4 u_mx_projection;    // Camera space -> Screen
 
+// Vertex decoding
+uniform bool u_packed_vertex;
+uniform vec3 u_position_offset;  // AABB min of the packed mesh
+uniform vec3 u_position_scale;   // AABB size of the packed mesh
+
 // VS -> FS
 out vec3 o_fragment_position;
 out vec3 o_normal;
 out vec2 o_texture_coordinate;
+out float o_local_height;        // Model space height, picks the terrain atlas tile
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
 
 void main()
 {
-    o_fragment_position = vec3(u_mx_model * a_position);
+    vec4 position = a_position;
+    vec3 normal = a_normal;
+    if (u_packed_vertex) {
+        position = vec4(u_position_offset + a_position.xyz * u_position_scale, 1.0);
+        normal = decodeOctahedral(a_normal.xy);
+    }
+
+    o_fragment_position = vec3(u_mx_model * position);
 
     // https://computergraphics.stackexchange.com/questions/1502/why-is-the-transposed-inverse-of-the-model-view-matrix-used-to-transform-the-nor
-    o_normal = mat3(transpose(inverse(u_mx_model))) * a_normal;
+    o_normal = mat3(transpose(inverse(u_mx_model))) * normal;
 
     o_texture_coordinate = a_texture_coordinate;
+    o_local_height = position.y;
 
-    gl_Position = u_mx_projection * u_mx_view * u_mx_model * a_position;
+    gl_Position = u_mx_projection * u_mx_view * u_mx_model * position;
 }
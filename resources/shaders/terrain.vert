@@ -0,0 +1,56 @@
+#version 450 core
+
+// CDLOD terrain, see Terrain.hpp
+// Every node draws the same patch, a grid of quads with integer coordinates
+layout (location = 0) in vec2 a_grid_position;
+
+// Matrices
+uniform mat4 u_mx_model;         // Samples (x, z) and sample values (y) -> World space
+uniform mat4 u_mx_view;          // World space -> Camera space
+uniform mat4 u_mx_projection;    // Camera space -> Screen
+
+// Terrain
+#include "terrain_height.glsl"
+uniform vec2 u_node_origin;      // First sample of the node
+uniform float u_node_scale;      // Samples per patch quad at the node's level
+uniform vec2 u_morph_range;      // Camera distance where morphing to the coarser level starts and ends
+uniform vec3 u_camera_position;
+
+// VS -> FS, as shader.vert
+out vec3 o_fragment_position;
+out vec3 o_normal;
+out vec2 o_texture_coordinate;
+out float o_local_height;
+
+// Samples covered by one repeat of the atlas tile
+const float TEXTURE_TILE_SAMPLES = 5.0;
+
+void main()
+{
+    vec2 sample_position = u_node_origin + a_grid_position * u_node_scale;
+    vec3 world_position = vec3(u_mx_model * vec4(sample_position.x, heightAt(sample_position), sample_position.y, 1.0));
+
+    // Odd grid vertices slide onto their even neighbor, which turns the patch into the coarser grid
+    float morph = clamp((distance(world_position, u_camera_position) - u_morph_range.x) / (u_morph_range.y - u_morph_range.x), 0.0, 1.0);
+    vec2 odd = fract(a_grid_position * 0.5) * 2.0;
+    sample_position -= odd * u_node_scale * morph;
+    // Nodes at the far edge reach past the last sample
+    sample_position = min(sample_position, u_height_map_size - 1.0);
+
+    vec4 position = vec4(sample_position.x, heightAt(sample_position), sample_position.y, 1.0);
+
+    // Central differences over one quad of the node's level
+    float d = u_node_scale;
+    float height_left = heightAt(sample_position - vec2(d, 0.0));
+    float height_right = heightAt(sample_position + vec2(d, 0.0));
+    float height_down = heightAt(sample_position - vec2(0.0, d));
+    float height_up = heightAt(sample_position + vec2(0.0, d));
+    vec3 normal = normalize(vec3(height_left - height_right, 2.0 * d, height_down - height_up));
+
+    o_fragment_position = vec3(u_mx_model * position);
+    o_normal = mat3(transpose(inverse(u_mx_model))) * normal;
+    o_texture_coordinate = sample_position / TEXTURE_TILE_SAMPLES;
+    o_local_height = position.y;
+
+    gl_Position = u_mx_projection * u_mx_view * u_mx_model * position;
+}
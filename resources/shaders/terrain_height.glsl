@@ -0,0 +1,27 @@
+// Streamed terrain heights, see HeightmapPager.hpp
+// Included by the terrain shaders after #version, the uniforms are set by Terrain
+
+uniform sampler2D u_height_overview;    // Every u_overview_step-th sample, 16 bit
+uniform sampler2DArray u_height_tiles;  // Resident tiles, one layer per pager slot of (u_tile_size + 1)^2 samples
+uniform isampler2D u_tile_slots;        // Layer of each tile, -1 while it is not resident
+uniform vec2 u_height_map_size;         // Samples along x and z
+uniform float u_tile_size;              // Quads along a tile side
+uniform float u_overview_step;          // Samples between two overview texels
+
+// Sample value of a full 16 bit texel, one raw step is 1/256
+const float HEIGHT_MAP_RANGE = 65535.0 / 256.0;
+
+float heightAt(vec2 sample_position)
+{
+    sample_position = clamp(sample_position, vec2(0.0), u_height_map_size - 1.0);
+    ivec2 tile = min(ivec2(sample_position / u_tile_size), textureSize(u_tile_slots, 0) - 1);
+    int slot = texelFetch(u_tile_slots, tile, 0).r;
+    if (slot >= 0) {
+        // Tiles repeat their neighbor's edge samples, so filtering never leaves the layer
+        vec2 local = sample_position - vec2(tile) * u_tile_size;
+        return textureLod(u_height_tiles, vec3((local + 0.5) / (u_tile_size + 1.0), float(slot)), 0.0).r * HEIGHT_MAP_RANGE;
+    }
+    // Not streamed in, far away or still loading
+    vec2 overview_size = vec2(textureSize(u_height_overview, 0));
+    return textureLod(u_height_overview, (sample_position / u_overview_step + 0.5) / overview_size, 0.0).r * HEIGHT_MAP_RANGE;
+}
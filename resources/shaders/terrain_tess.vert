@@ -0,0 +1,13 @@
+#version 450 core
+
+// Tessellated terrain, see Terrain.hpp
+// Patch corners in samples, refined and displaced in terrain.tesc and terrain.tese
+layout (location = 0) in vec2 a_patch_position;
+
+// VS -> TCS
+out vec2 o_patch_position;
+
+void main()
+{
+    o_patch_position = a_patch_position;
+}